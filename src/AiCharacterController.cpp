@@ -1,11 +1,12 @@
 #include "stdafx.h"
 #include "AiCharacterController.h"
 #include "AiGangBehavior.h"
+#include "GtaOneGame.h"
 
 AiCharacterController::~AiCharacterController()
 {
     SetCharacter(nullptr);
-    SafeDelete(mAiBehavior);
+    cxx_assert(mAiBehavior == nullptr);
 }
 
 bool AiCharacterController::IsControllerActive() const
@@ -19,18 +20,22 @@ void AiCharacterController::SetCharacter(Pedestrian* character)
         return;
 
     mCtlState.Clear();
+    mSteeringCtlState.Clear();
+    mDeferredCommands.clear();
+    mAccumulatedTime = 0.0f;
     // destroy old ai behavior
     if (mAiBehavior)
     {
         mAiBehavior->ShutdownBehavior();
-        SafeDelete(mAiBehavior);
+        gGame.mAiMng.ReleaseBehavior(mAiBehavior);
+        mAiBehavior = nullptr;
     }
 
     if (mCharacter)
     {
         cxx_assert(mCharacter->mAiController == this);
         mCharacter->mAiController = nullptr;
-        cxx_assert(mCharacter->mCtlState == &mCtlState);
+        cxx_assert(mCharacter->mCtlState == &mSteeringCtlState);
         mCharacter->mCtlState = nullptr;
     }
 
@@ -40,28 +45,82 @@ void AiCharacterController::SetCharacter(Pedestrian* character)
     {
         cxx_assert(mCharacter->mAiController == nullptr);
         mCharacter->mAiController = this;
-        mCharacter->mCtlState = &mCtlState;
+        mCharacter->mCtlState = &mSteeringCtlState;
 
         // create new ai behavior
         if ((mCharacter->mPedestrianType == ePedestrianType_Gang) || 
             (mCharacter->mPedestrianType == ePedestrianType_GangLeader))
         {
-            mAiBehavior = new AiGangBehavior(this);
+            mAiBehavior = gGame.mAiMng.CreateGangBehavior(this);
         }
         if (mAiBehavior == nullptr)
         {
-            mAiBehavior = new AiPedestrianBehavior(this, eAiPedestrianBehavior_Civilian);
+            mAiBehavior = gGame.mAiMng.CreatePedestrianBehavior(this, eAiPedestrianBehavior_Civilian);
         }
         mAiBehavior->ActivateBehavior();
     }
 }
 
+void AiCharacterController::AccumulateTime(float deltaTime)
+{
+    mAccumulatedTime += deltaTime;
+}
+
 void AiCharacterController::UpdateFrame()
 {
+    float deltaTime = mAccumulatedTime;
+    mAccumulatedTime = 0.0f;
+
     if (mAiBehavior)
     {
-        mAiBehavior->UpdateBehavior();
+        mAiBehavior->UpdateBehavior(deltaTime);
+    }
+}
+
+void AiCharacterController::PostUpdateFrame()
+{
+    for (const AiCommand& currCommand: mDeferredCommands)
+    {
+        switch (currCommand.mCommandID)
+        {
+            case eAiCommand_SetLeader:
+                if (mAiBehavior)
+                {
+                    mAiBehavior->SetLeader(currCommand.mPedestrian);
+                }
+            break;
+            case eAiCommand_ResetLeader:
+                if (mAiBehavior)
+                {
+                    mAiBehavior->ResetLeader();
+                }
+            break;
+            case eAiCommand_StopCharacterSound:
+                if (mCharacter)
+                {
+                    mCharacter->StopGameObjectSound(currCommand.mCommandParam);
+                }
+            break;
+            case eAiCommand_RequestPath:
+                gGame.mPathfinder.RequestPath((unsigned int) currCommand.mCommandParam);
+            break;
+            case eAiCommand_RequestFleeField:
+            {
+                Point threatBlock (currCommand.mCommandParam % MAP_DIMENSIONS, currCommand.mCommandParam / MAP_DIMENSIONS);
+                gGame.mFlowFields.RequestField(AiFlowFields::GetFleeFieldKey(threatBlock), threatBlock);
+            }
+            break;
+            case eAiCommand_RequestFollowField:
+                if (currCommand.mPedestrian)
+                {
+                    glm::vec2 leaderPosition = Convert::MetersToMapUnits(currCommand.mPedestrian->mTransform.GetPosition2());
+                    Point leaderBlock ((int) leaderPosition.x, (int) leaderPosition.y);
+                    gGame.mFlowFields.RequestField(AiFlowFields::GetFollowFieldKey(currCommand.mPedestrian->mObjectID), leaderBlock);
+                }
+            break;
+        }
     }
+    mDeferredCommands.clear();
 
     // self detach
     if (mCharacter && mCharacter->IsDead())
@@ -70,6 +129,11 @@ void AiCharacterController::UpdateFrame()
     }
 }
 
+void AiCharacterController::PushCommand(const AiCommand& command)
+{
+    mDeferredCommands.push_back(command);
+}
+
 void AiCharacterController::DebugDraw(DebugRenderer& debugRender)
 {
 }
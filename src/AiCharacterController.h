@@ -9,7 +9,10 @@ public:
     // readonly
     AiPedestrianBehavior* mAiBehavior = nullptr;
     Pedestrian* mCharacter = nullptr; // controllable character
-    PedestrianCtlState mCtlState;
+    PedestrianCtlState mCtlState; // desired actions set by behavior
+    PedestrianCtlState mSteeringCtlState; // actions passed to character, desired actions adjusted by crowd avoidance
+
+    float mAccumulatedTime = 0.0f; // game time passed since previous think, seconds
 
 public:
     AiCharacterController() = default;
@@ -18,9 +21,24 @@ public:
     void SetCharacter(Pedestrian* character);
     bool IsControllerActive() const;
 
+    // Advance controller time, it gets consumed on next think
+    void AccumulateTime(float deltaTime);
+
+    // Think phase, might be executed in parallel with other controllers
+    // Only controller own state can be modified here, other changes must be deferred via commands
     void UpdateFrame();
+
+    // Apply deferred commands, executed serially
+    void PostUpdateFrame();
+
     void DebugDraw(DebugRenderer& debugRender);
 
+    // Queue side effect command to apply after think phase
+    void PushCommand(const AiCommand& command);
+
     // objectives
     void FollowPedestrian(Pedestrian* pedestrian);
+
+private:
+    std::vector<AiCommand> mDeferredCommands;
 };
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "stdafx.h"
+#include "AiCrowdAvoidance.h"
+#include "AiCharacterController.h"
+#include "Pedestrian.h"
+#include "GameObjectHelpers.h"
+#include "GtaOneGame.h"
+#include "cvars.h"
+
+//////////////////////////////////////////////////////////////////////////
+
+CvarBoolean gCvarAiCrowdAvoidance("g_aiCrowdAvoidance", true, "Steer ai pedestrians around each other instead of physics contacts", CvarFlags_Archive);
+
+//////////////////////////////////////////////////////////////////////////
+
+// grid cells are hashed into fixed number of buckets, should be power of two
+const int CrowdGridBucketsCount = 4096;
+
+// number of agents processed by single job
+const int CrowdAgentsBatchSize = 64;
+
+// how strong avoidance turns agent away from desired direction
+const float CrowdAvoidanceGain = 2.0f;
+
+//////////////////////////////////////////////////////////////////////////
+
+void AiCrowdAvoidance::Cleanup()
+{
+    mAgents.clear();
+    mSteeredAgents.clear();
+    mAgentsBuckets.clear();
+    mBucketsAgents.clear();
+    mBucketFirstAgent.clear();
+}
+
+void AiCrowdAvoidance::UpdateFrame()
+{
+    mAgents.clear();
+    mSteeredAgents.clear();
+
+    if (!gCvarAiCrowdAvoidance.mValue)
+        return;
+
+    const float cellSize = gGame.mParams.mAiCrowdNeighbourDistance;
+
+    mAgentsBuckets.clear();
+    for (Pedestrian* currPedestrian: gGame.mObjectsMng.mPedestrians)
+    {
+        if (currPedestrian->IsMarkedForDeletion() || (currPedestrian->mPhysicsBody == nullptr))
+            continue;
+
+        if (currPedestrian->IsCarPassenger() || currPedestrian->IsDead() || !currPedestrian->IsOnTheGround())
+            continue;
+
+        CrowdAgent agent;
+        agent.mPosition = currPedestrian->mTransform.GetPosition2();
+        agent.mVelocity = currPedestrian->mPhysicsBody->GetLinearVelocity();
+
+        // steer only walking ai pedestrians, others are obstacles
+        if (currPedestrian->IsAiCharacter() && currPedestrian->IsIdle())
+        {
+            const PedestrianCtlState& ctlState = currPedestrian->mAiController->mSteeringCtlState;
+            if (ctlState.mRotateToDesiredAngle && (ctlState.mWalkForward || ctlState.mRun))
+            {
+                agent.mController = currPedestrian->mAiController;
+                mSteeredAgents.push_back((int) mAgents.size());
+            }
+        }
+        mAgents.push_back(agent);
+        mAgentsBuckets.push_back(GetCellBucket((int) floorf(agent.mPosition.x / cellSize), (int) floorf(agent.mPosition.y / cellSize)));
+    }
+
+    // counting sort agents by buckets, order within bucket is stable
+    mBucketFirstAgent.assign(CrowdGridBucketsCount + 1, 0);
+    for (int currBucket: mAgentsBuckets)
+    {
+        ++mBucketFirstAgent[currBucket + 1];
+    }
+    for (int ibucket = 1; ibucket <= CrowdGridBucketsCount; ++ibucket)
+    {
+        mBucketFirstAgent[ibucket] += mBucketFirstAgent[ibucket - 1];
+    }
+    mBucketsAgents.resize(mAgents.size());
+    for (int iagent = 0, AgentsCount = (int) mAgents.size(); iagent < AgentsCount; ++iagent)
+    {
+        mBucketsAgents[mBucketFirstAgent[mAgentsBuckets[iagent]]++] = iagent;
+    }
+    // restore first agent indices shifted by scatter
+    for (int ibucket = CrowdGridBucketsCount; ibucket > 0; --ibucket)
+    {
+        mBucketFirstAgent[ibucket] = mBucketFirstAgent[ibucket - 1];
+    }
+    mBucketFirstAgent[0] = 0;
+
+    // agents are reading grid and writing only their own steering
+    gSystem.mJobs.ParallelFor((int) mSteeredAgents.size(), CrowdAgentsBatchSize, [this](int beginIndex, int endIndex)
+    {
+        for (int iagent = beginIndex; iagent < endIndex; ++iagent)
+        {
+            SteerAgent(mAgents[mSteeredAgents[iagent]]);
+        }
+    });
+}
+
+bool AiCrowdAvoidance::IsCrowdAgent(GameObject* gameObject) const
+{
+    if (!gCvarAiCrowdAvoidance.mValue)
+        return false;
+
+    Pedestrian* pedestrian = ToPedestrian(gameObject);
+    return pedestrian && pedestrian->IsAiCharacter();
+}
+
+int AiCrowdAvoidance::GetCellBucket(int cellx, int celly) const
+{
+    unsigned int hash = ((unsigned int) cellx * 73856093U) ^ ((unsigned int) celly * 19349663U);
+    return (int) (hash & (CrowdGridBucketsCount - 1));
+}
+
+void AiCrowdAvoidance::SteerAgent(const CrowdAgent& agent) const
+{
+    PedestrianCtlState& ctlState = agent.mController->mSteeringCtlState;
+
+    const float angleRadians = ctlState.mDesiredRotationAngle.to_radians();
+    const glm::vec2 desiredDirection (cosf(angleRadians), sinf(angleRadians));
+    const float desiredSpeed = ctlState.mRun ? gGame.mParams.mPedestrianRunSpeed : gGame.mParams.mPedestrianWalkSpeed;
+    const glm::vec2 desiredVelocity = desiredDirection * desiredSpeed;
+
+    const float cellSize = gGame.mParams.mAiCrowdNeighbourDistance;
+    const float neighbourDistance2 = cellSize * cellSize;
+    const float timeHorizon = gGame.mParams.mAiCrowdTimeHorizon;
+    const float combinedRadius = gGame.mParams.mPedestrianBoundsSphereRadius * 2.0f;
+
+    // neighbour cells might share buckets
+    int buckets[9];
+    int bucketsCount = 0;
+
+    const int agentCellx = (int) floorf(agent.mPosition.x / cellSize);
+    const int agentCelly = (int) floorf(agent.mPosition.y / cellSize);
+    for (int celly = agentCelly - 1; celly <= agentCelly + 1; ++celly)
+    {
+        for (int cellx = agentCellx - 1; cellx <= agentCellx + 1; ++cellx)
+        {
+            int currBucket = GetCellBucket(cellx, celly);
+            if (std::find(buckets, buckets + bucketsCount, currBucket) == (buckets + bucketsCount))
+            {
+                buckets[bucketsCount++] = currBucket;
+            }
+        }
+    }
+
+    glm::vec2 avoidance (0.0f, 0.0f);
+    for (int ibucket = 0; ibucket < bucketsCount; ++ibucket)
+    {
+        for (int isorted = mBucketFirstAgent[buckets[ibucket]], EndIndex = mBucketFirstAgent[buckets[ibucket] + 1]; isorted < EndIndex; ++isorted)
+        {
+            const CrowdAgent& otherAgent = mAgents[mBucketsAgents[isorted]];
+            if (&otherAgent == &agent)
+                continue;
+
+            glm::vec2 toOther = otherAgent.mPosition - agent.mPosition;
+            float distance2 = glm::length2(toOther);
+            if (distance2 > neighbourDistance2)
+                continue;
+
+            // push apart overlapping agents
+            float distance = sqrtf(distance2);
+            if (distance < combinedRadius)
+            {
+                glm::vec2 awayDirection = (distance > 0.001f) ? (-toOther / distance) : glm::vec2(-desiredDirection.y, desiredDirection.x);
+                avoidance += awayDirection * ((combinedRadius - distance) / combinedRadius);
+            }
+
+            // sidestep predicted collision, nearer ones are more important
+            glm::vec2 relativeVelocity = desiredVelocity - otherAgent.mVelocity;
+            float relativeSpeed2 = glm::length2(relativeVelocity);
+            if (relativeSpeed2 < 0.0001f)
+                continue;
+
+            float closestTime = glm::dot(toOther, relativeVelocity) / relativeSpeed2;
+            if (closestTime <= 0.0f || closestTime > timeHorizon)
+                continue;
+
+            glm::vec2 closestOffset = toOther - relativeVelocity * closestTime;
+            float closestDistance = glm::length(closestOffset);
+            if (closestDistance >= combinedRadius)
+                continue;
+
+            // head on collision, pass by right side
+            glm::vec2 sidestepDirection = (closestDistance > 0.001f) ? (-closestOffset / closestDistance) : glm::vec2(-desiredDirection.y, desiredDirection.x);
+            avoidance += sidestepDirection * ((1.0f - closestTime / timeHorizon) * (combinedRadius - closestDistance) / combinedRadius);
+        }
+    }
+
+    if (glm::length2(avoidance) < 0.0001f)
+        return;
+
+    glm::vec2 steerDirection = desiredDirection + avoidance * CrowdAvoidanceGain;
+
+    // never turn back, slide along instead
+    float forwardAmount = glm::dot(steerDirection, desiredDirection);
+    if (forwardAmount < 0.0f)
+    {
+        steerDirection -= desiredDirection * forwardAmount;
+    }
+    if (glm::length2(steerDirection) < 0.0001f)
+        return;
+
+    ctlState.mDesiredRotationAngle = cxx::angle_t::from_radians(::atan2f(steerDirection.y, steerDirection.x));
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+// forwards
+class AiCharacterController;
+class GameObject;
+
+// defines local avoidance stage for walking ai pedestrians, executed after ai think and before physics step
+// neighbours are found on uniform grid and walking direction of each agent gets adjusted to avoid predicted collisions,
+// so physics contacts between ai pedestrians are not needed
+class AiCrowdAvoidance final: public cxx::noncopyable
+{
+public:
+    void Cleanup();
+
+    // Gather pedestrians into grid and adjust steering of ai controllers, not thread-safe
+    void UpdateFrame();
+
+    // Whether object is kept apart from other agents by crowd avoidance, physics contacts between agents can be ignored
+    bool IsCrowdAgent(GameObject* gameObject) const;
+
+private:
+    // pedestrian on grid
+    struct CrowdAgent
+    {
+    public:
+        glm::vec2 mPosition; // meters
+        glm::vec2 mVelocity; // meters per second
+        AiCharacterController* mController = nullptr; // null if agent is not steered
+    };
+
+    int GetCellBucket(int cellx, int celly) const;
+
+    // Adjust desired walking direction of agent, thread-safe as long as grid is not updated
+    void SteerAgent(const CrowdAgent& agent) const;
+
+private:
+    std::vector<CrowdAgent> mAgents;
+    std::vector<int> mSteeredAgents; // indices of agents to steer
+    std::vector<int> mAgentsBuckets; // bucket of each agent
+    std::vector<int> mBucketsAgents; // agents indices sorted by bucket
+    std::vector<int> mBucketFirstAgent; // index of first agent for each bucket, buckets count + 1
+};
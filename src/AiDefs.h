@@ -2,6 +2,7 @@
 
 // forwards
 class AiCharacterController;
+class Pedestrian;
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -20,6 +21,7 @@ enum AiBehaviorMemoryBits: std::uint64_t
     AiBehaviorMemoryBits_InPanic = BIT(0), // character was scared to death
     AiBehaviorMemoryBits_HearGunShots = BIT(1), // gunshots was detected nearby
     AiBehaviorMemoryBits_HearExplosion = BIT(2), // explosion was detected nearby
+    AiBehaviorMemoryBits_ThreatLocated = BIT(3), // location of last detected threat is known
 };
 decl_enum_as_flags(AiBehaviorMemoryBits);
 
@@ -41,4 +43,35 @@ enum AiBehaviorBits: std::uint64_t
     AiBehaviorBits_Fear_DeadPeds = BIT(12),
 
 };
-decl_enum_as_flags(AiBehaviorBits);
\ No newline at end of file
+decl_enum_as_flags(AiBehaviorBits);
+
+//////////////////////////////////////////////////////////////////////////
+
+// ai side effect command id
+enum eAiCommand
+{
+    eAiCommand_SetLeader, // start follow pedestrian
+    eAiCommand_ResetLeader, // stop follow current leader
+    eAiCommand_StopCharacterSound, // stop character sound on channel
+    eAiCommand_RequestPath, // queue path query, param is query key
+    eAiCommand_RequestFleeField, // create or prolong flee flow field, param is threat map block index
+    eAiCommand_RequestFollowField, // create or update flow field leading to pedestrian
+};
+
+// ai controllers think in parallel and are not allowed to modify anything except their own state,
+// all other changes are deferred and applied serially in deterministic order
+struct AiCommand
+{
+public:
+    AiCommand() = default;
+    AiCommand(eAiCommand commandID, Pedestrian* pedestrian = nullptr, int commandParam = 0)
+        : mCommandID(commandID)
+        , mPedestrian(pedestrian)
+        , mCommandParam(commandParam)
+    {
+    }
+public:
+    eAiCommand mCommandID = eAiCommand_ResetLeader;
+    Pedestrian* mPedestrian = nullptr;
+    int mCommandParam = 0;
+};
@@ -0,0 +1,247 @@
+#include "stdafx.h"
+#include "AiFlowFields.h"
+#include "AiPathfinder.h"
+#include "GtaOneGame.h"
+
+//////////////////////////////////////////////////////////////////////////
+
+// field window dimensions, blocks
+const int FlowFieldSize = 32;
+const int FlowFieldBlocksCount = FlowFieldSize * FlowFieldSize;
+
+const unsigned char FlowDirection_None = 0xFF;
+
+//////////////////////////////////////////////////////////////////////////
+
+void AiFlowFields::Cleanup()
+{
+    mFields.clear();
+    mBuildQueue.clear();
+}
+
+void AiFlowFields::UpdateFrame()
+{
+    int buildBudget = gGame.mParams.mAiFlowFieldBudget;
+    while (!mBuildQueue.empty() && (buildBudget > 0))
+    {
+        auto field_iter = mFields.find(mBuildQueue.front());
+        if ((field_iter == mFields.end()) || !field_iter->second.mBuilding)
+        {
+            mBuildQueue.pop_front();
+            continue;
+        }
+
+        FlowField& flowField = field_iter->second;
+        buildBudget -= ContinueBuild(flowField, buildBudget);
+        if (!flowField.mBuilding)
+        {
+            mBuildQueue.pop_front();
+        }
+    }
+
+    // evict fields nobody is interested in
+    const float currentTime = gGame.mTimeMng.mGameTime;
+    for (auto field_iter = mFields.begin(); field_iter != mFields.end();)
+    {
+        if ((currentTime - field_iter->second.mLastRequestTime) > gGame.mParams.mAiFlowFieldLifetime)
+        {
+            field_iter = mFields.erase(field_iter);
+            continue;
+        }
+        ++field_iter;
+    }
+}
+
+unsigned int AiFlowFields::GetFleeFieldKey(const Point& threatBlock)
+{
+    unsigned int blockIndex = (glm::clamp(threatBlock.y, 0, MAP_DIMENSIONS - 1) * MAP_DIMENSIONS) + glm::clamp(threatBlock.x, 0, MAP_DIMENSIONS - 1);
+    return (blockIndex << 1) | eAiFlowFieldType_Flee;
+}
+
+unsigned int AiFlowFields::GetFollowFieldKey(GameObjectID leaderID)
+{
+    return (leaderID << 1) | eAiFlowFieldType_Seek;
+}
+
+void AiFlowFields::RequestField(unsigned int fieldKey, const Point& goalBlock)
+{
+    Point clampedGoal (glm::clamp(goalBlock.x, 0, MAP_DIMENSIONS - 1), glm::clamp(goalBlock.y, 0, MAP_DIMENSIONS - 1));
+
+    FlowField& flowField = mFields[fieldKey];
+    flowField.mType = (eAiFlowFieldType) (fieldKey & 1);
+    flowField.mLastRequestTime = gGame.mTimeMng.mGameTime;
+
+    if (flowField.mBuilding)
+    {
+        // restart build with new goal, it is already queued
+        if (flowField.mBuild.mGoalBlock != clampedGoal)
+        {
+            StartBuild(flowField, clampedGoal);
+        }
+        return;
+    }
+
+    if (flowField.mReady && (flowField.mCurrent.mGoalBlock == clampedGoal))
+        return;
+
+    StartBuild(flowField, clampedGoal);
+    mBuildQueue.push_back(fieldKey);
+}
+
+bool AiFlowFields::SampleDirection(unsigned int fieldKey, const glm::vec2& position, glm::vec2& outDirection) const
+{
+    auto field_iter = mFields.find(fieldKey);
+    if ((field_iter == mFields.end()) || !field_iter->second.mReady)
+        return false;
+
+    const FieldData& fieldData = field_iter->second.mCurrent;
+
+    glm::vec2 mapPosition = Convert::MetersToMapUnits(position);
+    Point block ((int) floorf(mapPosition.x), (int) floorf(mapPosition.y));
+    Point windowBlock = block - fieldData.mOrigin;
+    if (windowBlock.x < 0 || windowBlock.x >= FlowFieldSize || windowBlock.y < 0 || windowBlock.y >= FlowFieldSize)
+        return false;
+
+    unsigned char direction = fieldData.mDirections[(windowBlock.y * FlowFieldSize) + windowBlock.x];
+    if (direction == FlowDirection_None)
+        return false;
+
+    // head to center of next block
+    Point nextBlock = block + AiPathfinder::GetNeighbourOffset(direction);
+    glm::vec2 toNextBlock = Convert::MapUnitsToMeters(glm::vec2(nextBlock.x + 0.5f, nextBlock.y + 0.5f)) - position;
+    if (glm::length2(toNextBlock) < 0.0001f)
+        return false;
+
+    outDirection = glm::normalize(toNextBlock);
+    return true;
+}
+
+void AiFlowFields::StartBuild(FlowField& flowField, const Point& goalBlock)
+{
+    flowField.mBuilding = true;
+
+    FieldData& fieldData = flowField.mBuild;
+    fieldData.mGoalBlock = goalBlock;
+    fieldData.mOrigin.x = glm::clamp(goalBlock.x - FlowFieldSize / 2, 0, MAP_DIMENSIONS - FlowFieldSize);
+    fieldData.mOrigin.y = glm::clamp(goalBlock.y - FlowFieldSize / 2, 0, MAP_DIMENSIONS - FlowFieldSize);
+    fieldData.mDirections.assign(FlowFieldBlocksCount, FlowDirection_None);
+
+    Point goalWindowBlock = goalBlock - fieldData.mOrigin;
+    int goalIndex = (goalWindowBlock.y * FlowFieldSize) + goalWindowBlock.x;
+
+    flowField.mBuildCosts.assign(FlowFieldBlocksCount, std::numeric_limits<int>::max());
+    flowField.mBuildCosts[goalIndex] = 0;
+    flowField.mBuildOpenList.clear();
+    flowField.mBuildOpenList.push_back({0, goalIndex});
+    flowField.mBuildFinalizeIndex = 0;
+}
+
+int AiFlowFields::ContinueBuild(FlowField& flowField, int budget)
+{
+    const AiPathfinder& pathfinder = gGame.mPathfinder;
+    const Point& origin = flowField.mBuild.mOrigin;
+
+    std::vector<OpenElement>& openList = flowField.mBuildOpenList;
+    std::vector<int>& costs = flowField.mBuildCosts;
+
+    // distances from goal, step costs are symmetric
+    int processedCount = 0;
+    while (!openList.empty() && (processedCount < budget))
+    {
+        std::pop_heap(openList.begin(), openList.end(), std::greater<OpenElement>());
+        OpenElement currElement = openList.back();
+        openList.pop_back();
+
+        if (currElement.mCost > costs[currElement.mIndex])
+            continue; // outdated entry
+
+        ++processedCount;
+
+        Point block = origin + Point(currElement.mIndex % FlowFieldSize, currElement.mIndex / FlowFieldSize);
+        unsigned char blockLinks = pathfinder.GetBlockLinks(block.x, block.y);
+        for (int ineighbour = 0; ineighbour < AiPathNeighboursCount; ++ineighbour)
+        {
+            if ((blockLinks & BIT(ineighbour)) == 0)
+                continue;
+
+            Point windowBlock = block + AiPathfinder::GetNeighbourOffset(ineighbour) - origin;
+            if (windowBlock.x < 0 || windowBlock.x >= FlowFieldSize || windowBlock.y < 0 || windowBlock.y >= FlowFieldSize)
+                continue;
+
+            int neighbourIndex = (windowBlock.y * FlowFieldSize) + windowBlock.x;
+            int neighbourCost = currElement.mCost + pathfinder.GetStepCost(block, ineighbour);
+            if (neighbourCost >= costs[neighbourIndex])
+                continue;
+
+            costs[neighbourIndex] = neighbourCost;
+            openList.push_back({neighbourCost, neighbourIndex});
+            std::push_heap(openList.begin(), openList.end(), std::greater<OpenElement>());
+        }
+    }
+
+    if (!openList.empty())
+        return processedCount;
+
+    // choose directions
+    for (; (flowField.mBuildFinalizeIndex < FlowFieldBlocksCount) && (processedCount < budget); ++processedCount)
+    {
+        int windowIndex = flowField.mBuildFinalizeIndex++;
+        flowField.mBuild.mDirections[windowIndex] = (unsigned char) ChooseDirection(flowField, windowIndex);
+    }
+
+    if (flowField.mBuildFinalizeIndex < FlowFieldBlocksCount)
+        return processedCount;
+
+    // new directions are ready
+    std::swap(flowField.mCurrent, flowField.mBuild);
+    flowField.mReady = true;
+    flowField.mBuilding = false;
+    return processedCount;
+}
+
+int AiFlowFields::ChooseDirection(const FlowField& flowField, int windowIndex) const
+{
+    const AiPathfinder& pathfinder = gGame.mPathfinder;
+    const std::vector<int>& costs = flowField.mBuildCosts;
+    const Point& origin = flowField.mBuild.mOrigin;
+
+    int currCost = costs[windowIndex];
+    if (currCost == std::numeric_limits<int>::max())
+        return FlowDirection_None; // unreachable
+
+    const bool isFlee = (flowField.mType == eAiFlowFieldType_Flee);
+
+    Point block = origin + Point(windowIndex % FlowFieldSize, windowIndex / FlowFieldSize);
+    unsigned char blockLinks = pathfinder.GetBlockLinks(block.x, block.y);
+
+    int bestDirection = FlowDirection_None;
+    int bestCost = currCost;
+    for (int ineighbour = 0; ineighbour < AiPathNeighboursCount; ++ineighbour)
+    {
+        if ((blockLinks & BIT(ineighbour)) == 0)
+            continue;
+
+        int neighbourCost = 0;
+
+        Point windowBlock = block + AiPathfinder::GetNeighbourOffset(ineighbour) - origin;
+        if (windowBlock.x < 0 || windowBlock.x >= FlowFieldSize || windowBlock.y < 0 || windowBlock.y >= FlowFieldSize)
+        {
+            if (!isFlee)
+                continue;
+
+            // leaving field area is always good when running away
+            neighbourCost = currCost + pathfinder.GetStepCost(block, ineighbour);
+        }
+        else
+        {
+            neighbourCost = costs[(windowBlock.y * FlowFieldSize) + windowBlock.x];
+        }
+
+        if (isFlee ? (neighbourCost > bestCost) : (neighbourCost < bestCost))
+        {
+            bestCost = neighbourCost;
+            bestDirection = ineighbour;
+        }
+    }
+    return bestDirection;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "GameDefs.h"
+
+// forwards
+class AiPathfinder;
+
+// flow field goal kind
+enum eAiFlowFieldType
+{
+    eAiFlowFieldType_Seek, // directions lead to goal block
+    eAiFlowFieldType_Flee, // directions lead away from goal block
+};
+
+// defines shared direction fields over walkable blocks around goals, used when many pedestrians head for same goal
+// fields are built within per frame budget and live while they are requested, any number of agents can sample them
+// moving goal does not invalidate field, previous directions are sampled until rebuild completes
+class AiFlowFields final: public cxx::noncopyable
+{
+public:
+    void Cleanup();
+
+    // Process pending fields builds within per frame budget and evict unused fields, not thread-safe
+    void UpdateFrame();
+
+    // Get field identifier for running away from map block
+    // @param threatBlock: Map block coordinates
+    static unsigned int GetFleeFieldKey(const Point& threatBlock);
+
+    // Get field identifier for following game object
+    // @param leaderID: Followed object identifier
+    static unsigned int GetFollowFieldKey(GameObjectID leaderID);
+
+    // Create field or move its goal, field lifetime gets prolonged, not thread-safe
+    // @param fieldKey: Field identifier
+    // @param goalBlock: Map block coordinates
+    void RequestField(unsigned int fieldKey, const Point& goalBlock);
+
+    // Get movement direction at position, thread-safe as long as fields are not updated
+    // @param fieldKey: Field identifier
+    // @param position: Map position, meters
+    // @param outDirection: Output normalized direction
+    // @returns false if field is not built yet or position is outside of field or goal is reached
+    bool SampleDirection(unsigned int fieldKey, const glm::vec2& position, glm::vec2& outDirection) const;
+
+private:
+    // field directions within square window of map blocks
+    struct FieldData
+    {
+    public:
+        Point mGoalBlock;
+        Point mOrigin; // window top left block
+        std::vector<unsigned char> mDirections; // neighbour index for each window block
+    };
+
+    // open list entry
+    struct OpenElement
+    {
+    public:
+        inline bool operator > (const OpenElement& other) const { return mCost > other.mCost; }
+    public:
+        int mCost = 0;
+        int mIndex = 0;
+    };
+
+    struct FlowField
+    {
+    public:
+        eAiFlowFieldType mType = eAiFlowFieldType_Seek;
+        bool mReady = false; // current data can be sampled
+        bool mBuilding = false;
+        float mLastRequestTime = 0.0f;
+        FieldData mCurrent;
+        // build state
+        FieldData mBuild;
+        std::vector<int> mBuildCosts;
+        std::vector<OpenElement> mBuildOpenList;
+        int mBuildFinalizeIndex = 0; // next block to get direction, costs are ready when open list is empty
+    };
+
+    void StartBuild(FlowField& flowField, const Point& goalBlock);
+
+    // Continue field build
+    // @param budget: Number of blocks that can be processed
+    // @returns number of processed blocks
+    int ContinueBuild(FlowField& flowField, int budget);
+
+    int ChooseDirection(const FlowField& flowField, int windowIndex) const;
+
+private:
+    std::map<unsigned int, FlowField> mFields;
+    std::deque<unsigned int> mBuildQueue;
+};
@@ -1,9 +1,14 @@
 #include "stdafx.h"
 #include "AiGangBehavior.h"
 #include "Pedestrian.h"
+#include "AiCharacterController.h"
 
-AiGangBehavior::AiGangBehavior(AiCharacterController* aiController)
-    : AiPedestrianBehavior(aiController, eAiPedestrianBehavior_Gang)
+AiGangBehavior::AiGangBehavior()
+    : AiPedestrianBehavior(eAiPedestrianBehavior_Gang)
+{
+}
+
+void AiGangBehavior::OnResetBehavior()
 {
     Pedestrian* character = GetCharacter();
     if (character->mPedestrianType == ePedestrianType_GangLeader)
@@ -37,7 +42,7 @@ void AiGangBehavior::OnUpdateBehavior()
         Pedestrian* character = GetCharacter();
         if (character->IsDead())
         {
-            character->StopGameObjectSound(ePedSfxChannelIndex_Misc);
+            mAiController->PushCommand(AiCommand(eAiCommand_StopCharacterSound, character, ePedSfxChannelIndex_Misc));
         }
     }
 }
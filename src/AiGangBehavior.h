@@ -5,10 +5,11 @@
 class AiGangBehavior: public AiPedestrianBehavior
 {
 public:
-    AiGangBehavior(AiCharacterController* aiController);
+    AiGangBehavior();
 
 protected:
     // override AiPedestrianBehavior
+    void OnResetBehavior() override;
     void OnActivateBehavior() override;
     void OnShutdownBehavior() override;
     void OnUpdateBehavior() override;
@@ -2,6 +2,14 @@
 #include "AiManager.h"
 #include "AiCharacterController.h"
 #include "Pedestrian.h"
+#include "GtaOneGame.h"
+
+//////////////////////////////////////////////////////////////////////////
+
+// number of controllers processed by single job during think phase
+const int AiControllersBatchSize = 32;
+
+//////////////////////////////////////////////////////////////////////////
 
 AiManager::AiManager()
 {
@@ -9,19 +17,40 @@ AiManager::AiManager()
 
 void AiManager::UpdateFrame()
 {
-    // update all character controllers
+    if (mUpdateControllers.capacity() < mCharacterControllers.size())
+    {
+        mUpdateControllers.reserve(mCharacterControllers.capacity());
+    }
+    ChooseControllersToUpdate();
+
+    // drivers are looking for cars ahead in lanes occupancy
+    gGame.mRoadTraffic.UpdateFrame();
+
+    // think phase, controllers are reading world state and writing only their own state
+    gSystem.mJobs.ParallelFor((int) mUpdateControllers.size(), AiControllersBatchSize, [this](int beginIndex, int endIndex)
+    {
+        for (int iController = beginIndex; iController < endIndex; ++iController)
+        {
+            mUpdateControllers[iController]->UpdateFrame();
+        }
+    });
+    mUpdateControllers.clear();
+
+    // apply deferred commands in controllers order to keep results deterministic
     bool hasInactiveControllers = false;
     for (size_t iController = 0, Count = mCharacterControllers.size(); iController < Count; ++iController)
     {
         AiCharacterController* currController = mCharacterControllers[iController];
         if (currController->IsControllerActive())
         {
-            currController->UpdateFrame();
+            currController->PostUpdateFrame();
+            currController->mSteeringCtlState = currController->mCtlState;
         }
 
         if (!currController->IsControllerActive())
         {
-            SafeDelete(mCharacterControllers[iController]);
+            mFreeControllers.push_back(currController);
+            mCharacterControllers[iController] = nullptr;
             hasInactiveControllers = true;
         }
     }
@@ -29,6 +58,74 @@ void AiManager::UpdateFrame()
     {
         cxx::erase_elements(mCharacterControllers, nullptr);
     }
+
+    // adjust walking directions before physics step
+    gGame.mCrowdAvoidance.UpdateFrame();
+
+    // paths and fields requested during this frame will be ready on next think
+    gGame.mPathfinder.UpdateFrame();
+    gGame.mFlowFields.UpdateFrame();
+}
+
+void AiManager::ChooseControllersToUpdate()
+{
+    const int numControllers = (int) mCharacterControllers.size();
+    if (numControllers == 0)
+        return;
+
+    const float deltaTime = gGame.mTimeMng.mGameFrameDelta;
+    const float fullRateDistance = gGame.mParams.mAiLodFullRateDistance;
+
+    cxx::aabbox2d_t fullRateArea = gGame.mCamera.mOnScreenMapArea;
+    fullRateArea.mMin.x -= fullRateDistance;
+    fullRateArea.mMin.y -= fullRateDistance;
+    fullRateArea.mMax.x += fullRateDistance;
+    fullRateArea.mMax.y += fullRateDistance;
+
+    glm::vec2 playerPosition;
+    Pedestrian* playerCharacter = gGame.mPlayerState.mCharacter;
+    if (playerCharacter)
+    {
+        playerPosition = playerCharacter->mTransform.GetPosition2();
+    }
+
+    if (mRoundRobinIndex >= numControllers)
+    {
+        mRoundRobinIndex = 0;
+    }
+
+    int farUpdatesBudget = gGame.mParams.mAiLodFarUpdatesPerFrame;
+    int lastFarController = -1;
+    for (int icurr = 0; icurr < numControllers; ++icurr)
+    {
+        int iController = (mRoundRobinIndex + icurr) % numControllers;
+
+        AiCharacterController* currController = mCharacterControllers[iController];
+        if (!currController->IsControllerActive())
+            continue;
+
+        currController->AccumulateTime(deltaTime);
+
+        glm::vec2 characterPosition = currController->mCharacter->mTransform.GetPosition2();
+        bool isFullRate = fullRateArea.contains(characterPosition) || 
+            (playerCharacter && glm::distance2(characterPosition, playerPosition) < (fullRateDistance * fullRateDistance));
+
+        if (!isFullRate)
+        {
+            if (farUpdatesBudget == 0)
+                continue;
+
+            --farUpdatesBudget;
+            lastFarController = icurr;
+        }
+        mUpdateControllers.push_back(currController);
+    }
+
+    // continue from next distant controller on next frame
+    if (lastFarController != -1)
+    {
+        mRoundRobinIndex = (mRoundRobinIndex + lastFarController + 1) % numControllers;
+    }
 }
 
 void AiManager::DebugDraw(DebugRenderer& debugRender)
@@ -43,9 +140,30 @@ void AiManager::ReleaseAiControllers()
 {
     for (AiCharacterController* currController: mCharacterControllers)
     {
-        delete currController;
+        DestroyController(currController);
     }
     mCharacterControllers.clear();
+    mUpdateControllers.clear();
+    mRoundRobinIndex = 0;
+
+    // controllers release their behaviors on destruction
+    for (AiCharacterController* currController: mFreeControllers)
+    {
+        DestroyController(currController);
+    }
+    mFreeControllers.clear();
+
+    for (AiPedestrianBehavior* currBehavior: mFreePedestrianBehaviors)
+    {
+        mPedestrianBehaviorsPool.destroy(currBehavior);
+    }
+    mFreePedestrianBehaviors.clear();
+
+    for (AiGangBehavior* currBehavior: mFreeGangBehaviors)
+    {
+        mGangBehaviorsPool.destroy(currBehavior);
+    }
+    mFreeGangBehaviors.clear();
 }
 
 AiCharacterController* AiManager::CreateAiController(Pedestrian* pedestrian)
@@ -56,7 +174,16 @@ AiCharacterController* AiManager::CreateAiController(Pedestrian* pedestrian)
         return nullptr;
     }
 
-    AiCharacterController* controller = new AiCharacterController();
+    AiCharacterController* controller = nullptr;
+    if (mFreeControllers.empty())
+    {
+        controller = mControllersPool.create();
+    }
+    else
+    {
+        controller = mFreeControllers.back();
+        mFreeControllers.pop_back();
+    }
     controller->SetCharacter(pedestrian);
     mCharacterControllers.push_back(controller);
     return controller;
@@ -70,5 +197,61 @@ void AiManager::ReleaseAiController(AiCharacterController* controller)
         return;
     }
     cxx::erase_elements(mCharacterControllers, controller);
-    delete controller;
+    controller->SetCharacter(nullptr);
+    mFreeControllers.push_back(controller);
 }
+
+AiPedestrianBehavior* AiManager::CreatePedestrianBehavior(AiCharacterController* controller, eAiPedestrianBehavior behaviorID)
+{
+    AiPedestrianBehavior* behavior = nullptr;
+    // free behaviors are usually of same kind, so search ends on last one
+    for (int ibehavior = (int) mFreePedestrianBehaviors.size() - 1; ibehavior >= 0; --ibehavior)
+    {
+        if (mFreePedestrianBehaviors[ibehavior]->mBehaviorID != behaviorID)
+            continue;
+
+        behavior = mFreePedestrianBehaviors[ibehavior];
+        mFreePedestrianBehaviors[ibehavior] = mFreePedestrianBehaviors.back();
+        mFreePedestrianBehaviors.pop_back();
+        break;
+    }
+    if (behavior == nullptr)
+    {
+        behavior = mPedestrianBehaviorsPool.create(behaviorID);
+    }
+    behavior->ResetBehavior(controller);
+    return behavior;
+}
+
+AiPedestrianBehavior* AiManager::CreateGangBehavior(AiCharacterController* controller)
+{
+    AiGangBehavior* behavior = nullptr;
+    if (mFreeGangBehaviors.empty())
+    {
+        behavior = mGangBehaviorsPool.create();
+    }
+    else
+    {
+        behavior = mFreeGangBehaviors.back();
+        mFreeGangBehaviors.pop_back();
+    }
+    behavior->ResetBehavior(controller);
+    return behavior;
+}
+
+void AiManager::ReleaseBehavior(AiPedestrianBehavior* behavior)
+{
+    cxx_assert(behavior);
+    if (behavior->mBehaviorID == eAiPedestrianBehavior_Gang)
+    {
+        mFreeGangBehaviors.push_back(static_cast<AiGangBehavior*>(behavior));
+        return;
+    }
+    mFreePedestrianBehaviors.push_back(behavior);
+}
+
+void AiManager::DestroyController(AiCharacterController* controller)
+{
+    cxx_assert(controller);
+    mControllersPool.destroy(controller);
+}
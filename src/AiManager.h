@@ -1,6 +1,8 @@
 #pragma once
 
-class AiCharacterController;
+#include "AiCharacterController.h"
+#include "AiGangBehavior.h"
+
 class DebugRenderer;
 
 // Artificial Intelligence manager class
@@ -21,6 +23,30 @@ public:
     void ReleaseAiControllers();
     void ReleaseAiController(AiCharacterController* controller);
 
+    // Create or release ai behavior objects, used by ai controllers
+    // Released behaviors are reused, so their lists keep memory across respawns
+    AiPedestrianBehavior* CreatePedestrianBehavior(AiCharacterController* controller, eAiPedestrianBehavior behaviorID);
+    AiPedestrianBehavior* CreateGangBehavior(AiCharacterController* controller);
+    void ReleaseBehavior(AiPedestrianBehavior* behavior);
+
 private:
+    // Choose controllers to think on current frame
+    // Controllers near the player or on screen are updated every frame, distant ones in round-robin order
+    void ChooseControllersToUpdate();
+
+    void DestroyController(AiCharacterController* controller);
+
+private:
+    cxx::object_pool<AiCharacterController> mControllersPool;
+    cxx::object_pool<AiPedestrianBehavior> mPedestrianBehaviorsPool;
+    cxx::object_pool<AiGangBehavior> mGangBehaviorsPool;
+
     std::vector<AiCharacterController*> mCharacterControllers;
+    std::vector<AiCharacterController*> mUpdateControllers; // controllers to think on current frame
+    int mRoundRobinIndex = 0; // first distant controller to check on next frame
+
+    // inactive objects waiting for reuse, they are not destructed until all controllers are released
+    std::vector<AiCharacterController*> mFreeControllers;
+    std::vector<AiPedestrianBehavior*> mFreePedestrianBehaviors;
+    std::vector<AiGangBehavior*> mFreeGangBehaviors;
 };
\ No newline at end of file
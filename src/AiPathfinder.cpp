@@ -0,0 +1,871 @@
+#include "stdafx.h"
+#include "AiPathfinder.h"
+#include "GameMap.h"
+#include "GameMapHelpers.h"
+#include "GtaOneGame.h"
+
+//////////////////////////////////////////////////////////////////////////
+
+// cluster dimensions, blocks
+const int PathClusterSize = 16;
+const int PathClustersPerSide = MAP_DIMENSIONS / PathClusterSize;
+const int PathClustersCount = PathClustersPerSide * PathClustersPerSide;
+
+// wide entrances get transition point at each end instead of single one in the middle
+const int PathMaxEntranceWidth = 6;
+
+// max height difference between neighbour blocks edges which pedestrian can step over, map units
+const float PathMaxStepHeight = 0.3f;
+
+// straight neighbours go first, in order of directions N, E, S, W
+static const Point PathNeighbourOffsets[] =
+{
+    { 0, -1}, // N
+    { 1,  0}, // E
+    { 0,  1}, // S
+    {-1,  0}, // W
+    { 1, -1}, // NE
+    { 1,  1}, // SE
+    {-1,  1}, // SW
+    {-1, -1}, // NW
+};
+
+const int NumPathNeighbours = CountOf(PathNeighbourOffsets);
+static_assert(NumPathNeighbours == AiPathNeighboursCount, "Neighbours count mismatch");
+const int NumPathStraightNeighbours = 4;
+
+// straight components of diagonal neighbours
+static const int PathDiagonalComponents[][2] =
+{
+    {0, 1}, // NE
+    {2, 1}, // SE
+    {2, 3}, // SW
+    {0, 3}, // NW
+};
+
+const int NumPathDiagonalNeighbours = CountOf(PathDiagonalComponents);
+
+// block edge midpoints in order of straight neighbours
+static const glm::vec2 PathEdgePoints[] =
+{
+    {0.5f, 0.0f}, // N
+    {1.0f, 0.5f}, // E
+    {0.5f, 1.0f}, // S
+    {0.0f, 0.5f}, // W
+};
+
+// step costs are sum of both cells weights scaled by step length
+const int PathStraightStepScale = 5;
+const int PathDiagonalStepScale = 7;
+const int PathMinCellWeight = 2;
+
+inline unsigned char GetGroundTypeWeight(eGroundType groundType)
+{
+    switch (groundType)
+    {
+        case eGroundType_Pawement: return 2;
+        case eGroundType_Field: return 3;
+        case eGroundType_Road: return 6; // walk along roads only when there is no other way
+        default: break;
+    }
+    return 0; // not walkable
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+void AiPathfinder::BuildFromMap(const GameMap& gameMap)
+{
+    Cleanup();
+
+    double startTime = gSystem.GetSystemSeconds();
+
+    const int NumCells = MAP_DIMENSIONS * MAP_DIMENSIONS;
+    mNavCells.resize(NumCells);
+    mCellStates.resize(NumCells);
+
+    // collect top surface blocks and edges heights
+    std::vector<glm::vec4> edgeHeights(NumCells);
+    int walkableCount = 0;
+    for (int coordz = 0; coordz < MAP_DIMENSIONS; ++coordz)
+    for (int coordx = 0; coordx < MAP_DIMENSIONS; ++coordx)
+    {
+        for (int layer = (MAP_LAYERS_COUNT - 1); layer > -1; --layer)
+        {
+            const MapBlockInfo* mapBlock = gameMap.GetBlockInfo(coordx, coordz, layer);
+            if (mapBlock->mGroundType == eGroundType_Air)
+                continue;
+
+            int cellIndex = GetCellIndex(coordx, coordz);
+            NavCell& navCell = mNavCells[cellIndex];
+            navCell.mGroundType = mapBlock->mGroundType;
+            navCell.mWeight = GetGroundTypeWeight(mapBlock->mGroundType);
+            if (navCell.mWeight)
+            {
+                ++walkableCount;
+            }
+
+            // unknown slope types are treated as flat
+            int slopeType = mapBlock->mSlopeType;
+            bool isSlope = (slopeType > 0) && (slopeType < 45);
+            for (int iedge = 0; iedge < NumPathStraightNeighbours; ++iedge)
+            {
+                edgeHeights[cellIndex][iedge] = layer * 1.0f;
+                if (isSlope)
+                {
+                    edgeHeights[cellIndex][iedge] += GameMapHelpers::GetSlopeHeight(slopeType, PathEdgePoints[iedge].x, PathEdgePoints[iedge].y);
+                }
+            }
+            break;
+        }
+    }
+
+    // straight links, shared edges of neighbour blocks should be on same height
+    for (int coordz = 0; coordz < MAP_DIMENSIONS; ++coordz)
+    for (int coordx = 0; coordx < MAP_DIMENSIONS; ++coordx)
+    {
+        int cellIndex = GetCellIndex(coordx, coordz);
+        NavCell& navCell = mNavCells[cellIndex];
+        if (navCell.mWeight == 0)
+            continue;
+
+        for (int ineighbour = 0; ineighbour < NumPathStraightNeighbours; ++ineighbour)
+        {
+            Point neighbourCoord (coordx + PathNeighbourOffsets[ineighbour].x, coordz + PathNeighbourOffsets[ineighbour].y);
+            if (neighbourCoord.x < 0 || neighbourCoord.x >= MAP_DIMENSIONS || neighbourCoord.y < 0 || neighbourCoord.y >= MAP_DIMENSIONS)
+                continue;
+
+            int neighbourIndex = GetCellIndex(neighbourCoord.x, neighbourCoord.y);
+            if (mNavCells[neighbourIndex].mWeight == 0)
+                continue;
+
+            int oppositeEdge = (ineighbour + 2) % NumPathStraightNeighbours;
+            if (fabs(edgeHeights[cellIndex][ineighbour] - edgeHeights[neighbourIndex][oppositeEdge]) > PathMaxStepHeight)
+                continue;
+
+            navCell.mLinks |= BIT(ineighbour);
+        }
+    }
+
+    // diagonal links, both straight ways around corner should be open
+    for (int coordz = 0; coordz < MAP_DIMENSIONS; ++coordz)
+    for (int coordx = 0; coordx < MAP_DIMENSIONS; ++coordx)
+    {
+        int cellIndex = GetCellIndex(coordx, coordz);
+        NavCell& navCell = mNavCells[cellIndex];
+        for (int idiagonal = 0; idiagonal < NumPathDiagonalNeighbours; ++idiagonal)
+        {
+            int componentA = PathDiagonalComponents[idiagonal][0];
+            int componentB = PathDiagonalComponents[idiagonal][1];
+            if (((navCell.mLinks & BIT(componentA)) == 0) || ((navCell.mLinks & BIT(componentB)) == 0))
+                continue;
+
+            const NavCell& cellA = mNavCells[GetCellIndex(coordx + PathNeighbourOffsets[componentA].x, coordz + PathNeighbourOffsets[componentA].y)];
+            const NavCell& cellB = mNavCells[GetCellIndex(coordx + PathNeighbourOffsets[componentB].x, coordz + PathNeighbourOffsets[componentB].y)];
+            if (((cellA.mLinks & BIT(componentB)) == 0) || ((cellB.mLinks & BIT(componentA)) == 0))
+                continue;
+
+            navCell.mLinks |= BIT(NumPathStraightNeighbours + idiagonal);
+        }
+    }
+
+    BuildAbstractGraph();
+
+    gSystem.LogMessage(eLogMessage_Info, "Pathfinder: %d walkable blocks, %d cluster nodes, %d cluster edges (%.2f ms)",
+        walkableCount, (int) mNodes.size(), (int) mEdges.size(), (gSystem.GetSystemSeconds() - startTime) * 1000.0);
+}
+
+void AiPathfinder::BuildAbstractGraph()
+{
+    mCellNodes.resize(mNavCells.size(), -1);
+    mClusterNodes.resize(PathClustersCount);
+
+    std::vector<std::vector<AbstractEdge>> nodeEdges;
+
+    auto add_transition = [this, &nodeEdges](int cellA, int cellB, int neighbourIndex)
+    {
+        int nodeA = GetOrCreateNode(cellA, nodeEdges);
+        int nodeB = GetOrCreateNode(cellB, nodeEdges);
+        int stepCost = GetStepCost(cellA, cellB, neighbourIndex);
+        nodeEdges[nodeA].push_back({nodeB, stepCost});
+        nodeEdges[nodeB].push_back({nodeA, stepCost});
+    };
+
+    // find entrances on east and south borders of each cluster
+    for (int clusterz = 0; clusterz < PathClustersPerSide; ++clusterz)
+    for (int clusterx = 0; clusterx < PathClustersPerSide; ++clusterx)
+    {
+        const int BorderNeighbours[] = {1, 2}; // E, S
+        for (int ineighbour: BorderNeighbours)
+        {
+            bool isEastBorder = (ineighbour == 1);
+            if ((isEastBorder && (clusterx == PathClustersPerSide - 1)) || (!isEastBorder && (clusterz == PathClustersPerSide - 1)))
+                continue;
+
+            auto get_border_cell = [clusterx, clusterz, isEastBorder, this](int borderOffset)
+            {
+                if (isEastBorder)
+                    return GetCellIndex(clusterx * PathClusterSize + PathClusterSize - 1, clusterz * PathClusterSize + borderOffset);
+
+                return GetCellIndex(clusterx * PathClusterSize + borderOffset, clusterz * PathClusterSize + PathClusterSize - 1);
+            };
+
+            const int neighbourOffset = GetCellIndex(PathNeighbourOffsets[ineighbour].x, PathNeighbourOffsets[ineighbour].y);
+            const int alongNeighbour = isEastBorder ? 2 : 1; // S or E
+            for (int runStart = 0; runStart < PathClusterSize;)
+            {
+                if ((mNavCells[get_border_cell(runStart)].mLinks & BIT(ineighbour)) == 0)
+                {
+                    ++runStart;
+                    continue;
+                }
+                int runEnd = runStart + 1;
+                for (; runEnd < PathClusterSize; ++runEnd)
+                {
+                    if ((mNavCells[get_border_cell(runEnd)].mLinks & BIT(ineighbour)) == 0)
+                        break;
+
+                    // entrance cells on both sides should be connected along border
+                    int prevCell = get_border_cell(runEnd - 1);
+                    if (((mNavCells[prevCell].mLinks & BIT(alongNeighbour)) == 0) || 
+                        ((mNavCells[prevCell + neighbourOffset].mLinks & BIT(alongNeighbour)) == 0))
+                        break;
+                }
+
+                int runLength = runEnd - runStart;
+                if (runLength > PathMaxEntranceWidth)
+                {
+                    add_transition(get_border_cell(runStart), get_border_cell(runStart) + neighbourOffset, ineighbour);
+                    add_transition(get_border_cell(runEnd - 1), get_border_cell(runEnd - 1) + neighbourOffset, ineighbour);
+                }
+                else
+                {
+                    int middleCell = get_border_cell(runStart + runLength / 2);
+                    add_transition(middleCell, middleCell + neighbourOffset, ineighbour);
+                }
+                runStart = runEnd;
+            }
+        }
+    }
+
+    // precompute paths costs between nodes within each cluster
+    for (int icluster = 0; icluster < PathClustersCount; ++icluster)
+    {
+        const std::vector<int>& clusterNodes = mClusterNodes[icluster];
+        for (int sourceNode: clusterNodes)
+        {
+            SearchCells(mNodes[sourceNode].mCell, -1, icluster, nullptr);
+
+            for (int targetNode: clusterNodes)
+            {
+                if (targetNode == sourceNode)
+                    continue;
+
+                const SearchState& targetState = mCellStates[mNodes[targetNode].mCell];
+                if (targetState.mStamp != mCellsSearchStamp)
+                    continue;
+
+                nodeEdges[sourceNode].push_back({targetNode, targetState.mCost});
+            }
+        }
+    }
+
+    for (int inode = 0, NumNodes = (int) mNodes.size(); inode < NumNodes; ++inode)
+    {
+        AbstractNode& abstractNode = mNodes[inode];
+        abstractNode.mFirstEdge = (int) mEdges.size();
+        abstractNode.mEdgesCount = (int) nodeEdges[inode].size();
+        mEdges.insert(mEdges.end(), nodeEdges[inode].begin(), nodeEdges[inode].end());
+    }
+
+    mNodeStates.resize(mNodes.size() + 1); // extra state for goal
+    mGoalNodeCosts.resize(mNodes.size(), -1);
+}
+
+int AiPathfinder::GetOrCreateNode(int cellIndex, std::vector<std::vector<AbstractEdge>>& nodeEdges)
+{
+    if (mCellNodes[cellIndex] != -1)
+        return mCellNodes[cellIndex];
+
+    int nodeIndex = (int) mNodes.size();
+    mNodes.emplace_back();
+
+    AbstractNode& abstractNode = mNodes.back();
+    abstractNode.mCell = cellIndex;
+    abstractNode.mCluster = GetCellCluster(cellIndex);
+
+    mCellNodes[cellIndex] = nodeIndex;
+    mClusterNodes[abstractNode.mCluster].push_back(nodeIndex);
+    nodeEdges.emplace_back();
+    return nodeIndex;
+}
+
+void AiPathfinder::Cleanup()
+{
+    mNavCells.clear();
+    mCellNodes.clear();
+    mNodes.clear();
+    mEdges.clear();
+    mClusterNodes.clear();
+
+    mQueries.clear();
+    mPendingQueries.clear();
+    mCompletedQueries.clear();
+    mSharedRequestsCount = 0;
+
+    mCellStates.clear();
+    mNodeStates.clear();
+    mOpenList.clear();
+    mTempCells.clear();
+    mSegmentCells.clear();
+    mGoalNodeCosts.clear();
+    mCellsSearchStamp = 0;
+    mNodesSearchStamp = 0;
+    mExpandedCount = 0;
+}
+
+void AiPathfinder::UpdateFrame()
+{
+    mExpandedCount = 0;
+
+    // query is never interrupted, budget overrun is carried by the last one
+    const int expandBudget = gGame.mParams.mAiPathfindingBudget;
+    while (!mPendingQueries.empty() && (mExpandedCount < expandBudget))
+    {
+        unsigned int queryKey = mPendingQueries.front();
+        mPendingQueries.pop_front();
+
+        auto query_iter = mQueries.find(queryKey);
+        if (query_iter == mQueries.end())
+            continue;
+
+        Point startBlock (queryKey & 0xFF, (queryKey >> 8) & 0xFF);
+        Point goalBlock ((queryKey >> 16) & 0xFF, (queryKey >> 24) & 0xFF);
+
+        PathQuery& pathQuery = query_iter->second;
+        pathQuery.mStatus = FindPath(startBlock, goalBlock, pathQuery.mWaypoints) ? eAiPathStatus_Success : eAiPathStatus_Failed;
+        mCompletedQueries.push_back(queryKey);
+    }
+
+    // evict oldest results
+    while ((int) mCompletedQueries.size() > gGame.mParams.mAiPathCacheSize)
+    {
+        mQueries.erase(mCompletedQueries.front());
+        mCompletedQueries.pop_front();
+    }
+}
+
+unsigned int AiPathfinder::GetQueryKey(const Point& startBlock, const Point& goalBlock)
+{
+    unsigned int startx = glm::clamp(startBlock.x, 0, MAP_DIMENSIONS - 1);
+    unsigned int startz = glm::clamp(startBlock.y, 0, MAP_DIMENSIONS - 1);
+    unsigned int goalx = glm::clamp(goalBlock.x, 0, MAP_DIMENSIONS - 1);
+    unsigned int goalz = glm::clamp(goalBlock.y, 0, MAP_DIMENSIONS - 1);
+    return startx | (startz << 8) | (goalx << 16) | (goalz << 24);
+}
+
+void AiPathfinder::RequestPath(unsigned int queryKey)
+{
+    if (mQueries.find(queryKey) != mQueries.end())
+    {
+        ++mSharedRequestsCount;
+        return;
+    }
+    mQueries[queryKey].mStatus = eAiPathStatus_Pending;
+    mPendingQueries.push_back(queryKey);
+}
+
+eAiPathStatus AiPathfinder::GetPathStatus(unsigned int queryKey) const
+{
+    auto query_iter = mQueries.find(queryKey);
+    if (query_iter == mQueries.end())
+        return eAiPathStatus_None;
+
+    return query_iter->second.mStatus;
+}
+
+bool AiPathfinder::GetPathWaypoints(unsigned int queryKey, std::vector<Point>& outWaypoints) const
+{
+    auto query_iter = mQueries.find(queryKey);
+    if ((query_iter == mQueries.end()) || (query_iter->second.mStatus != eAiPathStatus_Success))
+        return false;
+
+    outWaypoints = query_iter->second.mWaypoints;
+    return true;
+}
+
+bool AiPathfinder::FindPath(const Point& startBlock, const Point& goalBlock, std::vector<Point>& outWaypoints)
+{
+    outWaypoints.clear();
+
+    if (!IsWalkableBlock(startBlock.x, startBlock.y) || !IsWalkableBlock(goalBlock.x, goalBlock.y))
+        return false;
+
+    if (!SearchHierarchical(GetCellIndex(startBlock.x, startBlock.y), GetCellIndex(goalBlock.x, goalBlock.y), mTempCells))
+        return false;
+
+    ConvertToWaypoints(mTempCells, outWaypoints);
+    return true;
+}
+
+bool AiPathfinder::IsWalkableBlock(int coordx, int coordz) const
+{
+    if (coordx < 0 || coordx >= MAP_DIMENSIONS || coordz < 0 || coordz >= MAP_DIMENSIONS || mNavCells.empty())
+        return false;
+
+    return mNavCells[GetCellIndex(coordx, coordz)].mWeight > 0;
+}
+
+eGroundType AiPathfinder::GetBlockGroundType(int coordx, int coordz) const
+{
+    if (coordx < 0 || coordx >= MAP_DIMENSIONS || coordz < 0 || coordz >= MAP_DIMENSIONS || mNavCells.empty())
+        return eGroundType_Air;
+
+    return mNavCells[GetCellIndex(coordx, coordz)].mGroundType;
+}
+
+unsigned char AiPathfinder::GetBlockLinks(int coordx, int coordz) const
+{
+    if (coordx < 0 || coordx >= MAP_DIMENSIONS || coordz < 0 || coordz >= MAP_DIMENSIONS || mNavCells.empty())
+        return 0;
+
+    return mNavCells[GetCellIndex(coordx, coordz)].mLinks;
+}
+
+int AiPathfinder::GetStepCost(const Point& block, int neighbourIndex) const
+{
+    cxx_assert(GetBlockLinks(block.x, block.y) & BIT(neighbourIndex));
+
+    Point neighbourBlock = block + PathNeighbourOffsets[neighbourIndex];
+    return GetStepCost(GetCellIndex(block.x, block.y), GetCellIndex(neighbourBlock.x, neighbourBlock.y), neighbourIndex);
+}
+
+const Point& AiPathfinder::GetNeighbourOffset(int neighbourIndex)
+{
+    cxx_assert(neighbourIndex >= 0 && neighbourIndex < NumPathNeighbours);
+    return PathNeighbourOffsets[neighbourIndex];
+}
+
+int AiPathfinder::GetCellCluster(int cellIndex) const
+{
+    int coordx = cellIndex % MAP_DIMENSIONS;
+    int coordz = cellIndex / MAP_DIMENSIONS;
+    return ((coordz / PathClusterSize) * PathClustersPerSide) + (coordx / PathClusterSize);
+}
+
+int AiPathfinder::GetHeuristicCost(int cellA, int cellB) const
+{
+    // octile distance with cheapest ground
+    int distancex = abs((cellA % MAP_DIMENSIONS) - (cellB % MAP_DIMENSIONS));
+    int distancez = abs((cellA / MAP_DIMENSIONS) - (cellB / MAP_DIMENSIONS));
+    int diagonalSteps = std::min(distancex, distancez);
+    int straightSteps = std::max(distancex, distancez) - diagonalSteps;
+    return (PathMinCellWeight * 2) * ((straightSteps * PathStraightStepScale) + (diagonalSteps * PathDiagonalStepScale));
+}
+
+int AiPathfinder::GetStepCost(int cellA, int cellB, int neighbourIndex) const
+{
+    int weights = mNavCells[cellA].mWeight + mNavCells[cellB].mWeight;
+    return weights * ((neighbourIndex < NumPathStraightNeighbours) ? PathStraightStepScale : PathDiagonalStepScale);
+}
+
+void AiPathfinder::NextSearchStamp(std::vector<SearchState>& searchStates, unsigned int& searchStamp)
+{
+    ++searchStamp;
+    if (searchStamp == 0)
+    {
+        // stamp wrapped around, reset all states
+        for (SearchState& currState: searchStates)
+        {
+            currState.mStamp = 0;
+        }
+        searchStamp = 1;
+    }
+}
+
+int AiPathfinder::SearchCells(int startCell, int goalCell, int clusterIndex, std::vector<int>* outCells)
+{
+    NextSearchStamp(mCellStates, mCellsSearchStamp);
+
+    Point boundsMin (0, 0);
+    Point boundsMax (MAP_DIMENSIONS - 1, MAP_DIMENSIONS - 1);
+    if (clusterIndex != -1)
+    {
+        boundsMin.x = (clusterIndex % PathClustersPerSide) * PathClusterSize;
+        boundsMin.y = (clusterIndex / PathClustersPerSide) * PathClusterSize;
+        boundsMax = boundsMin + Point(PathClusterSize - 1, PathClusterSize - 1);
+    }
+
+    SearchState& startState = mCellStates[startCell];
+    startState.mStamp = mCellsSearchStamp;
+    startState.mCost = 0;
+    startState.mParent = -1;
+    startState.mClosed = false;
+
+    mOpenList.clear();
+    mOpenList.push_back({(goalCell == -1) ? 0 : GetHeuristicCost(startCell, goalCell), startCell});
+
+    while (!mOpenList.empty())
+    {
+        std::pop_heap(mOpenList.begin(), mOpenList.end(), std::greater<OpenElement>());
+        int currCell = mOpenList.back().mIndex;
+        mOpenList.pop_back();
+
+        SearchState& currState = mCellStates[currCell];
+        if (currState.mClosed)
+            continue;
+
+        currState.mClosed = true;
+        ++mExpandedCount;
+
+        if (currCell == goalCell)
+        {
+            if (outCells)
+            {
+                outCells->clear();
+                for (int pathCell = goalCell; pathCell != -1; pathCell = mCellStates[pathCell].mParent)
+                {
+                    outCells->push_back(pathCell);
+                }
+                std::reverse(outCells->begin(), outCells->end());
+            }
+            return currState.mCost;
+        }
+
+        const NavCell& currNavCell = mNavCells[currCell];
+        Point currCoord (currCell % MAP_DIMENSIONS, currCell / MAP_DIMENSIONS);
+        for (int ineighbour = 0; ineighbour < NumPathNeighbours; ++ineighbour)
+        {
+            if ((currNavCell.mLinks & BIT(ineighbour)) == 0)
+                continue;
+
+            Point neighbourCoord = currCoord + PathNeighbourOffsets[ineighbour];
+            if (neighbourCoord.x < boundsMin.x || neighbourCoord.x > boundsMax.x || neighbourCoord.y < boundsMin.y || neighbourCoord.y > boundsMax.y)
+                continue;
+
+            int neighbourCell = GetCellIndex(neighbourCoord.x, neighbourCoord.y);
+            SearchState& neighbourState = mCellStates[neighbourCell];
+            if (neighbourState.mStamp != mCellsSearchStamp)
+            {
+                neighbourState.mStamp = mCellsSearchStamp;
+                neighbourState.mCost = std::numeric_limits<int>::max();
+                neighbourState.mParent = -1;
+                neighbourState.mClosed = false;
+            }
+            if (neighbourState.mClosed)
+                continue;
+
+            int neighbourCost = currState.mCost + GetStepCost(currCell, neighbourCell, ineighbour);
+            if (neighbourCost >= neighbourState.mCost)
+                continue;
+
+            neighbourState.mCost = neighbourCost;
+            neighbourState.mParent = currCell;
+
+            int neighbourScore = neighbourCost + ((goalCell == -1) ? 0 : GetHeuristicCost(neighbourCell, goalCell));
+            mOpenList.push_back({neighbourScore, neighbourCell});
+            std::push_heap(mOpenList.begin(), mOpenList.end(), std::greater<OpenElement>());
+        }
+    }
+    return (goalCell == -1) ? 0 : -1;
+}
+
+bool AiPathfinder::SearchHierarchical(int startCell, int goalCell, std::vector<int>& outCells)
+{
+    outCells.clear();
+    if (startCell == goalCell)
+    {
+        outCells.push_back(startCell);
+        return true;
+    }
+
+    const int startCluster = GetCellCluster(startCell);
+    const int goalCluster = GetCellCluster(goalCell);
+
+    // path that does not leave cluster might be the best one
+    int directCost = -1;
+    if (startCluster == goalCluster)
+    {
+        directCost = SearchCells(startCell, goalCell, startCluster, &outCells);
+    }
+
+    // connect goal to its cluster nodes, step costs are symmetric so backward search gives same costs
+    const std::vector<int>& goalClusterNodes = mClusterNodes[goalCluster];
+    SearchCells(goalCell, -1, goalCluster, nullptr);
+    for (int goalNode: goalClusterNodes)
+    {
+        const SearchState& cellState = mCellStates[mNodes[goalNode].mCell];
+        if (cellState.mStamp == mCellsSearchStamp)
+        {
+            mGoalNodeCosts[goalNode] = cellState.mCost;
+        }
+    }
+
+    // connect start to its cluster nodes, cells search states are kept until next cells search
+    SearchCells(startCell, -1, startCluster, nullptr);
+
+    NextSearchStamp(mNodeStates, mNodesSearchStamp);
+    mOpenList.clear();
+
+    auto open_node = [this, goalCell](int nodeIndex, int nodeCost, int parentNode)
+    {
+        SearchState& nodeState = mNodeStates[nodeIndex];
+        if (nodeState.mStamp != mNodesSearchStamp)
+        {
+            nodeState.mStamp = mNodesSearchStamp;
+            nodeState.mCost = std::numeric_limits<int>::max();
+            nodeState.mClosed = false;
+        }
+        if (nodeState.mClosed || (nodeCost >= nodeState.mCost))
+            return;
+
+        nodeState.mCost = nodeCost;
+        nodeState.mParent = parentNode;
+
+        int nodeScore = nodeCost;
+        if (nodeIndex < (int) mNodes.size())
+        {
+            nodeScore += GetHeuristicCost(mNodes[nodeIndex].mCell, goalCell);
+        }
+        mOpenList.push_back({nodeScore, nodeIndex});
+        std::push_heap(mOpenList.begin(), mOpenList.end(), std::greater<OpenElement>());
+    };
+
+    // virtual goal node goes after all cluster nodes
+    const int goalNodeIndex = (int) mNodes.size();
+    if (directCost != -1)
+    {
+        open_node(goalNodeIndex, directCost, -1);
+    }
+
+    for (int startNode: mClusterNodes[startCluster])
+    {
+        const SearchState& cellState = mCellStates[mNodes[startNode].mCell];
+        if (cellState.mStamp == mCellsSearchStamp)
+        {
+            open_node(startNode, cellState.mCost, -1);
+        }
+    }
+
+    bool goalReached = false;
+    while (!mOpenList.empty())
+    {
+        std::pop_heap(mOpenList.begin(), mOpenList.end(), std::greater<OpenElement>());
+        int currNode = mOpenList.back().mIndex;
+        mOpenList.pop_back();
+
+        SearchState& currState = mNodeStates[currNode];
+        if (currState.mClosed)
+            continue;
+
+        currState.mClosed = true;
+        ++mExpandedCount;
+
+        if (currNode == goalNodeIndex)
+        {
+            goalReached = true;
+            break;
+        }
+
+        if (mGoalNodeCosts[currNode] != -1)
+        {
+            open_node(goalNodeIndex, currState.mCost + mGoalNodeCosts[currNode], currNode);
+        }
+
+        const AbstractNode& abstractNode = mNodes[currNode];
+        for (int iedge = 0; iedge < abstractNode.mEdgesCount; ++iedge)
+        {
+            const AbstractEdge& abstractEdge = mEdges[abstractNode.mFirstEdge + iedge];
+            open_node(abstractEdge.mTargetNode, currState.mCost + abstractEdge.mCost, currNode);
+        }
+    }
+
+    for (int goalNode: goalClusterNodes)
+    {
+        mGoalNodeCosts[goalNode] = -1;
+    }
+
+    if (!goalReached)
+        return false;
+
+    int lastNode = mNodeStates[goalNodeIndex].mParent;
+    if (lastNode == -1)
+        return true; // direct path is already in output
+
+    // refine abstract path into cells
+    std::vector<int> pathNodes;
+    for (int pathNode = lastNode; pathNode != -1; pathNode = mNodeStates[pathNode].mParent)
+    {
+        pathNodes.push_back(mNodes[pathNode].mCell);
+    }
+    pathNodes.push_back(startCell);
+    std::reverse(pathNodes.begin(), pathNodes.end());
+    pathNodes.push_back(goalCell);
+
+    outCells.clear();
+    outCells.push_back(startCell);
+    for (size_t inode = 1; inode < pathNodes.size(); ++inode)
+    {
+        int prevCell = pathNodes[inode - 1];
+        int currCell = pathNodes[inode];
+        if (prevCell == currCell)
+            continue;
+
+        int prevCluster = GetCellCluster(prevCell);
+        if (prevCluster != GetCellCluster(currCell))
+        {
+            // transition between clusters, cells are neighbours
+            outCells.push_back(currCell);
+            continue;
+        }
+
+        if (SearchCells(prevCell, currCell, prevCluster, &mSegmentCells) == -1)
+        {
+            cxx_assert(false);
+            return false;
+        }
+        outCells.insert(outCells.end(), mSegmentCells.begin() + 1, mSegmentCells.end());
+    }
+    return true;
+}
+
+void AiPathfinder::ConvertToWaypoints(const std::vector<int>& pathCells, std::vector<Point>& outWaypoints) const
+{
+    outWaypoints.clear();
+
+    const int NumCells = (int) pathCells.size();
+    for (int icell = 1; icell < NumCells; ++icell)
+    {
+        int currCell = pathCells[icell];
+        if (icell < NumCells - 1)
+        {
+            int prevStep = currCell - pathCells[icell - 1];
+            int nextStep = pathCells[icell + 1] - currCell;
+            if (prevStep == nextStep)
+                continue;
+        }
+        outWaypoints.emplace_back(currCell % MAP_DIMENSIONS, currCell / MAP_DIMENSIONS);
+    }
+}
+
+bool AiPathfinder::IsPathContinuous(const std::vector<int>& pathCells, int startCell, int goalCell) const
+{
+    if (pathCells.empty() || (pathCells.front() != startCell) || (pathCells.back() != goalCell))
+        return false;
+
+    for (size_t icell = 1; icell < pathCells.size(); ++icell)
+    {
+        const int prevCell = pathCells[icell - 1];
+        const int currCell = pathCells[icell];
+        const NavCell& prevNavCell = mNavCells[prevCell];
+
+        bool isLinked = false;
+        for (int ineighbour = 0; ineighbour < NumPathNeighbours; ++ineighbour)
+        {
+            Point neighbourCoord (prevCell % MAP_DIMENSIONS + PathNeighbourOffsets[ineighbour].x, prevCell / MAP_DIMENSIONS + PathNeighbourOffsets[ineighbour].y);
+            if (neighbourCoord.x < 0 || neighbourCoord.x >= MAP_DIMENSIONS || neighbourCoord.y < 0 || neighbourCoord.y >= MAP_DIMENSIONS)
+                continue;
+
+            if ((GetCellIndex(neighbourCoord.x, neighbourCoord.y) == currCell) && (prevNavCell.mLinks & BIT(ineighbour)))
+            {
+                isLinked = true;
+                break;
+            }
+        }
+        if (!isLinked)
+            return false;
+    }
+    return true;
+}
+
+void AiPathfinder::RunBenchmark(int numQueries)
+{
+    std::vector<int> walkableCells;
+    for (int icell = 0, NumCells = (int) mNavCells.size(); icell < NumCells; ++icell)
+    {
+        if (mNavCells[icell].mWeight > 0)
+        {
+            walkableCells.push_back(icell);
+        }
+    }
+
+    if (walkableCells.empty() || (numQueries < 1))
+    {
+        gSystem.LogMessage(eLogMessage_Warning, "Pathfinding benchmark requires loaded map");
+        return;
+    }
+
+    // same queries on each run
+    cxx::randomizer random;
+    random.set_seed(1);
+
+    std::vector<std::pair<int, int>> queries(numQueries);
+    for (std::pair<int, int>& currQuery: queries)
+    {
+        currQuery.first = walkableCells[random.generate_int(0, (int) walkableCells.size() - 1)];
+        currQuery.second = walkableCells[random.generate_int(0, (int) walkableCells.size() - 1)];
+    }
+
+    std::vector<int> pathCells;
+
+    // hierarchical
+    int hierarchicalFound = 0;
+    mExpandedCount = 0;
+    double startTime = gSystem.GetSystemSeconds();
+    for (const std::pair<int, int>& currQuery: queries)
+    {
+        if (SearchHierarchical(currQuery.first, currQuery.second, pathCells))
+        {
+            ++hierarchicalFound;
+        }
+    }
+    double hierarchicalTime = gSystem.GetSystemSeconds() - startTime;
+    int hierarchicalExpanded = mExpandedCount;
+
+    // plain grid
+    int gridFound = 0;
+    mExpandedCount = 0;
+    startTime = gSystem.GetSystemSeconds();
+    for (const std::pair<int, int>& currQuery: queries)
+    {
+        if (SearchCells(currQuery.first, currQuery.second, -1, &pathCells) != -1)
+        {
+            ++gridFound;
+        }
+    }
+    double gridTime = gSystem.GetSystemSeconds() - startTime;
+    int gridExpanded = mExpandedCount;
+
+    // validate paths as they are returned to ai
+    std::vector<Point> pathWaypoints;
+    int brokenPaths = 0;
+    for (const std::pair<int, int>& currQuery: queries)
+    {
+        Point startBlock (currQuery.first % MAP_DIMENSIONS, currQuery.first / MAP_DIMENSIONS);
+        Point goalBlock (currQuery.second % MAP_DIMENSIONS, currQuery.second / MAP_DIMENSIONS);
+        if (!FindPath(startBlock, goalBlock, pathWaypoints))
+            continue;
+
+        if (!IsPathContinuous(mTempCells, currQuery.first, currQuery.second))
+        {
+            ++brokenPaths;
+        }
+    }
+
+    mExpandedCount = 0;
+
+    gSystem.LogMessage(eLogMessage_Info, "Pathfinding benchmark: %d queries, %d found", numQueries, hierarchicalFound);
+    gSystem.LogMessage(eLogMessage_Info, "Hierarchical: %.0f queries/sec, %d expanded per query",
+        (hierarchicalTime > 0.0) ? (numQueries / hierarchicalTime) : 0.0, hierarchicalExpanded / numQueries);
+    gSystem.LogMessage(eLogMessage_Info, "Grid: %.0f queries/sec, %d expanded per query",
+        (gridTime > 0.0) ? (numQueries / gridTime) : 0.0, gridExpanded / numQueries);
+    gSystem.LogMessage(eLogMessage_Info, "Shared requests since map load: %d", mSharedRequestsCount);
+
+    if (gridFound != hierarchicalFound)
+    {
+        gSystem.LogMessage(eLogMessage_Warning, "Pathfinding benchmark results mismatch (grid found %d)", gridFound);
+    }
+    if (brokenPaths > 0)
+    {
+        gSystem.LogMessage(eLogMessage_Warning, "Pathfinding benchmark found %d broken paths", brokenPaths);
+    }
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "GameDefs.h"
+
+// forwards
+class GameMap;
+
+// number of block neighbours used for navigation, straight ones go first in order N, E, S, W, then NE, SE, SW, NW
+const int AiPathNeighboursCount = 8;
+
+// pathfinding query status
+enum eAiPathStatus
+{
+    eAiPathStatus_None, // query is unknown or was evicted from cache
+    eAiPathStatus_Pending, // query is waiting in queue
+    eAiPathStatus_Success,
+    eAiPathStatus_Failed,
+};
+
+// defines pedestrians pathfinding service on top surface map blocks
+// hierarchical A* is used, map is split into clusters connected via entrances on cluster borders,
+// paths between entrances within cluster are precomputed on map load
+// queries are processed serially with per frame budget, queries with identical endpoints share single result
+class AiPathfinder final: public cxx::noncopyable
+{
+public:
+    // Build navigation data for currently loaded map
+    // @param gameMap: Source map data
+    void BuildFromMap(const GameMap& gameMap);
+    void Cleanup();
+
+    // Process pending queries within per frame budget, not thread-safe
+    void UpdateFrame();
+
+    // Get query identifier for path between two map blocks
+    // @param startBlock, goalBlock: Map blocks coordinates
+    static unsigned int GetQueryKey(const Point& startBlock, const Point& goalBlock);
+
+    // Queue path query, does nothing if query with same key is already pending or completed, not thread-safe
+    // @param queryKey: Query identifier
+    void RequestPath(unsigned int queryKey);
+
+    // Get current status of path query
+    // @param queryKey: Query identifier
+    eAiPathStatus GetPathStatus(unsigned int queryKey) const;
+
+    // Get waypoints of completed path query, last waypoint is goal block
+    // @param queryKey: Query identifier
+    // @param outWaypoints: Output map blocks where path changes its direction
+    // @returns false if query is not completed successfully
+    bool GetPathWaypoints(unsigned int queryKey, std::vector<Point>& outWaypoints) const;
+
+    // Find path immediately, not thread-safe
+    // @param startBlock, goalBlock: Map blocks coordinates
+    // @param outWaypoints: Output map blocks where path changes its direction
+    // @returns false if there is no path
+    bool FindPath(const Point& startBlock, const Point& goalBlock, std::vector<Point>& outWaypoints);
+
+    // Test whether pedestrians can walk on top surface of map block
+    // @param coordx, coordz: Block location
+    bool IsWalkableBlock(int coordx, int coordz) const;
+
+    // Get ground type of top surface of map block
+    // @param coordx, coordz: Block location
+    eGroundType GetBlockGroundType(int coordx, int coordz) const;
+
+    // Get mask of neighbours reachable from map block, bit index is neighbour index
+    // @param coordx, coordz: Block location
+    unsigned char GetBlockLinks(int coordx, int coordz) const;
+
+    // Get cost of single step from map block to its neighbour, neighbour should be reachable
+    // @param block: Block location
+    // @param neighbourIndex: Neighbour index
+    int GetStepCost(const Point& block, int neighbourIndex) const;
+
+    // Get offset from block to its neighbour
+    // @param neighbourIndex: Neighbour index
+    static const Point& GetNeighbourOffset(int neighbourIndex);
+
+    // Measure hierarchical and plain grid search speed on random queries, results are printed to log
+    // @param numQueries: Number of random queries
+    void RunBenchmark(int numQueries);
+
+private:
+    // top surface map block navigation info
+    struct NavCell
+    {
+    public:
+        eGroundType mGroundType = eGroundType_Air;
+        unsigned char mWeight = 0; // step cost multiplier, 0 if cell is not walkable
+        unsigned char mLinks = 0; // walkable neighbours mask, in order of neighbour offsets
+    };
+
+    // cluster border transition point
+    struct AbstractNode
+    {
+    public:
+        int mCell = 0;
+        int mCluster = 0;
+        int mFirstEdge = 0; // index of first outgoing edge, outgoing edges are stored contiguously
+        int mEdgesCount = 0;
+    };
+
+    struct AbstractEdge
+    {
+    public:
+        int mTargetNode = 0;
+        int mCost = 0;
+    };
+
+    // completed or pending path query
+    struct PathQuery
+    {
+    public:
+        eAiPathStatus mStatus = eAiPathStatus_Pending;
+        std::vector<Point> mWaypoints;
+    };
+
+    // open list entry
+    struct OpenElement
+    {
+    public:
+        inline bool operator > (const OpenElement& other) const { return mScore > other.mScore; }
+    public:
+        int mScore = 0;
+        int mIndex = 0;
+    };
+
+    // per element search state, reset lazily with search stamp
+    struct SearchState
+    {
+    public:
+        unsigned int mStamp = 0;
+        int mCost = 0;
+        int mParent = -1;
+        bool mClosed = false;
+    };
+
+    inline int GetCellIndex(int coordx, int coordz) const
+    {
+        return (coordz * MAP_DIMENSIONS) + coordx;
+    }
+    int GetCellCluster(int cellIndex) const;
+    int GetHeuristicCost(int cellA, int cellB) const;
+    int GetStepCost(int cellA, int cellB, int neighbourIndex) const;
+
+    // Create cluster border nodes and edges between them
+    void BuildAbstractGraph();
+    int GetOrCreateNode(int cellIndex, std::vector<std::vector<AbstractEdge>>& nodeEdges);
+
+    // Search cells within cluster bounds, when goal cell is -1 all reachable cells are visited
+    // @param clusterIndex: Search bounds, -1 means whole map
+    // @returns path cost or -1 if goal is not reachable
+    int SearchCells(int startCell, int goalCell, int clusterIndex, std::vector<int>* outCells);
+
+    // Search path using precomputed cluster graph
+    // @returns false if there is no path
+    bool SearchHierarchical(int startCell, int goalCell, std::vector<int>& outCells);
+
+    void ConvertToWaypoints(const std::vector<int>& pathCells, std::vector<Point>& outWaypoints) const;
+
+    // Check that path goes from start to goal cell through linked neighbour cells
+    bool IsPathContinuous(const std::vector<int>& pathCells, int startCell, int goalCell) const;
+    void NextSearchStamp(std::vector<SearchState>& searchStates, unsigned int& searchStamp);
+
+private:
+    std::vector<NavCell> mNavCells; // MAP_DIMENSIONS * MAP_DIMENSIONS
+    std::vector<int> mCellNodes; // abstract node index for each cell, -1 if none
+    std::vector<AbstractNode> mNodes;
+    std::vector<AbstractEdge> mEdges;
+    std::vector<std::vector<int>> mClusterNodes; // abstract nodes of each cluster
+
+    // queries
+    std::map<unsigned int, PathQuery> mQueries;
+    std::deque<unsigned int> mPendingQueries;
+    std::deque<unsigned int> mCompletedQueries; // in order of completion, oldest get evicted first
+    int mSharedRequestsCount = 0;
+
+    // search context
+    std::vector<SearchState> mCellStates;
+    std::vector<SearchState> mNodeStates;
+    std::vector<OpenElement> mOpenList;
+    std::vector<int> mTempCells;
+    std::vector<int> mSegmentCells; // refined path segment, never same as output cells
+    std::vector<int> mGoalNodeCosts;
+    unsigned int mCellsSearchStamp = 0;
+    unsigned int mNodesSearchStamp = 0;
+    int mExpandedCount = 0; // number of expanded elements since last reset, used for budgeting
+};
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "AiPedestrianBehavior.h"
 #include "Pedestrian.h"
+#include "Vehicle.h"
 #include "AiCharacterController.h"
 #include "MapDirection2D.h"
 #include "GtaOneGame.h"
@@ -33,6 +34,15 @@ void AiPedestrianBehavior::AiActivity::StartActivity()
     }
 }
 
+void AiPedestrianBehavior::AiActivity::ResetActivity()
+{
+    cxx_assert(!IsStatusInProgress());
+
+    mActivityStatus = eAiActivityStatus_New;
+    mParentActivity = nullptr;
+    mChildActivity = nullptr;
+}
+
 void AiPedestrianBehavior::AiActivity::UpdateActivity()
 {
     if (IsStatusInProgress())
@@ -153,8 +163,12 @@ void AiPedestrianBehavior::AiActiviy_Wander::OnActivityUpdate()
     // decide what to do
     if (!IsChildActivityInProgress(act_walk))
     {
+        // sometimes go somewhere further
+        const int RemotePointChance = 20;
+        bool usePathfinding = mAiBehavior->mRandom.random_chance(RemotePointChance) && ChooseRemotePoint(eGroundType_Pawement);
+
         // try walk somewhere
-        if (!ChooseDesiredPoint(eGroundType_Pawement))
+        if (!usePathfinding && !ChooseDesiredPoint(eGroundType_Pawement))
         {
             SetActivityStatus(eAiActivityStatus_Failed);
             return;
@@ -162,6 +176,7 @@ void AiPedestrianBehavior::AiActiviy_Wander::OnActivityUpdate()
         const float ArriveDistance = gGame.mParams.mPedestrianBoundsSphereRadius * 2.0f;
         act_walk->SetRunning(false);
         act_walk->SetArriveDistance(ArriveDistance);
+        act_walk->SetUsePathfinding(usePathfinding);
         StartChildActivity(act_walk);
     }
 }
@@ -211,13 +226,39 @@ bool AiPedestrianBehavior::AiActiviy_Wander::ChooseDesiredPoint(eGroundType grou
     }
 
     // choose random point within block
-    float randomSubPosx = gGame.mRandom.generate_float(0.1f, 0.9f);
-    float randomSubPosy = gGame.mRandom.generate_float(0.1f, 0.9f);
+    float randomSubPosx = mAiBehavior->mRandom.generate_float(0.1f, 0.9f);
+    float randomSubPosy = mAiBehavior->mRandom.generate_float(0.1f, 0.9f);
     mAiBehavior->mDesiredPoint.x = Convert::MapUnitsToMeters(logPosition.x * 1.0f) + Convert::MapUnitsToMeters(randomSubPosx);
     mAiBehavior->mDesiredPoint.y = Convert::MapUnitsToMeters(logPosition.z * 1.0f) + Convert::MapUnitsToMeters(randomSubPosy);
     return true;
 }
 
+bool AiPedestrianBehavior::AiActiviy_Wander::ChooseRemotePoint(eGroundType groundType)
+{
+    Pedestrian* character = mAiBehavior->GetCharacter();
+    cxx_assert(character);
+
+    const int SearchRadius = 8;
+    const int MaxAttempts = 4;
+
+    glm::ivec3 logPosition = Convert::MetersToMapUnits(character->mTransform.mPosition);
+    for (int iattempt = 0; iattempt < MaxAttempts; ++iattempt)
+    {
+        int coordx = logPosition.x + mAiBehavior->mRandom.generate_int(-SearchRadius, SearchRadius);
+        int coordz = logPosition.z + mAiBehavior->mRandom.generate_int(-SearchRadius, SearchRadius);
+        if (gGame.mPathfinder.GetBlockGroundType(coordx, coordz) != groundType)
+            continue;
+
+        // choose random point within block
+        float randomSubPosx = mAiBehavior->mRandom.generate_float(0.1f, 0.9f);
+        float randomSubPosy = mAiBehavior->mRandom.generate_float(0.1f, 0.9f);
+        mAiBehavior->mDesiredPoint.x = Convert::MapUnitsToMeters(coordx * 1.0f) + Convert::MapUnitsToMeters(randomSubPosx);
+        mAiBehavior->mDesiredPoint.y = Convert::MapUnitsToMeters(coordz * 1.0f) + Convert::MapUnitsToMeters(randomSubPosy);
+        return true;
+    }
+    return false;
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 AiPedestrianBehavior::AiActivity_Runaway::AiActivity_Runaway(AiPedestrianBehavior* aiBehavior)
@@ -242,12 +283,33 @@ void AiPedestrianBehavior::AiActivity_Runaway::OnActivityUpdate()
         const float ArriveDistance = gGame.mParams.mPedestrianBoundsSphereRadius * 2.0f;
         act_walk->SetRunning(true);
         act_walk->SetArriveDistance(ArriveDistance);
+        act_walk->SetUsePathfinding(false);
         StartChildActivity(act_walk);
     }
 }
 
 bool AiPedestrianBehavior::AiActivity_Runaway::ChooseRunawayPoint()
 {
+    // all pedestrians scared by same threat share single flee field
+    if (mAiBehavior->CheckMemoryBits(AiBehaviorMemoryBits_ThreatLocated))
+    {
+        glm::vec2 threatPosition = Convert::MetersToMapUnits(mAiBehavior->mThreatPoint);
+        Point threatBlock ((int) threatPosition.x, (int) threatPosition.y);
+
+        // keep field alive
+        int threatBlockIndex = (glm::clamp(threatBlock.y, 0, MAP_DIMENSIONS - 1) * MAP_DIMENSIONS) + glm::clamp(threatBlock.x, 0, MAP_DIMENSIONS - 1);
+        mAiBehavior->mAiController->PushCommand(AiCommand(eAiCommand_RequestFleeField, nullptr, threatBlockIndex));
+
+        Pedestrian* character = mAiBehavior->GetCharacter();
+        glm::vec2 characterPosition = character->mTransform.GetPosition2();
+        glm::vec2 fleeDirection;
+        if (gGame.mFlowFields.SampleDirection(AiFlowFields::GetFleeFieldKey(threatBlock), characterPosition, fleeDirection))
+        {
+            mAiBehavior->mDesiredPoint = characterPosition + fleeDirection * Convert::MapUnitsToMeters(1.0f);
+            return true;
+        }
+    }
+
     if (ChooseDesiredPoint(eGroundType_Pawement) || ChooseDesiredPoint(eGroundType_Field) ||
         ChooseDesiredPoint(eGroundType_Road) || ChooseDesiredPoint(eGroundType_Air))
     {
@@ -321,8 +383,18 @@ void AiPedestrianBehavior::AiActivity_FollowLeader::OnActivityUpdate()
             return;
         }
 
-        mAiBehavior->mDesiredPoint = charPosition + glm::normalize(leaderPosition - charPosition) * StepDistance;
+        // followers of same leader share single flow field, it leads around obstacles
+        glm::vec2 moveDirection = glm::normalize(leaderPosition - charPosition);
+        glm::vec2 fieldDirection;
+        if (gGame.mFlowFields.SampleDirection(AiFlowFields::GetFollowFieldKey(leadCharacter->mObjectID), charPosition, fieldDirection))
+        {
+            moveDirection = fieldDirection;
+        }
+        mAiBehavior->mAiController->PushCommand(AiCommand(eAiCommand_RequestFollowField, leadCharacter));
+
+        mAiBehavior->mDesiredPoint = charPosition + moveDirection * StepDistance;
         act_walk->SetArriveDistance(ApproachDistance);
+        act_walk->SetUsePathfinding(false);
         StartChildActivity(act_walk);
     }
 
@@ -349,6 +421,167 @@ bool AiPedestrianBehavior::AiActivity_FollowLeader::CheckCanFollowTheLeader() co
 
 //////////////////////////////////////////////////////////////////////////
 
+AiPedestrianBehavior::AiActivity_DriveCar::AiActivity_DriveCar(AiPedestrianBehavior* aiBehavior)
+    : AiActivity(aiBehavior)
+{
+}
+
+void AiPedestrianBehavior::AiActivity_DriveCar::OnActivityStart()
+{
+    mLaneEdge = -1;
+    mNextLaneEdge = -1;
+
+    OnActivityUpdate();
+}
+
+void AiPedestrianBehavior::AiActivity_DriveCar::OnActivityUpdate()
+{
+    Pedestrian* character = mAiBehavior->GetCharacter();
+    cxx_assert(character);
+
+    PedestrianCtlState& ctlState = mAiBehavior->mAiController->mCtlState;
+    ctlState.Clear();
+
+    Vehicle* car = character->mCurrentCar;
+    if ((car == nullptr) || !character->IsCarDriver())
+    {
+        SetActivityStatus(eAiActivityStatus_Failed);
+        return;
+    }
+
+    if (car->IsWrecked())
+        return;
+
+    glm::vec2 carPosition = car->mTransform.GetPosition2();
+    RoadLocation location;
+    if (!gGame.mRoadTraffic.LocateCar(carPosition, car->mTransform.GetDirectionVector(), location))
+    {
+        // off road or dead end, just stop
+        mLaneEdge = -1;
+        ctlState.mHandBrake = true;
+        return;
+    }
+
+    UpdateRoute(location);
+
+    const RoadNetwork& roadNetwork = gGame.mRoadNetwork;
+    const RoadEdge& roadEdge = roadNetwork.mEdges[mLaneEdge];
+
+    // head to center of next block on route
+    RoadBlock targetBlock;
+    if ((location.mBlockIndex + 1) < roadEdge.mBlocksCount)
+    {
+        targetBlock = roadNetwork.mLaneBlocks[roadEdge.mFirstBlock + location.mBlockIndex + 1];
+    }
+    else
+    {
+        targetBlock = roadNetwork.mNodes[roadEdge.mEndNode].mBlock;
+    }
+
+    glm::vec2 targetPosition(Convert::MapUnitsToMeters(targetBlock.mX + 0.5f), Convert::MapUnitsToMeters(targetBlock.mZ + 0.5f));
+    glm::vec2 toTarget = targetPosition - carPosition;
+    if (glm::length2(toTarget) > 0.0001f)
+    {
+        const float SteerLockDegrees = 30.0f;
+
+        cxx::angle_t targetAngle = cxx::angle_t::from_radians(::atan2f(toTarget.y, toTarget.x));
+        float steerDegrees = (targetAngle - car->mTransform.mOrientation).to_degrees_normalize_180();
+        ctlState.mSteerDirection = glm::clamp(steerDegrees / SteerLockDegrees, -1.0f, 1.0f);
+    }
+
+    // keep speed
+    const float SpeedTolerance = 0.5f;
+
+    float desiredSpeed = GetDesiredSpeed(location, gGame.mRoadTraffic.GetLaneDistance(location, carPosition));
+    float currentSpeed = car->GetCurrentSpeed();
+    if (desiredSpeed < SpeedTolerance)
+    {
+        // brake until stops, negative acceleration would move car in reverse after that
+        if (currentSpeed > SpeedTolerance)
+        {
+            ctlState.mAcceleration = -1.0f;
+        }
+        else
+        {
+            ctlState.mHandBrake = true;
+        }
+    }
+    else if (currentSpeed < (desiredSpeed - SpeedTolerance))
+    {
+        ctlState.mAcceleration = 1.0f;
+    }
+    else if (currentSpeed > (desiredSpeed + SpeedTolerance))
+    {
+        ctlState.mAcceleration = -1.0f;
+    }
+}
+
+void AiPedestrianBehavior::AiActivity_DriveCar::OnActivityCancelled()
+{
+    PedestrianCtlState& ctlState = mAiBehavior->mAiController->mCtlState;
+    ctlState.Clear();
+}
+
+void AiPedestrianBehavior::AiActivity_DriveCar::UpdateRoute(RoadLocation& location)
+{
+    const RoadNetwork& roadNetwork = gGame.mRoadNetwork;
+
+    if (location.mEdgeIndex == mLaneEdge)
+        return;
+
+    // lane at junction is guessed by heading, stick to chosen one
+    bool isOnRoute = (location.mEdgeIndex == mNextLaneEdge) || ((mNextLaneEdge != -1) && (location.mBlockIndex == -1) &&
+        (roadNetwork.mEdges[mNextLaneEdge].mStartNode == roadNetwork.mEdges[location.mEdgeIndex].mStartNode));
+
+    if (isOnRoute)
+    {
+        location.mEdgeIndex = mNextLaneEdge;
+    }
+    mLaneEdge = location.mEdgeIndex;
+
+    // junction decision is made once when entering lane
+    mNextLaneEdge = roadNetwork.GetRandomSuccessor(mLaneEdge, mAiBehavior->mRandom);
+}
+
+float AiPedestrianBehavior::AiActivity_DriveCar::GetDesiredSpeed(const RoadLocation& location, float laneDistance) const
+{
+    const RoadNetwork& roadNetwork = gGame.mRoadNetwork;
+    const AiRoadTraffic& roadTraffic = gGame.mRoadTraffic;
+    const RoadEdge& roadEdge = roadNetwork.mEdges[mLaneEdge];
+
+    float desiredSpeed = gGame.mParams.mAiDriverCruiseSpeed;
+
+    float laneRemaining = Convert::MapUnitsToMeters(roadTraffic.GetLaneLength(mLaneEdge) - laneDistance);
+    if (mNextLaneEdge == -1)
+    {
+        // dead end ahead
+        desiredSpeed = std::min(desiredSpeed, laneRemaining / gGame.mParams.mAiDriverTimeGap);
+    }
+    else if (roadNetwork.mEdges[mNextLaneEdge].mStartDirection != roadEdge.mEndDirection)
+    {
+        // slow down before turn
+        const float TurnBrakeDistance = Convert::MapUnitsToMeters(2.0f);
+        if (laneRemaining < TurnBrakeDistance)
+        {
+            desiredSpeed = std::min(desiredSpeed, gGame.mParams.mAiDriverTurnSpeed);
+        }
+    }
+
+    // keep gap to car ahead, time gap is applied on top of its speed
+    Pedestrian* character = mAiBehavior->GetCharacter();
+    float carAheadDistance = 0.0f;
+    float carAheadSpeed = 0.0f;
+    if (roadTraffic.FindCarAhead(mLaneEdge, laneDistance, mNextLaneEdge, character->mCurrentCar, 
+        Convert::MetersToMapUnits(gGame.mParams.mAiDriverLookAheadDistance), carAheadDistance, carAheadSpeed))
+    {
+        float freeDistance = std::max(Convert::MapUnitsToMeters(carAheadDistance) - gGame.mParams.mAiDriverMinGap, 0.0f);
+        desiredSpeed = std::min(desiredSpeed, std::max(carAheadSpeed, 0.0f) + (freeDistance / gGame.mParams.mAiDriverTimeGap));
+    }
+    return desiredSpeed;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 AiPedestrianBehavior::AiActivity_WalkToPoint::AiActivity_WalkToPoint(AiPedestrianBehavior* aiBehavior)
     : AiActivity(aiBehavior)
 {
@@ -364,8 +597,28 @@ void AiPedestrianBehavior::AiActivity_WalkToPoint::SetArriveDistance(float arriv
     mArriveDistance = arriveDistance;
 }
 
+void AiPedestrianBehavior::AiActivity_WalkToPoint::SetUsePathfinding(bool usePathfinding)
+{
+    mUsePathfinding = usePathfinding;
+}
+
 void AiPedestrianBehavior::AiActivity_WalkToPoint::OnActivityStart()
 {
+    mPathWaypoints.clear();
+    mCurrentWaypoint = 0;
+    mWaitingForPath = false;
+
+    if (mUsePathfinding)
+    {
+        RequestPath();
+        if (mWaitingForPath)
+        {
+            // query result will be available on next update
+            mAiBehavior->mAiController->mCtlState.Clear();
+            return;
+        }
+    }
+
     if (ContinueWalk())
     {
         SetActivityStatus(eAiActivityStatus_Success);
@@ -400,8 +653,38 @@ bool AiPedestrianBehavior::AiActivity_WalkToPoint::ContinueWalk()
     if (glm::distance2(currentPos2, mAiBehavior->mDesiredPoint) <= tolerance2)
         return true; // done
 
+    if (mWaitingForPath)
+    {
+        eAiPathStatus pathStatus = gGame.mPathfinder.GetPathStatus(mPathQueryKey);
+        if (pathStatus == eAiPathStatus_Pending)
+            return false; // stand still
+
+        mWaitingForPath = false;
+        if (pathStatus == eAiPathStatus_Failed)
+        {
+            SetActivityStatus(eAiActivityStatus_Failed);
+            return false;
+        }
+        // walk straight if query result was evicted
+        gGame.mPathfinder.GetPathWaypoints(mPathQueryKey, mPathWaypoints);
+    }
+
+    glm::vec2 targetPos2 = mAiBehavior->mDesiredPoint;
+    if (mCurrentWaypoint < ((int) mPathWaypoints.size() - 1))
+    {
+        const float WaypointReachDistance = Convert::MapUnitsToMeters(0.3f);
+
+        const Point& waypoint = mPathWaypoints[mCurrentWaypoint];
+        targetPos2.x = Convert::MapUnitsToMeters(waypoint.x + 0.5f);
+        targetPos2.y = Convert::MapUnitsToMeters(waypoint.y + 0.5f);
+        if (glm::distance2(currentPos2, targetPos2) <= (WaypointReachDistance * WaypointReachDistance))
+        {
+            ++mCurrentWaypoint;
+        }
+    }
+
     // setup sign direction
-    glm::vec2 toTarget = glm::normalize(mAiBehavior->mDesiredPoint - currentPos2);
+    glm::vec2 toTarget = glm::normalize(targetPos2 - currentPos2);
     ctlState.mDesiredRotationAngle = cxx::angle_t::from_radians(::atan2f(toTarget.y, toTarget.x));
     ctlState.mRotateToDesiredAngle = true;
     ctlState.mWalkForward = true;
@@ -410,6 +693,22 @@ bool AiPedestrianBehavior::AiActivity_WalkToPoint::ContinueWalk()
     return false;
 }
 
+void AiPedestrianBehavior::AiActivity_WalkToPoint::RequestPath()
+{
+    Pedestrian* character = mAiBehavior->GetCharacter();
+    cxx_assert(character);
+
+    glm::ivec3 startBlock = Convert::MetersToMapUnits(character->mTransform.mPosition);
+    glm::ivec2 goalBlock = Convert::MetersToMapUnits(mAiBehavior->mDesiredPoint);
+    if ((startBlock.x == goalBlock.x) && (startBlock.z == goalBlock.y))
+        return;
+
+    // pathfinder cannot be accessed in think phase, query will be processed after it
+    mPathQueryKey = AiPathfinder::GetQueryKey(Point(startBlock.x, startBlock.z), goalBlock);
+    mAiBehavior->mAiController->PushCommand(AiCommand(eAiCommand_RequestPath, nullptr, (int) mPathQueryKey));
+    mWaitingForPath = true;
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 AiPedestrianBehavior::AiActivity_Wait::AiActivity_Wait(AiPedestrianBehavior* aiBehavior)
@@ -427,7 +726,7 @@ void AiPedestrianBehavior::AiActivity_Wait::OnActivityStart()
     PedestrianCtlState& ctlState = mAiBehavior->mAiController->mCtlState;
     ctlState.Clear();
 
-    mStartTime = gGame.mTimeMng.mGameTime;
+    mWaitTimer = 0.0f;
 }
 
 void AiPedestrianBehavior::AiActivity_Wait::OnActivityUpdate()
@@ -438,8 +737,8 @@ void AiPedestrianBehavior::AiActivity_Wait::OnActivityUpdate()
     // check wait time
     if (mWaitSeconds > 0.0f)
     {
-        float currentTime = gGame.mTimeMng.mGameTime;
-        if (currentTime > (mStartTime += mWaitSeconds))
+        mWaitTimer += mAiBehavior->mUpdateDeltaTime;
+        if (mWaitTimer > mWaitSeconds)
         {
             mWaitSeconds = 0.0f;
             SetActivityStatus(eAiActivityStatus_Success);
@@ -450,23 +749,53 @@ void AiPedestrianBehavior::AiActivity_Wait::OnActivityUpdate()
 
 //////////////////////////////////////////////////////////////////////////
 
-AiPedestrianBehavior::AiPedestrianBehavior(AiCharacterController* aiController, eAiPedestrianBehavior behaviorID)
-    : mAiController(aiController)
-    , mBehaviorID(behaviorID)
+AiPedestrianBehavior::AiPedestrianBehavior(eAiPedestrianBehavior behaviorID)
+    : mBehaviorID(behaviorID)
     , mDesiredPoint()
+    , mThreatPoint()
     , mActivity_Wander(this)
     , mActivity_Runaway(this)
     , mActivity_FollowLeader(this)
+    , mActivity_DriveCar(this)
     , mActivity_WalkToPoint(this)
     , mActivity_Wait(this)
 {
-    cxx_assert(mAiController);
 }
 
 AiPedestrianBehavior::~AiPedestrianBehavior()
 {
 }
 
+void AiPedestrianBehavior::ResetBehavior(AiCharacterController* aiController)
+{
+    cxx_assert(aiController);
+    cxx_assert(mCurrentActivity == nullptr);
+
+    mAiController = aiController;
+    mDesiredActivity = nullptr;
+    mUpdateDeltaTime = 0.0f;
+
+    mMemoryBits = AiBehaviorMemoryBits_None;
+    mBehaviorBits = AiBehaviorBits_CanJump | AiBehaviorBits_Fear_GunShots | AiBehaviorBits_Fear_Explosions;
+
+    mDesiredPoint = glm::vec2();
+    mThreatPoint = glm::vec2();
+    mLeader.reset();
+
+    mRandom.set_seed((unsigned int) gGame.mRandom.generate_int());
+    // spread perception scans of different characters across frames
+    mPerceptionTimer = mRandom.generate_float(0.0f, gGame.mParams.mAiPerceptionInterval);
+
+    mActivity_Wander.ResetActivity();
+    mActivity_Runaway.ResetActivity();
+    mActivity_FollowLeader.ResetActivity();
+    mActivity_DriveCar.ResetActivity();
+    mActivity_WalkToPoint.ResetActivity();
+    mActivity_Wait.ResetActivity();
+
+    OnResetBehavior();
+}
+
 void AiPedestrianBehavior::ActivateBehavior()
 {
     cxx_assert(mAiController);
@@ -491,10 +820,19 @@ void AiPedestrianBehavior::ShutdownBehavior()
     mDesiredActivity = nullptr;
 }
 
-void AiPedestrianBehavior::UpdateBehavior()
+void AiPedestrianBehavior::UpdateBehavior(float deltaTime)
 {
-    ScanForThreats();
-    ScanForLeader();
+    mUpdateDeltaTime = deltaTime;
+
+    // perception is amortized, memory bits stay valid until next scan
+    mPerceptionTimer -= deltaTime;
+    if (mPerceptionTimer <= 0.0f)
+    {
+        mPerceptionTimer = std::max(mPerceptionTimer + gGame.mParams.mAiPerceptionInterval, 0.0f);
+
+        ScanForThreats();
+        ScanForLeader();
+    }
 
     ChooseDesiredActivity();
 
@@ -572,16 +910,27 @@ void AiPedestrianBehavior::SetLeader(Pedestrian* pedestrian)
     mLeader = pedestrian;
 }
 
+void AiPedestrianBehavior::ResetLeader()
+{
+    mLeader.reset();
+}
+
 void AiPedestrianBehavior::ChooseDesiredActivity()
 {
+    Pedestrian* character = GetCharacter();
+    cxx_assert(character);
+    if (character->IsCarDriver())
+    {
+        mDesiredActivity = &mActivity_DriveCar;
+        return;
+    }
+
     if (CheckMemoryBits(AiBehaviorMemoryBits_InPanic))
     {
         mDesiredActivity = &mActivity_Runaway;
         return;
     }
 
-    Pedestrian* character = GetCharacter();
-    cxx_assert(character);
     if (character->HasFear_Explosions() && CheckMemoryBits(AiBehaviorMemoryBits_HearExplosion))
     {
         ChangeMemoryBits(AiBehaviorMemoryBits_InPanic, AiBehaviorMemoryBits_None);
@@ -615,19 +964,20 @@ void AiPedestrianBehavior::ScanForThreats()
         return;
 
     AiBehaviorMemoryBits enableMemoryBits = AiBehaviorMemoryBits_None;
-    BroadcastEvent eventData;
     glm::vec2 characterPos2 = character->mTransform.GetPosition2();
     // check gunshots
     {
         for (BroadcastEventsIterator eventsIter;;)
         {
-            if (!eventsIter.NextEventInDistance(eBroadcastEvent_GunShot, characterPos2, gGame.mParams.mAiReactOnGunshotsDistance, eventData))
+            const BroadcastEvent* eventData = eventsIter.NextEventInDistance(eBroadcastEvent_GunShot, characterPos2, gGame.mParams.mAiReactOnGunshotsDistance);
+            if (eventData == nullptr)
                 break;
 
-            if (eventData.mCharacter == character)// hear own gunshots
+            if (eventData->mCharacter == character)// hear own gunshots
                 continue;
 
-            enableMemoryBits = (enableMemoryBits | AiBehaviorMemoryBits_HearGunShots);
+            enableMemoryBits = (enableMemoryBits | AiBehaviorMemoryBits_HearGunShots | AiBehaviorMemoryBits_ThreatLocated);
+            mThreatPoint = eventData->mPosition;
             break;
         }
     }
@@ -636,10 +986,12 @@ void AiPedestrianBehavior::ScanForThreats()
     {
         for (BroadcastEventsIterator eventsIter;;)
         {
-            if (!eventsIter.NextEventInDistance(eBroadcastEvent_Explosion, characterPos2, gGame.mParams.mAiReactOnExplosionsDistance, eventData))
+            const BroadcastEvent* eventData = eventsIter.NextEventInDistance(eBroadcastEvent_Explosion, characterPos2, gGame.mParams.mAiReactOnExplosionsDistance);
+            if (eventData == nullptr)
                 break;
 
-            enableMemoryBits = (enableMemoryBits | AiBehaviorMemoryBits_HearExplosion);
+            enableMemoryBits = (enableMemoryBits | AiBehaviorMemoryBits_HearExplosion | AiBehaviorMemoryBits_ThreatLocated);
+            mThreatPoint = eventData->mPosition;
             break;
         }
     }
@@ -658,7 +1010,9 @@ void AiPedestrianBehavior::ScanForLeader()
         if (!mLeader->IsDead() && !mLeader->IsDies())
             return;
 
-        mLeader.reset();
+        // handles cannot be changed in think phase
+        mAiController->PushCommand(AiCommand(eAiCommand_ResetLeader));
+        return;
     }
 
     Pedestrian* character = GetCharacter();
@@ -685,6 +1039,6 @@ void AiPedestrianBehavior::ScanForLeader()
         if (currDistance2 > bestDistance2)
             return;
 
-        mLeader = playerCharacter;
+        mAiController->PushCommand(AiCommand(eAiCommand_SetLeader, playerCharacter));
     }
 }
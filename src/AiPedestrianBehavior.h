@@ -1,6 +1,7 @@
 #pragma once
 
 #include "AiDefs.h"
+#include "RoadNetwork.h"
 
 class AiPedestrianBehavior: public cxx::noncopyable
 {
@@ -31,6 +32,8 @@ protected:
         void StartActivity();
         void UpdateActivity();
         void CancelActivity();
+        // Return to initial status, activity must not be in progress
+        void ResetActivity();
         // status shortucts
         bool IsStatusInProgress() const;
         bool IsStatusSuccess() const;
@@ -63,6 +66,7 @@ protected:
         void OnActivityUpdate() override;
     protected:
         bool ChooseDesiredPoint(eGroundType groundType);
+        bool ChooseRemotePoint(eGroundType groundType);
     };
 
     //////////////////////////////////////////////////////////////////////////
@@ -88,6 +92,25 @@ protected:
     protected:
         bool CheckCanFollowTheLeader() const;
     };
+
+    //////////////////////////////////////////////////////////////////////////
+    class AiActivity_DriveCar: public AiActivity
+    {
+    public:
+        AiActivity_DriveCar(AiPedestrianBehavior* aiBehavior);
+        // override AiActivity
+        void OnActivityStart() override;
+        void OnActivityUpdate() override;
+        void OnActivityCancelled() override;
+    protected:
+        // Follow chosen lanes, choose next lane when current one changes
+        // @param location: Current road location of car, gets adjusted to chosen lane at junction
+        void UpdateRoute(RoadLocation& location);
+        float GetDesiredSpeed(const RoadLocation& location, float laneDistance) const;
+    protected:
+        int mLaneEdge = -1; // current lane
+        int mNextLaneEdge = -1; // lane chosen at end node of current lane, -1 if dead end
+    };
     //////////////////////////////////////////////////////////////////////////
 
     class AiActivity_WalkToPoint: public AiActivity
@@ -96,15 +119,22 @@ protected:
         AiActivity_WalkToPoint(AiPedestrianBehavior* aiBehavior);
         void SetRunning(bool setRunning);
         void SetArriveDistance(float arriveDistance);
+        void SetUsePathfinding(bool usePathfinding);
         // override AiActivity
         void OnActivityStart() override;
         void OnActivityUpdate() override;
         void OnActivityCancelled() override;
     protected:
         bool ContinueWalk();
+        void RequestPath();
     protected:
         bool mSetRunning = false;
+        bool mUsePathfinding = false;
+        bool mWaitingForPath = false;
         float mArriveDistance = 0.0f;
+        unsigned int mPathQueryKey = 0;
+        std::vector<Point> mPathWaypoints; // last one is goal block, desired point is used instead
+        int mCurrentWaypoint = 0;
     };
 
     //////////////////////////////////////////////////////////////////////////
@@ -119,7 +149,7 @@ protected:
         void OnActivityUpdate() override;
     protected:
         float mWaitSeconds = 0.0f;
-        float mStartTime = 0.0f;
+        float mWaitTimer = 0.0f;
     };
 
     //////////////////////////////////////////////////////////////////////////
@@ -129,12 +159,19 @@ public:
     eAiPedestrianBehavior mBehaviorID;
 
 public:
-    AiPedestrianBehavior(AiCharacterController* aiController, eAiPedestrianBehavior behaviorID);
+    AiPedestrianBehavior(eAiPedestrianBehavior behaviorID);
     virtual ~AiPedestrianBehavior();
 
+    // Bind behavior to controller and reset its state
+    // Behaviors are reused by ai manager, so activities keep their allocated memory
+    void ResetBehavior(AiCharacterController* aiController);
+
     void ActivateBehavior();
     void ShutdownBehavior();
-    void UpdateBehavior();
+
+    // Process behavior logic
+    // @param deltaTime: Game time passed since previous update, accumulated over several frames when updated at reduced rate
+    void UpdateBehavior(float deltaTime);
 
     // memory bits
     void ChangeMemoryBits(AiBehaviorMemoryBits enableBits, AiBehaviorMemoryBits disableBits);
@@ -150,9 +187,11 @@ public:
     Pedestrian* GetLeader() const;
     
     void SetLeader(Pedestrian* pedestrian);
+    void ResetLeader();
 
 protected:
     // overridables
+    virtual void OnResetBehavior() {}
     virtual void OnActivateBehavior() {}
     virtual void OnShutdownBehavior() {}
     virtual void OnUpdateBehavior() {}
@@ -166,17 +205,24 @@ protected:
     AiActivity* mCurrentActivity = nullptr;
     AiActivity* mDesiredActivity = nullptr;
 
+    float mUpdateDeltaTime = 0.0f; // time passed since previous update, seconds
+    float mPerceptionTimer = 0.0f; // time left to next surroundings scan, seconds
+
     AiBehaviorMemoryBits mMemoryBits = AiBehaviorMemoryBits_None;
-    AiBehaviorBits mBehaviorBits = AiBehaviorBits_CanJump | AiBehaviorBits_Fear_GunShots | AiBehaviorBits_Fear_Explosions;
+    AiBehaviorBits mBehaviorBits = AiBehaviorBits_None;
 
     // shared data
     glm::vec2 mDesiredPoint;
+    glm::vec2 mThreatPoint; // last detected threat location, meters
     PedestrianHandle mLeader;
 
+    cxx::randomizer mRandom; // own generator, shared one cannot be used in parallel think phase
+
     // standard activities
     AiActiviy_Wander mActivity_Wander;
     AiActivity_Runaway mActivity_Runaway;
     AiActivity_FollowLeader mActivity_FollowLeader;
+    AiActivity_DriveCar mActivity_DriveCar;
 
     // primitive activities
     AiActivity_WalkToPoint mActivity_WalkToPoint;
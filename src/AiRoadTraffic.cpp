@@ -0,0 +1,163 @@
+#include "stdafx.h"
+#include "AiRoadTraffic.h"
+#include "Vehicle.h"
+#include "GtaOneGame.h"
+
+//////////////////////////////////////////////////////////////////////////
+
+inline glm::vec2 GetLaneDirectionVector(eMapDirection2D direction)
+{
+    switch (direction)
+    {
+        case eMapDirection2D_N: return glm::vec2(0.0f, -1.0f);
+        case eMapDirection2D_E: return glm::vec2(1.0f, 0.0f);
+        case eMapDirection2D_S: return glm::vec2(0.0f, 1.0f);
+        case eMapDirection2D_W: return glm::vec2(-1.0f, 0.0f);
+        default: break;
+    }
+    return glm::vec2();
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+void AiRoadTraffic::Cleanup()
+{
+    mOccupants.clear();
+    mLaneFirstOccupant.clear();
+}
+
+void AiRoadTraffic::UpdateFrame()
+{
+    const int lanesCount = (int) gGame.mRoadNetwork.mEdges.size();
+
+    mOccupants.clear();
+    for (Vehicle* currCar: gGame.mObjectsMng.mVehicles)
+    {
+        if (currCar->IsMarkedForDeletion() || (currCar->mPhysicsBody == nullptr))
+            continue;
+
+        // parked and wrecked cars are obstacles too
+        glm::vec2 position = currCar->mTransform.GetPosition2();
+        RoadLocation location;
+        if (!LocateCar(position, currCar->mTransform.GetDirectionVector(), location))
+            continue;
+
+        LaneOccupant occupant;
+        occupant.mEdgeIndex = location.mEdgeIndex;
+        occupant.mDistance = GetLaneDistance(location, position);
+        occupant.mSpeed = currCar->GetCurrentSpeed();
+        occupant.mCar = currCar;
+        mOccupants.push_back(occupant);
+    }
+    std::sort(mOccupants.begin(), mOccupants.end());
+
+    // occupants are sorted, so counts prefix sum gives first occupant of each lane
+    mLaneFirstOccupant.assign(lanesCount + 1, 0);
+    for (const LaneOccupant& currOccupant: mOccupants)
+    {
+        ++mLaneFirstOccupant[currOccupant.mEdgeIndex + 1];
+    }
+    for (int ilane = 1; ilane <= lanesCount; ++ilane)
+    {
+        mLaneFirstOccupant[ilane] += mLaneFirstOccupant[ilane - 1];
+    }
+}
+
+bool AiRoadTraffic::LocateCar(const glm::vec2& position, const glm::vec2& headingVector, RoadLocation& outLocation) const
+{
+    const RoadNetwork& roadNetwork = gGame.mRoadNetwork;
+
+    glm::vec2 mapPosition = Convert::MetersToMapUnits(position);
+    if (!roadNetwork.GetLocationAtBlock((int) floorf(mapPosition.x), (int) floorf(mapPosition.y), outLocation))
+        return false;
+
+    if (outLocation.mBlockIndex != -1)
+        return true;
+
+    // junction, choose outgoing lane closest to heading
+    const RoadNode& roadNode = roadNetwork.mNodes[roadNetwork.mEdges[outLocation.mEdgeIndex].mStartNode];
+    float bestDot = -2.0f;
+    for (int iedge = roadNode.mFirstEdge, EndEdge = roadNode.mFirstEdge + roadNode.mEdgesCount; iedge < EndEdge; ++iedge)
+    {
+        float currDot = glm::dot(GetLaneDirectionVector(roadNetwork.mEdges[iedge].mStartDirection), headingVector);
+        if (currDot > bestDot)
+        {
+            bestDot = currDot;
+            outLocation.mEdgeIndex = iedge;
+        }
+    }
+    return true;
+}
+
+float AiRoadTraffic::GetLaneDistance(const RoadLocation& location, const glm::vec2& position) const
+{
+    const RoadNetwork& roadNetwork = gGame.mRoadNetwork;
+
+    RoadBlock roadBlock = roadNetwork.GetLocationBlock(location);
+    glm::vec2 mapPosition = Convert::MetersToMapUnits(position);
+    glm::vec2 blockOffset(
+        glm::clamp(mapPosition.x - roadBlock.mX, 0.0f, 1.0f),
+        glm::clamp(mapPosition.y - roadBlock.mZ, 0.0f, 1.0f));
+
+    float blockProgress = 0.5f;
+    switch (roadNetwork.GetLocationDirection(location))
+    {
+        case eMapDirection2D_N: blockProgress = 1.0f - blockOffset.y; break;
+        case eMapDirection2D_E: blockProgress = blockOffset.x; break;
+        case eMapDirection2D_S: blockProgress = blockOffset.y; break;
+        case eMapDirection2D_W: blockProgress = 1.0f - blockOffset.x; break;
+        default: break;
+    }
+    // start node goes first
+    return (location.mBlockIndex + 1) + blockProgress;
+}
+
+float AiRoadTraffic::GetLaneLength(int edgeIndex) const
+{
+    // end node belongs to next lanes
+    return gGame.mRoadNetwork.mEdges[edgeIndex].mBlocksCount + 1.0f;
+}
+
+bool AiRoadTraffic::FindCarAhead(int edgeIndex, float distance, int nextEdgeIndex, const Vehicle* ignoreCar, float maxDistance, float& outDistance, float& outSpeed) const
+{
+    if (edgeIndex < 0 || (edgeIndex + 1) >= (int) mLaneFirstOccupant.size())
+        return false;
+
+    const LaneOccupant* occupant = FindOccupant(edgeIndex, distance, distance + maxDistance, ignoreCar);
+    if (occupant)
+    {
+        outDistance = occupant->mDistance - distance;
+        outSpeed = occupant->mSpeed;
+        return true;
+    }
+
+    // continue on next lane
+    float laneRemaining = GetLaneLength(edgeIndex) - distance;
+    if ((nextEdgeIndex < 0) || (nextEdgeIndex + 1) >= (int) mLaneFirstOccupant.size() || (laneRemaining >= maxDistance))
+        return false;
+
+    occupant = FindOccupant(nextEdgeIndex, -1.0f, maxDistance - laneRemaining, ignoreCar);
+    if (occupant)
+    {
+        outDistance = laneRemaining + occupant->mDistance;
+        outSpeed = occupant->mSpeed;
+        return true;
+    }
+    return false;
+}
+
+const AiRoadTraffic::LaneOccupant* AiRoadTraffic::FindOccupant(int edgeIndex, float minDistance, float maxDistance, const Vehicle* ignoreCar) const
+{
+    auto lane_begin = mOccupants.begin() + mLaneFirstOccupant[edgeIndex];
+    auto lane_end = mOccupants.begin() + mLaneFirstOccupant[edgeIndex + 1];
+    auto occupant_iter = std::upper_bound(lane_begin, lane_end, minDistance, [](float currDistance, const LaneOccupant& occupant)
+    {
+        return currDistance < occupant.mDistance;
+    });
+    for (; (occupant_iter != lane_end) && (occupant_iter->mDistance <= maxDistance); ++occupant_iter)
+    {
+        if (occupant_iter->mCar != ignoreCar)
+            return &(*occupant_iter);
+    }
+    return nullptr;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "RoadNetwork.h"
+
+// forwards
+class Vehicle;
+
+// defines per lane occupancy of road network, rebuilt once per frame before ai think phase
+// cars on each lane are sorted by distance from lane start, so drivers find car ahead with binary search instead of physics queries
+class AiRoadTraffic final: public cxx::noncopyable
+{
+public:
+    void Cleanup();
+
+    // Rebuild lanes occupancy from current cars positions, not thread-safe
+    void UpdateFrame();
+
+    // Find road location of car, lane at junction is chosen by car heading
+    // @param position: Map position, meters
+    // @param headingVector: Car forward direction
+    // @param outLocation: Output road location
+    // @returns false if position is not on road
+    bool LocateCar(const glm::vec2& position, const glm::vec2& headingVector, RoadLocation& outLocation) const;
+
+    // Get distance from lane start node to position within road location block
+    // @param location: Road location, should not be null
+    // @param position: Map position, meters
+    // @returns distance along lane, map units
+    float GetLaneDistance(const RoadLocation& location, const glm::vec2& position) const;
+
+    // Get distance from lane start node to its end node, map units
+    // @param edgeIndex: Lane index
+    float GetLaneLength(int edgeIndex) const;
+
+    // Find nearest car ahead on lane, search continues on next lane, thread-safe as long as occupancy is not updated
+    // @param edgeIndex: Current lane
+    // @param distance: Distance along current lane, map units
+    // @param nextEdgeIndex: Lane chosen at end node, -1 if none
+    // @param ignoreCar: Car which is not taken into account, usually own car
+    // @param maxDistance: Max search distance, map units
+    // @param outDistance: Output distance to car ahead, map units
+    // @param outSpeed: Output forward speed of car ahead, meters per second
+    // @returns false if there is no cars within search distance
+    bool FindCarAhead(int edgeIndex, float distance, int nextEdgeIndex, const Vehicle* ignoreCar, float maxDistance, float& outDistance, float& outSpeed) const;
+
+private:
+    // car on lane
+    struct LaneOccupant
+    {
+    public:
+        inline bool operator < (const LaneOccupant& other) const
+        {
+            if (mEdgeIndex == other.mEdgeIndex)
+                return mDistance < other.mDistance;
+
+            return mEdgeIndex < other.mEdgeIndex;
+        }
+    public:
+        int mEdgeIndex = 0;
+        float mDistance = 0.0f; // from lane start node, map units
+        float mSpeed = 0.0f; // forward speed, meters per second
+        const Vehicle* mCar = nullptr;
+    };
+
+    // Find first car on lane within distance range
+    // @returns null if there is no cars within range
+    const LaneOccupant* FindOccupant(int edgeIndex, float minDistance, float maxDistance, const Vehicle* ignoreCar) const;
+
+private:
+    std::vector<LaneOccupant> mOccupants; // sorted by lane and distance
+    std::vector<int> mLaneFirstOccupant; // index of first occupant for each lane, lanes count + 1
+};
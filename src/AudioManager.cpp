@@ -288,7 +288,7 @@ void AudioManager::UpdateActiveEmitters()
     if (mActiveEmitters.empty())
         return;
 
-    std::vector<SfxEmitter*> inactiveEmitters;
+    FrameHeapVector<SfxEmitter*> inactiveEmitters (gSystem.mMemoryMng.GetFrameHeapAllocator());
     for (SfxEmitter* currEmitter: mActiveEmitters)
     {
         if (currEmitter->mGameObject) // sync audio params
@@ -368,7 +368,7 @@ void AudioManager::UpdateMusic()
     if (mMusicStatus == eMusicStatus_Playing)
     {
         // process buffers
-        std::vector<AudioSampleBuffer*> sampleBuffers;
+        FrameHeapVector<AudioSampleBuffer*> sampleBuffers (gSystem.mMemoryMng.GetFrameHeapAllocator());
         if (!mMusicAudioSource->ProcessBuffersQueue(sampleBuffers))
         {
             StopMusic();
@@ -432,7 +432,7 @@ void AudioManager::StopMusic()
 
     if (mMusicAudioSource)
     {
-        std::vector<AudioSampleBuffer*> sampleBuffers;
+        FrameHeapVector<AudioSampleBuffer*> sampleBuffers (gSystem.mMemoryMng.GetFrameHeapAllocator());
         mMusicAudioSource->Stop();
         mMusicAudioSource->ProcessBuffersQueue(sampleBuffers);
         if (!sampleBuffers.empty())
@@ -175,7 +175,7 @@ bool AudioSource::QueueSampleBuffer(AudioSampleBuffer* audioBuffer)
     return false;
 }
 
-bool AudioSource::ProcessBuffersQueue(std::vector<AudioSampleBuffer*>& audioBuffers)
+bool AudioSource::ProcessBuffersQueue(FrameHeapVector<AudioSampleBuffer*>& audioBuffers)
 {
     if (::alIsSource(mSourceID))
     {
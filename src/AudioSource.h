@@ -62,7 +62,7 @@ public:
     bool QueueSampleBuffer(AudioSampleBuffer* audioBuffer);
     // Unqueue sample buffers which was already processed, works for streaming type only
     // @param audioBuffers: Output processed sample buffers
-    bool ProcessBuffersQueue(std::vector<AudioSampleBuffer*>& audioBuffers);
+    bool ProcessBuffersQueue(FrameHeapVector<AudioSampleBuffer*>& audioBuffers);
 
     // Control audio state
     bool Start(bool enableLoop = false);
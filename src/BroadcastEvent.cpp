@@ -9,11 +9,7 @@ void BroadcastEventsIterator::Reset()
 
 bool BroadcastEventsIterator::NextEvent(eBroadcastEvent eventType, BroadcastEvent& outputEventData)
 {
-    int currIndex = 0;
-    if (mCurrentIndex != -1)
-    {
-        currIndex = mCurrentIndex;
-    }
+    int currIndex = mCurrentIndex + 1; // continue after previously found event
     const int eventsCount = (int) gGame.mBroadcastEventsList.size();
     for (;currIndex < eventsCount; ++currIndex)
     {
@@ -31,11 +27,18 @@ bool BroadcastEventsIterator::NextEvent(eBroadcastEvent eventType, BroadcastEven
 
 bool BroadcastEventsIterator::NextEventInDistance(eBroadcastEvent eventType, const glm::vec2& position, float maxDistance, BroadcastEvent& outputEventData)
 {
-    int currIndex = 0;
-    if (mCurrentIndex != -1)
+    const BroadcastEvent* eventData = NextEventInDistance(eventType, position, maxDistance);
+    if (eventData)
     {
-        currIndex = mCurrentIndex;
+        outputEventData = *eventData;
+        return true;
     }
+    return false;
+}
+
+const BroadcastEvent* BroadcastEventsIterator::NextEventInDistance(eBroadcastEvent eventType, const glm::vec2& position, float maxDistance)
+{
+    int currIndex = mCurrentIndex + 1; // continue after previously found event
     const float maxDistance2 = (maxDistance * maxDistance);
     const int eventsCount = (int) gGame.mBroadcastEventsList.size();
     for (;currIndex < eventsCount; ++currIndex)
@@ -47,13 +50,12 @@ bool BroadcastEventsIterator::NextEventInDistance(eBroadcastEvent eventType, con
             if (currDistance2 < maxDistance2)
             {
                 mCurrentIndex = currIndex;
-                outputEventData = currEvent;
-                return true;
+                return &currEvent;
             }
         }
     }
     mCurrentIndex = eventsCount;
-    return false;
+    return nullptr;
 }
 
 void BroadcastEventsIterator::DeleteCurrentEvent()
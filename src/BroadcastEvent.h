@@ -53,6 +53,9 @@ public:
     void Reset();
     bool NextEvent(eBroadcastEvent eventType, BroadcastEvent& outputEventData);
     bool NextEventInDistance(eBroadcastEvent eventType, const glm::vec2& position, float maxDistance, BroadcastEvent& outputEventData);
+    // Find next event without copying its data, copying would touch handles of referenced objects
+    // so this version is safe to use from ai think jobs
+    const BroadcastEvent* NextEventInDistance(eBroadcastEvent eventType, const glm::vec2& position, float maxDistance);
     void DeleteCurrentEvent();
 private:
     int mCurrentIndex = -1;
@@ -81,17 +81,23 @@ void Contact::SetupWithBox2Data(b2Contact* box2Contact, b2Fixture* thisFixture,
 
 //////////////////////////////////////////////////////////////////////////
 
-void Collision::SetupWithBox2Data(b2Contact* box2Contact, b2Fixture* thisFixture, b2Fixture* thatFixture, const b2ContactImpulse* contactImpulse)
+void Collision::Setup(Collider* thisCollider, Collider* thatCollider, const glm::vec2& contactPoint, const glm::vec2& normal, float separation, float contactImpulse)
 {
-    mContactInfo.SetupWithBox2Data(box2Contact, thisFixture, thatFixture);
+    cxx_assert(thisCollider);
+    cxx_assert(thatCollider);
 
-    cxx_assert(contactImpulse);
+    mContactInfo.mThisCollider = thisCollider;
+    mContactInfo.mThatCollider = thatCollider;
+    mContactInfo.mThisObject = thisCollider->mGameObject;
+    mContactInfo.mThatObject = thatCollider->mGameObject;
+    cxx_assert(mContactInfo.mThisObject);
+    cxx_assert(mContactInfo.mThatObject);
+    cxx_assert(mContactInfo.mThisObject != mContactInfo.mThatObject);
 
-    mContactImpulse = 0.0f;
-    for (int icurr = 0; icurr < contactImpulse->count; ++icurr)
-    {
-        mContactImpulse += contactImpulse->normalImpulses[icurr];
-    }
+    mContactInfo.mContactPoints[0] = ContactPoint(contactPoint, thisCollider->mPhysicsBody->mPositionY, normal, separation);
+    mContactInfo.mContactPointsCount = 1;
+
+    mContactImpulse = contactImpulse;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -101,42 +107,18 @@ bool MapCollision::HasContactPoints() const
     return mContactPointsCount > 0;
 }
 
-void MapCollision::SetupWithBox2Data(b2Contact* box2Contact, b2Fixture* objectFixture, const MapBlockInfo* mapBlockInfo, const b2ContactImpulse* contactImpulse)
+void MapCollision::Setup(Collider* thisCollider, const MapBlockInfo* mapBlockInfo, const glm::vec2& contactPoint, const glm::vec2& normal, float separation, float contactImpulse)
 {
-    cxx_assert(box2Contact);
-    cxx_assert(objectFixture);
+    cxx_assert(thisCollider);
     cxx_assert(mapBlockInfo);
-    cxx_assert(contactImpulse);
 
     mMapBlockInfo = mapBlockInfo;
-    mThisObject = nullptr;
-    mThisCollider = b2Fixture_get_collider(objectFixture);
-
-    cxx_assert(mThisCollider);
-
-    mThisObject = mThisCollider->mGameObject;
+    mThisCollider = thisCollider;
+    mThisObject = thisCollider->mGameObject;
     cxx_assert(mThisObject);
 
-    mContactPointsCount = box2Contact->GetManifold()->pointCount;
-    if (mContactPointsCount > 0)
-    {
-        mContactPointsCount = std::min(mContactPointsCount, MaxCollisionContactPoints);
+    mContactPoints[0] = ContactPoint(contactPoint, thisCollider->mPhysicsBody->mPositionY, normal, separation);
+    mContactPointsCount = 1;
 
-        b2WorldManifold wmanifold;
-        box2Contact->GetWorldManifold(&wmanifold);
-
-        for (int icurrPoint = 0; icurrPoint < mContactPointsCount; ++ icurrPoint)
-        {
-            mContactPoints[icurrPoint].mPosition = convert_vec2(wmanifold.points[icurrPoint]);
-            mContactPoints[icurrPoint].mNormal = convert_vec2(wmanifold.normal);
-            mContactPoints[icurrPoint].mPositionY = mThisCollider->mPhysicsBody->mPositionY;
-            mContactPoints[icurrPoint].mSeparation = wmanifold.separations[icurrPoint];
-        }
-    }
-
-    mContactImpulse = 0.0f;
-    for (int icurr = 0; icurr < contactImpulse->count; ++icurr)
-    {
-        mContactImpulse += contactImpulse->normalImpulses[icurr];
-    }
+    mContactImpulse = contactImpulse;
 }
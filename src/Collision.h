@@ -34,6 +34,28 @@ private:
 
 //////////////////////////////////////////////////////////////////////////
 
+// contacts of single object, points to physics manager contacts arena and valid until next simulation step
+class ContactsList
+{
+public:
+    ContactsList() = default;
+    ContactsList(const Contact* firstContact, int contactsCount)
+        : mFirstContact(firstContact)
+        , mContactsCount(contactsCount)
+    {
+    }
+    inline const Contact* begin() const { return mFirstContact; }
+    inline const Contact* end() const { return mFirstContact + mContactsCount; }
+    inline int size() const { return mContactsCount; }
+    inline bool empty() const { return mContactsCount == 0; }
+
+private:
+    const Contact* mFirstContact = nullptr;
+    int mContactsCount = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
 // collision between objects colliders
 class Collision
 {
@@ -51,7 +73,8 @@ public:
         return mContactImpulse;
     }
 private:
-    void SetupWithBox2Data(b2Contact* contact, b2Fixture* thisFixture, b2Fixture* thatFixture, const b2ContactImpulse* contactImpulse);
+    // Setup collision with single contact point merged from all contacts of colliders pair
+    void Setup(Collider* thisCollider, Collider* thatCollider, const glm::vec2& contactPoint, const glm::vec2& normal, float separation, float contactImpulse);
 
 private:
     float mContactImpulse = 0.0f;
@@ -84,7 +107,8 @@ public:
         return mContactImpulse;
     }
 private:
-    void SetupWithBox2Data(b2Contact* contact, b2Fixture* objectFixture, const MapBlockInfo* mapBlockInfo, const b2ContactImpulse* contactImpulse);
+    // Setup collision with single contact point merged from all contacts of collider with map
+    void Setup(Collider* thisCollider, const MapBlockInfo* mapBlockInfo, const glm::vec2& contactPoint, const glm::vec2& normal, float separation, float contactImpulse);
 
 private:
     float mContactImpulse = 0.0f;
@@ -87,29 +87,12 @@ void Explosion::DamagePedsNearby(bool enableInstantKill)
         gGame.mParams.mExplosionRadius, 
         gGame.mParams.mExplosionRadius );
 
-    PhysicsQueryResult queryResult;
-    gGame.mPhysicsMng.QueryObjectsWithinBox(centerPoint, extents, queryResult, CollisionGroup_Pedestrian);
+    PhysicsQueryResult queryResult (gSystem.mMemoryMng.GetFrameHeapAllocator());
+    gGame.mPhysicsMng.QueryObjectsWithinBox(centerPoint, extents, PhysicsQueryFilter(CollisionGroup_Pedestrian, eGameObjectClass_Pedestrian), queryResult);
 
-    for (int icurr = 0; icurr < queryResult.mElementsCount; ++icurr)
+    for (const PhysicsQueryElement& currElement: queryResult)
     {
-        PhysicsQueryElement& currElement = queryResult.mElements[icurr];
-
-        if (currElement.mPhysicsObject == nullptr)
-        {
-            cxx_assert(false);
-            continue;
-        }
-
-        GameObject* gameObject = currElement.mPhysicsObject->mGameObject;
-        if ((gameObject == nullptr) || !gameObject->IsPedestrianClass())
-        {
-            cxx_assert(false);
-            continue;
-        }
-
-        Pedestrian* currPedestrian = (Pedestrian*) gameObject;
-        if (currPedestrian == nullptr)
-            continue;
+        Pedestrian* currPedestrian = (Pedestrian*) currElement.mPhysicsObject->mGameObject;
 
         glm::vec2 pedestrianPosition = currPedestrian->mTransform.GetPosition2();
         float distanceToExplosionCenter2 = glm::distance2(centerPoint, pedestrianPosition);
@@ -134,9 +117,7 @@ void Explosion::DamagePedsNearby(bool enableInstantKill)
             currPedestrian->ReceiveDamage(damageInfo);
             continue;
         }
-
     }
-    queryResult.Clear();
 }
 
 void Explosion::DamageObjectInContact()
@@ -158,29 +139,12 @@ void Explosion::DamageCarsNearby()
         gGame.mParams.mExplosionRadius, 
         gGame.mParams.mExplosionRadius );
 
-    PhysicsQueryResult queryResult;
-    gGame.mPhysicsMng.QueryObjectsWithinBox(centerPoint, extents, queryResult, CollisionGroup_Car);
+    PhysicsQueryResult queryResult (gSystem.mMemoryMng.GetFrameHeapAllocator());
+    gGame.mPhysicsMng.QueryObjectsWithinBox(centerPoint, extents, PhysicsQueryFilter(CollisionGroup_Car, eGameObjectClass_Car, mExplodingObject), queryResult);
 
-    for (int icurr = 0; icurr < queryResult.mElementsCount; ++icurr)
+    for (const PhysicsQueryElement& currElement: queryResult)
     {
-        PhysicsQueryElement& currElement = queryResult.mElements[icurr];
-
-        if (currElement.mPhysicsObject == nullptr)
-        {
-            cxx_assert(false);
-            continue;
-        }
-
-        GameObject* gameObject = currElement.mPhysicsObject->mGameObject;
-        if ((gameObject == nullptr) || !gameObject->IsVehicleClass())
-        {
-            cxx_assert(false);
-            continue;
-        }
-
-        Vehicle* currentCar = (Vehicle*) gameObject;
-        if (currentCar == mExplodingObject)
-            continue;
+        Vehicle* currentCar = (Vehicle*) currElement.mPhysicsObject->mGameObject;
 
         glm::vec2 carPosition = currentCar->mTransform.GetPosition2();
         float distanceToExplosionCenter2 = glm::distance2(centerPoint, carPosition);
@@ -191,5 +155,4 @@ void Explosion::DamageCarsNearby()
             currentCar->ReceiveDamage(damageInfo);
         }
     }
-    queryResult.Clear();
 }
\ No newline at end of file
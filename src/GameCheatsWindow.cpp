@@ -204,6 +204,15 @@ void GameCheatsWindow::DoUI(ImGuiIO& imguiContext)
         ImGui::Checkbox("Enable gravity", &mEnableGravity);
     }
 
+    if (ImGui::CollapsingHeader("Memory"))
+    {
+        ImGui::Text("Heap allocations per frame: %d", gSystem.mMemoryMng.mHeapAllocationsLastFrame);
+        if (gSystem.mMemoryMng.mFrameHeapAllocator)
+        {
+            ImGui::Text("Frame heap used: %u bytes", gSystem.mMemoryMng.mFrameHeapAllocator->get_used_memory());
+        }
+    }
+
     if (ImGui::CollapsingHeader("Draw"))
     {
         ImGui::Text("Map chunks drawn: %d", gGame.mMapRenderer.mRenderStats.mBlockChunksDrawnCount);
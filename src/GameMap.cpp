@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "GameMap.h"
+#include "GameMapRaycast.h"
 #include "GtaOneGame.h"
 #include "cvars.h"
 
@@ -97,6 +98,8 @@ void GameMap::Cleanup()
     {
         mAccidentServicesBases[ibase].clear();
     }
+    mDistricts.clear();
+    BuildDistrictsLookup();
     mStyleFileNumber = 0;
     mAudioFileNumber = 0;
 }
@@ -297,11 +300,11 @@ const DistrictInfo* GameMap::GetDistrictAtPosition2(const glm::vec2& position) c
 
 const DistrictInfo* GameMap::GetDistrict(int coordx, int coordy) const
 {
-    const Point point (coordx, coordy);
-    for (const DistrictInfo& currDistrict: mDistricts)
+    if (coordx >= 0 && coordx < MAP_DIMENSIONS && coordy >= 0 && coordy < MAP_DIMENSIONS)
     {
-        if (currDistrict.mArea.PointWithin(point))
-            return &currDistrict;
+        int districtIndex = mDistrictsGrid[coordy][coordx];
+        if (districtIndex != -1)
+            return &mDistricts[districtIndex];
     }
     cxx_assert(false); // shouldn't happen
     return nullptr;
@@ -309,10 +312,11 @@ const DistrictInfo* GameMap::GetDistrict(int coordx, int coordy) const
 
 const DistrictInfo* GameMap::GetDistrictByIndex(int districtIndex) const
 {
-    for (const DistrictInfo& currInfo: mDistricts)
+    if (districtIndex >= 0 && districtIndex < CountOf(mDistrictsBySampleIndex))
     {
-        if (currInfo.mSampleIndex == districtIndex)
-            return &currInfo;
+        int listIndex = mDistrictsBySampleIndex[districtIndex];
+        if (listIndex != -1)
+            return &mDistricts[listIndex];
     }
     cxx_assert(false);
     return nullptr;
@@ -320,6 +324,14 @@ const DistrictInfo* GameMap::GetDistrictByIndex(int districtIndex) const
 
 float GameMap::GetHeightAtPosition(const glm::vec3& position, bool excludeWater) const
 {
+    bool isSlope = false;
+    return GetHeightAtPosition(position, excludeWater, isSlope);
+}
+
+float GameMap::GetHeightAtPosition(const glm::vec3& position, bool excludeWater, bool& isSlope) const
+{
+    isSlope = false;
+
     // get map block position in which we are located
     glm::ivec3 mapBlock = Convert::MetersToMapUnits(position);
 
@@ -336,6 +348,7 @@ float GameMap::GetHeightAtPosition(const glm::vec3& position, bool excludeWater)
             float cy = Convert::MetersToMapUnits(position.z) - mapBlock.z;
 
             currentHeight += GameMapHelpers::GetSlopeHeight(blockData->mSlopeType, cx, cy);
+            isSlope = true;
 
             break;
         }
@@ -352,96 +365,14 @@ float GameMap::GetHeightAtPosition(const glm::vec3& position, bool excludeWater)
     return Convert::MapUnitsToMeters(currentHeight);
 }
 
-bool GameMap::TraceSegment2D(const glm::vec2& origin, const glm::vec2& destination, float height, glm::vec2& outPoint)
+bool GameMap::TraceSegment2D(const glm::vec2& origin, const glm::vec2& destination, float height, glm::vec2& outPoint) const
 {
-    glm::ivec2 mapcoord_start = origin;
-    glm::ivec2 mapcoord_end = destination;
-
-    int mapcoord_z = (int) height;
-
-    glm::vec2 direction = glm::normalize(destination - origin);
-
-    // find all cells intersecting with line
-
-    float posX = origin.x;
-    float posY = origin.y;
-
-    glm::ivec2 mapcoord_curr = mapcoord_start;
-
-    float sideDistX;
-    float sideDistY;
-
-    //length of ray from one x or y-side to next x or y-side
-    float deltaDistX = std::abs(1.0f / direction.x);
-    float deltaDistY = std::abs(1.0f / direction.y);
-
-    //what direction to step in x or y-direction (either +1 or -1)
-    int stepX;
-    int stepY;
-
-    int side; //was a NS or a EW wall hit?
-
-    //calculate step and initial sideDist
-    if (direction.x < 0.0f)
-    {
-        stepX = -1;
-        sideDistX = (posX - mapcoord_curr.x) * deltaDistX;
-    }
-    else
-    {
-        stepX = 1;
-        sideDistX = (mapcoord_curr.x + 1.0f - posX) * deltaDistX;
-    }
-
-    if (direction.y < 0.0f)
-    {
-        stepY = -1;
-        sideDistY = (posY - mapcoord_curr.y) * deltaDistY;
-    }
-    else
-    {
-        stepY = 1;
-        sideDistY = (mapcoord_curr.y + 1.0f - posY) * deltaDistY;
-    }
-
-    //perform DDA
-    const int MaxSteps = 16;
-    for (int istep = 0; ; ++istep)
-    {
-        if (istep == MaxSteps)
-            return false;
-
-        //jump to next map square, OR in x-direction, OR in y-direction
-        if (sideDistX < sideDistY)
-        {
-            sideDistX += deltaDistX;
-            mapcoord_curr.x += stepX;
-            side = 0;
-        }
-        else
-        {
-            sideDistY += deltaDistY;
-            mapcoord_curr.y += stepY;
-            side = 1;
-        }
-
-        // detect hit
-        const MapBlockInfo* blockData = GetBlockInfo(mapcoord_curr.x, mapcoord_curr.y, mapcoord_z);
-        if (blockData->mGroundType == eGroundType_Building)
-        {
-            float perpWallDist;
-            if (side == 0) perpWallDist = (mapcoord_curr.x - posX + (1 - stepX) / 2) / direction.x;
-            else           perpWallDist = (mapcoord_curr.y - posY + (1 - stepY) / 2) / direction.y;
-
-            outPoint = (origin + direction * perpWallDist);
-            return true;
-        }
-
-        if (mapcoord_curr == mapcoord_end)
-            break;
-    }
+    MapRaycastHit hit;
+    if (!GameMapRaycast::Raycast2D(*this, Convert::MapUnitsToMeters(origin), Convert::MapUnitsToMeters(destination), (int) height, hit))
+        return false;
 
-    return false;
+    outPoint = Convert::MetersToMapUnits(glm::vec2(hit.mPosition.x, hit.mPosition.z));
+    return true;
 }
 
 bool GameMap::ReadStartupObjects(std::istream& file, int dataSize)
@@ -597,9 +528,48 @@ bool GameMap::ReadNavData(std::ifstream& file, int dataSize)
 
             return (lhs.mArea.h < rhs.mArea.h);
         });
+
+    BuildDistrictsLookup();
     return true;
 }
 
+void GameMap::BuildDistrictsLookup()
+{
+    for (int tiley = 0; tiley < MAP_DIMENSIONS; ++tiley)
+    for (int tilex = 0; tilex < MAP_DIMENSIONS; ++tilex)
+    {
+        mDistrictsGrid[tiley][tilex] = -1;
+    }
+
+    for (short& listIndex: mDistrictsBySampleIndex)
+    {
+        listIndex = -1;
+    }
+
+    // smaller districts go first and have priority, so cells that are already taken are kept
+    const Rect mapArea (0, 0, MAP_DIMENSIONS, MAP_DIMENSIONS);
+    for (int idistrict = 0, NumDistricts = (int) mDistricts.size(); idistrict < NumDistricts; ++idistrict)
+    {
+        const DistrictInfo& currDistrict = mDistricts[idistrict];
+
+        Rect area = currDistrict.mArea.GetIntersection(mapArea);
+        for (int tiley = area.y; tiley < (area.y + area.h); ++tiley)
+        for (int tilex = area.x; tilex < (area.x + area.w); ++tilex)
+        {
+            if (mDistrictsGrid[tiley][tilex] == -1)
+            {
+                mDistrictsGrid[tiley][tilex] = (short) idistrict;
+            }
+        }
+
+        if (currDistrict.mSampleIndex >= 0 && currDistrict.mSampleIndex < CountOf(mDistrictsBySampleIndex) && 
+            mDistrictsBySampleIndex[currDistrict.mSampleIndex] == -1)
+        {
+            mDistrictsBySampleIndex[currDistrict.mSampleIndex] = (short) idistrict;
+        }
+    }
+}
+
 std::string GameMap::GetStyleFileName(int styleNumber) const
 {
     if (gCvarGameVersion.mValue == eGtaGameVersion_MissionPack2_London61)
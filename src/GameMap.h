@@ -41,6 +41,8 @@ public:
     // Get real height at specified map point
     // @param position: Current position on map, meters
     float GetHeightAtPosition(const glm::vec3& position, bool excludeWater = true) const;
+    // @param isSlope: Returns true if height was taken from slope block
+    float GetHeightAtPosition(const glm::vec3& position, bool excludeWater, bool& isSlope) const;
 
     // Get water height at specific map point
     // @param position: Current position on map, meters
@@ -52,7 +54,7 @@ public:
     // @param height: Z coord which is map layer
     // @param outPoint: Intersection point
     // @returns true if intersection detected or false otherwise
-    bool TraceSegment2D(const glm::vec2& origin, const glm::vec2& destination, float height, glm::vec2& outPoint);
+    bool TraceSegment2D(const glm::vec2& origin, const glm::vec2& destination, float height, glm::vec2& outPoint) const;
 
 private:
     // Reading map data internals
@@ -64,6 +66,9 @@ private:
     bool ReadNavData(std::ifstream& file, int dataSize);
     void FixShiftedBits();
 
+    // Rasterize districts areas into lookup grid, districts should be sorted by priority
+    void BuildDistrictsLookup();
+
 private:
     MapBlockInfo mMapTiles[MAP_LAYERS_COUNT][MAP_DIMENSIONS][MAP_DIMENSIONS]; // z, y, x
     int mBaseTilesData[MAP_DIMENSIONS][MAP_DIMENSIONS]; // y x
@@ -72,4 +77,6 @@ private:
     std::vector<glm::ivec3> mAccidentServicesBases[eAccidentServise_COUNT];
 
     std::vector<DistrictInfo> mDistricts;
+    short mDistrictsGrid[MAP_DIMENSIONS][MAP_DIMENSIONS]; // y x, index in districts list, -1 if none
+    short mDistrictsBySampleIndex[256]; // index in districts list, -1 if none
 };
\ No newline at end of file
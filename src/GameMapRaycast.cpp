@@ -0,0 +1,373 @@
+#include "stdafx.h"
+#include "GameMapRaycast.h"
+#include "GameMap.h"
+#include "GameMapHelpers.h"
+
+//////////////////////////////////////////////////////////////////////////
+
+// slope types 1-44 are ramps, others have no surface height
+const int MaxRampSlopeType = 44;
+
+inline bool IsRampBlock(const MapBlockInfo* blockInfo)
+{
+    return (blockInfo->mSlopeType > 0) && (blockInfo->mSlopeType <= MaxRampSlopeType) && (blockInfo->mGroundType != eGroundType_Building);
+}
+
+inline bool IsFloorBlock(const MapBlockInfo* blockInfo)
+{
+    return (blockInfo->mGroundType != eGroundType_Air) && (blockInfo->mGroundType != eGroundType_Water) && !IsRampBlock(blockInfo);
+}
+
+inline glm::vec3 MetersToMapUnits3(const glm::vec3& position)
+{
+    // convert components separately, vector conversion adds height offset
+    return glm::vec3(Convert::MetersToMapUnits(position.x), Convert::MetersToMapUnits(position.y), Convert::MetersToMapUnits(position.z));
+}
+
+inline glm::vec3 MapUnitsToMeters3(const glm::vec3& position)
+{
+    return glm::vec3(Convert::MapUnitsToMeters(position.x), Convert::MapUnitsToMeters(position.y), Convert::MapUnitsToMeters(position.z));
+}
+
+// height of ramp surface above block bottom at map position, map units
+inline float GetRampHeight(const MapBlockInfo* blockInfo, const glm::ivec3& block, const glm::vec3& position)
+{
+    float cx = glm::clamp(position.x - block.x, 0.0f, 1.0f);
+    float cz = glm::clamp(position.z - block.z, 0.0f, 1.0f);
+    return GameMapHelpers::GetSlopeHeight(blockInfo->mSlopeType, cx, cz);
+}
+
+// grid traversal state for single ray, map units
+struct RaycastTraversal
+{
+public:
+    RaycastTraversal(const glm::vec3& start, const glm::vec3& delta, int axesCount)
+        : mStart(start)
+        , mDelta(delta)
+    {
+        for (int iaxis = 0; iaxis < 3; ++iaxis)
+        {
+            mBlock[iaxis] = (int) floorf(start[iaxis]);
+            if ((iaxis < axesCount) && (delta[iaxis] > 0.0f))
+            {
+                mStep[iaxis] = 1;
+                mDeltaT[iaxis] = 1.0f / delta[iaxis];
+                mMaxT[iaxis] = (mBlock[iaxis] + 1.0f - start[iaxis]) * mDeltaT[iaxis];
+            }
+            else if ((iaxis < axesCount) && (delta[iaxis] < 0.0f))
+            {
+                mStep[iaxis] = -1;
+                mDeltaT[iaxis] = -1.0f / delta[iaxis];
+                mMaxT[iaxis] = (start[iaxis] - mBlock[iaxis]) * mDeltaT[iaxis];
+            }
+            else
+            {
+                mStep[iaxis] = 0;
+                mDeltaT[iaxis] = std::numeric_limits<float>::max();
+                mMaxT[iaxis] = std::numeric_limits<float>::max();
+            }
+        }
+    }
+
+    // Get ray parameter where current block is left, not greater than ray end
+    inline float GetExitT() const
+    {
+        return std::min(std::min(mMaxT.x, mMaxT.y), std::min(mMaxT.z, 1.0f));
+    }
+
+    // Move to next block along ray
+    inline void Advance()
+    {
+        mEnterAxis = (mMaxT.x < mMaxT.y) ? ((mMaxT.x < mMaxT.z) ? 0 : 2) : ((mMaxT.y < mMaxT.z) ? 1 : 2);
+        mEnterT = mMaxT[mEnterAxis];
+        mBlock[mEnterAxis] += mStep[mEnterAxis];
+        mMaxT[mEnterAxis] += mDeltaT[mEnterAxis];
+    }
+
+    inline glm::vec3 GetPoint(float t) const
+    {
+        return mStart + mDelta * t;
+    }
+
+    // Get normal of block face through which current block was entered
+    inline glm::vec3 GetEnterNormal() const
+    {
+        glm::vec3 normal (0.0f);
+        if (mEnterAxis == -1)
+        {
+            // ray starts inside block
+            if (glm::length2(mDelta) > 0.0f)
+            {
+                normal = -glm::normalize(mDelta);
+            }
+            return normal;
+        }
+        normal[mEnterAxis] = (float) -mStep[mEnterAxis];
+        return normal;
+    }
+
+public:
+    glm::vec3 mStart;
+    glm::vec3 mDelta;
+    glm::ivec3 mBlock;
+    glm::ivec3 mStep;
+    glm::vec3 mDeltaT;
+    glm::vec3 mMaxT;
+    float mEnterT = 0.0f;
+    int mEnterAxis = -1; // block face through which current block was entered, -1 for start block
+};
+
+inline void SetRaycastHit(const RaycastTraversal& traversal, float t, const glm::ivec3& block, const glm::vec3& normal, MapRaycastHit& outHit)
+{
+    outHit.mHasHit = true;
+    outHit.mPosition = MapUnitsToMeters3(traversal.GetPoint(t));
+    outHit.mNormal = normal;
+    outHit.mBlock = block;
+    outHit.mFraction = t;
+}
+
+// shadowcasting state
+struct VisibleBlocksContext
+{
+public:
+    const GameMap& mGameMap;
+    Point mOrigin;
+    int mLayer;
+    int mRadius;
+    std::vector<bool> mVisited; // window around origin
+    std::vector<Point>& mOutBlocks;
+};
+
+// octants transforms, row and column to map offset
+const int ShadowcastOctants[8][4] =
+{
+    { 1,  0,  0,  1}, { 0,  1,  1,  0}, { 0, -1,  1,  0}, {-1,  0,  0,  1},
+    {-1,  0,  0, -1}, { 0, -1, -1,  0}, { 0,  1, -1,  0}, { 1,  0,  0, -1},
+};
+
+inline bool IsOpaqueBlock(const VisibleBlocksContext& context, const Point& block)
+{
+    if (block.x < 0 || block.x >= MAP_DIMENSIONS || block.y < 0 || block.y >= MAP_DIMENSIONS)
+        return true;
+
+    const MapBlockInfo* blockInfo = context.mGameMap.GetBlockInfo(block.x, block.y, context.mLayer);
+    return blockInfo->mGroundType == eGroundType_Building;
+}
+
+inline void AddVisibleBlock(VisibleBlocksContext& context, const Point& block)
+{
+    if (block.x < 0 || block.x >= MAP_DIMENSIONS || block.y < 0 || block.y >= MAP_DIMENSIONS)
+        return;
+
+    const int windowSize = context.mRadius * 2 + 1;
+    const int windowIndex = (block.y - context.mOrigin.y + context.mRadius) * windowSize + (block.x - context.mOrigin.x + context.mRadius);
+    if (context.mVisited[windowIndex])
+        return;
+
+    context.mVisited[windowIndex] = true;
+    context.mOutBlocks.push_back(block);
+}
+
+// recursive shadowcasting over single octant
+static void CastVisibilityOctant(VisibleBlocksContext& context, int row, float startSlope, float endSlope, const int (&octant)[4])
+{
+    if (startSlope < endSlope)
+        return;
+
+    const int radius2 = context.mRadius * context.mRadius;
+    float nextStartSlope = startSlope;
+    for (int irow = row; irow <= context.mRadius; ++irow)
+    {
+        bool blocked = false;
+        for (int dx = -irow, dy = -irow; dx <= 0; ++dx)
+        {
+            float leftSlope = (dx - 0.5f) / (dy + 0.5f);
+            float rightSlope = (dx + 0.5f) / (dy - 0.5f);
+            if (startSlope < rightSlope)
+                continue;
+
+            if (endSlope > leftSlope)
+                break;
+
+            Point block (
+                context.mOrigin.x + dx * octant[0] + dy * octant[1],
+                context.mOrigin.y + dx * octant[2] + dy * octant[3]);
+
+            if ((dx * dx + dy * dy) <= radius2)
+            {
+                AddVisibleBlock(context, block);
+            }
+
+            bool isOpaque = IsOpaqueBlock(context, block);
+            if (blocked)
+            {
+                if (isOpaque)
+                {
+                    nextStartSlope = rightSlope;
+                    continue;
+                }
+                blocked = false;
+                startSlope = nextStartSlope;
+                continue;
+            }
+
+            if (isOpaque && (irow < context.mRadius))
+            {
+                blocked = true;
+                CastVisibilityOctant(context, irow + 1, startSlope, leftSlope, octant);
+                nextStartSlope = rightSlope;
+            }
+        }
+        if (blocked)
+            break;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+bool GameMapRaycast::Raycast2D(const GameMap& gameMap, const glm::vec2& origin, const glm::vec2& destination, int layer, MapRaycastHit& outHit)
+{
+    outHit = MapRaycastHit();
+
+    if (layer < 0 || layer >= MAP_LAYERS_COUNT)
+        return false;
+
+    // traverse x and z, layer is fixed at its bottom
+    glm::vec3 start (Convert::MetersToMapUnits(origin.x), Convert::MetersToMapUnits(origin.y), 0.0f);
+    glm::vec3 delta (Convert::MetersToMapUnits(destination.x) - start.x, Convert::MetersToMapUnits(destination.y) - start.y, 0.0f);
+
+    RaycastTraversal traversal (start, delta, 2);
+    for (;;)
+    {
+        const glm::ivec3& block = traversal.mBlock;
+        if (block.x < 0 || block.x >= MAP_DIMENSIONS || block.y < 0 || block.y >= MAP_DIMENSIONS)
+            return false;
+
+        const MapBlockInfo* blockInfo = gameMap.GetBlockInfo(block.x, block.y, layer);
+        if (blockInfo->mGroundType == eGroundType_Building)
+        {
+            glm::vec3 normal = traversal.GetEnterNormal();
+            SetRaycastHit(traversal, traversal.mEnterT, glm::ivec3(block.x, layer, block.y), glm::vec3(normal.x, 0.0f, normal.y), outHit);
+            // remap traversal axes to map axes
+            outHit.mPosition = glm::vec3(outHit.mPosition.x, Convert::MapUnitsToMeters((float) layer), outHit.mPosition.y);
+            return true;
+        }
+
+        if (traversal.GetExitT() >= 1.0f)
+            return false;
+
+        traversal.Advance();
+    }
+}
+
+bool GameMapRaycast::Raycast3D(const GameMap& gameMap, const glm::vec3& origin, const glm::vec3& destination, MapRaycastHit& outHit)
+{
+    outHit = MapRaycastHit();
+
+    glm::vec3 start = MetersToMapUnits3(origin);
+    RaycastTraversal traversal (start, MetersToMapUnits3(destination) - start, 3);
+    for (;;)
+    {
+        const glm::ivec3& block = traversal.mBlock;
+        if (block.x < 0 || block.x >= MAP_DIMENSIONS || block.z < 0 || block.z >= MAP_DIMENSIONS || block.y < 0)
+            return false;
+
+        if (block.y >= MAP_LAYERS_COUNT)
+        {
+            // nothing to hit above map
+            if (traversal.mStep.y >= 0)
+                return false;
+        }
+        else
+        {
+            // floor crossed, it belongs to upper block when going down
+            if (traversal.mEnterAxis == 1)
+            {
+                glm::ivec3 floorBlock = block;
+                if (traversal.mStep.y < 0)
+                {
+                    ++floorBlock.y;
+                }
+                if ((floorBlock.y < MAP_LAYERS_COUNT) && IsFloorBlock(gameMap.GetBlockInfo(floorBlock.x, floorBlock.z, floorBlock.y)))
+                {
+                    SetRaycastHit(traversal, traversal.mEnterT, floorBlock, traversal.GetEnterNormal(), outHit);
+                    return true;
+                }
+            }
+
+            const MapBlockInfo* blockInfo = gameMap.GetBlockInfo(block.x, block.z, block.y);
+            if (blockInfo->mGroundType == eGroundType_Building)
+            {
+                SetRaycastHit(traversal, traversal.mEnterT, block, traversal.GetEnterNormal(), outHit);
+                return true;
+            }
+
+            if (IsRampBlock(blockInfo))
+            {
+                // surface is linear within block, so sign change of height above it gives intersection
+                const float exitT = traversal.GetExitT();
+                glm::vec3 enterPoint = traversal.GetPoint(traversal.mEnterT);
+                glm::vec3 exitPoint = traversal.GetPoint(exitT);
+                float enterHeight = enterPoint.y - (block.y + GetRampHeight(blockInfo, block, enterPoint));
+                float exitHeight = exitPoint.y - (block.y + GetRampHeight(blockInfo, block, exitPoint));
+                if (enterHeight < 0.0f)
+                {
+                    // side of ramp
+                    SetRaycastHit(traversal, traversal.mEnterT, block, traversal.GetEnterNormal(), outHit);
+                    return true;
+                }
+                if (exitHeight < 0.0f)
+                {
+                    float hitT = traversal.mEnterT + (exitT - traversal.mEnterT) * (enterHeight / (enterHeight - exitHeight));
+                    glm::vec3 hitPoint = traversal.GetPoint(hitT);
+                    float cx = glm::clamp(hitPoint.x - block.x, 0.0f, 1.0f);
+                    float cz = glm::clamp(hitPoint.z - block.z, 0.0f, 1.0f);
+                    float slopex = GameMapHelpers::GetSlopeHeight(blockInfo->mSlopeType, 1.0f, cz) - GameMapHelpers::GetSlopeHeight(blockInfo->mSlopeType, 0.0f, cz);
+                    float slopez = GameMapHelpers::GetSlopeHeight(blockInfo->mSlopeType, cx, 1.0f) - GameMapHelpers::GetSlopeHeight(blockInfo->mSlopeType, cx, 0.0f);
+                    SetRaycastHit(traversal, hitT, block, glm::normalize(glm::vec3(-slopex, 1.0f, -slopez)), outHit);
+                    return true;
+                }
+            }
+        }
+
+        if (traversal.GetExitT() >= 1.0f)
+            return false;
+
+        traversal.Advance();
+    }
+}
+
+void GameMapRaycast::RaycastBatch3D(const GameMap& gameMap, const std::vector<MapRaycastQuery>& queries, std::vector<MapRaycastHit>& outHits, int beginIndex, int endIndex)
+{
+    cxx_assert(outHits.size() == queries.size());
+    cxx_assert(beginIndex >= 0 && endIndex <= (int) queries.size());
+
+    for (int iquery = beginIndex; iquery < endIndex; ++iquery)
+    {
+        const MapRaycastQuery& currQuery = queries[iquery];
+        Raycast3D(gameMap, currQuery.mOrigin, currQuery.mDestination, outHits[iquery]);
+    }
+}
+
+bool GameMapRaycast::HasLineOfSight(const GameMap& gameMap, const glm::vec3& pointA, const glm::vec3& pointB)
+{
+    MapRaycastHit hit;
+    return !Raycast3D(gameMap, pointA, pointB, hit);
+}
+
+void GameMapRaycast::GetVisibleBlocks(const GameMap& gameMap, const Point& originBlock, int layer, int radius, std::vector<Point>& outBlocks)
+{
+    outBlocks.clear();
+
+    if (radius < 0 || layer < 0 || layer >= MAP_LAYERS_COUNT)
+        return;
+
+    const int windowSize = radius * 2 + 1;
+    VisibleBlocksContext context { gameMap, originBlock, layer, radius, std::vector<bool>(windowSize * windowSize), outBlocks };
+    AddVisibleBlock(context, originBlock);
+
+    for (const auto& currOctant: ShadowcastOctants)
+    {
+        CastVisibilityOctant(context, 1, 1.0f, 0.0f, currOctant);
+    }
+}
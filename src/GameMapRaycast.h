@@ -0,0 +1,68 @@
+#pragma once
+
+#include "GameDefs.h"
+
+// forwards
+class GameMap;
+
+// map blocks raycast result
+struct MapRaycastHit
+{
+public:
+    bool mHasHit = false;
+    glm::vec3 mPosition; // hit point, meters
+    glm::vec3 mNormal; // hit surface normal
+    glm::ivec3 mBlock; // hit block x, layer, z
+    float mFraction = 1.0f; // distance from ray origin to hit point in fractions of ray length
+};
+
+// map blocks raycast request for batched queries
+struct MapRaycastQuery
+{
+public:
+    glm::vec3 mOrigin; // meters
+    glm::vec3 mDestination; // meters
+};
+
+// defines raycast and visibility queries over map blocks grid
+// block at layer L occupies heights [L, L + 1] map units: buildings are solid cubes, slopes are solid below their surface,
+// other blocks except air and water are floors at layer height, same as ground heights in GameMap::GetHeightAtPosition
+// queries are read only and can be used from worker threads simultaneously
+class GameMapRaycast final
+{
+public:
+    // Trace ray on single map layer against buildings
+    // @param gameMap: Source map data
+    // @param origin, destination: Ray points, meters
+    // @param layer: Map layer
+    // @param outHit: Output hit info
+    // @returns false if there is no hit
+    static bool Raycast2D(const GameMap& gameMap, const glm::vec2& origin, const glm::vec2& destination, int layer, MapRaycastHit& outHit);
+
+    // Trace ray through map layers against buildings, slopes and floors
+    // @param gameMap: Source map data
+    // @param origin, destination: Ray points, meters
+    // @param outHit: Output hit info
+    // @returns false if there is no hit
+    static bool Raycast3D(const GameMap& gameMap, const glm::vec3& origin, const glm::vec3& destination, MapRaycastHit& outHit);
+
+    // Trace multiple rays through map layers, ranges of same batch can be processed in different jobs
+    // @param gameMap: Source map data
+    // @param queries: Rays list
+    // @param outHits: Output hit infos in same order as rays, should be same size as rays list
+    // @param beginIndex, endIndex: Range of rays to process
+    static void RaycastBatch3D(const GameMap& gameMap, const std::vector<MapRaycastQuery>& queries, std::vector<MapRaycastHit>& outHits, int beginIndex, int endIndex);
+
+    // Test whether there are no map blocks between two points
+    // @param gameMap: Source map data
+    // @param pointA, pointB: Points, meters
+    static bool HasLineOfSight(const GameMap& gameMap, const glm::vec3& pointA, const glm::vec3& pointB);
+
+    // Find map blocks visible from block on single map layer, buildings block sight but are visible themselves
+    // @param gameMap: Source map data
+    // @param originBlock: Viewer block x, z
+    // @param layer: Map layer
+    // @param radius: Max view distance, blocks
+    // @param outBlocks: Output visible blocks including origin block, each block is listed once
+    static void GetVisibleBlocks(const GameMap& gameMap, const Point& originBlock, int layer, int radius, std::vector<Point>& outBlocks);
+};
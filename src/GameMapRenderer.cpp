@@ -140,6 +140,7 @@ void GameMapRenderer::DrawGameObject(GameCamera& gameCamera, GameObject* gameObj
     // detect if gameobject is visible on screen
     if (!debugSkipDraw && gameObject->IsOnScreen(gameCamera.mOnScreenMapArea))
     {
+        gameObject->RefreshDrawHeight();
         mSpriteBatch.DrawSprite(gameObject->mDrawSprite);
 
         ++mRenderStats.mSpritesDrawnCount;
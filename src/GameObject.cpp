@@ -72,8 +72,6 @@ void GameObject::SetPhysics(PhysicsBody* physicsBody)
         mPhysicsBody->ClearForces();
         mPhysicsBody->SetTransform(mTransform.mPosition, mTransform.mOrientation);
     }
-
-    ClearContacts();
 }
 
 void GameObject::UpdateFrame()
@@ -86,9 +84,9 @@ void GameObject::SimulationStep()
     // do nothing
 }
 
-bool GameObject::ShouldCollide(GameObject* otherObject) const
+void GameObject::SimulationStepSimplified()
 {
-    return true;
+    SimulationStep();
 }
 
 void GameObject::HandleCollision(const Collision& collision)
@@ -101,6 +99,21 @@ void GameObject::HandleCollisionWithMap(const MapCollision& collision)
     // do nothing
 }
 
+void GameObject::HandleContactBegin(const Contact& contact)
+{
+    // do nothing
+}
+
+void GameObject::HandleContactPersist(const Contact& contact)
+{
+    // do nothing
+}
+
+void GameObject::HandleContactEnd(const Contact& contact)
+{
+    // do nothing
+}
+
 void GameObject::HandleFallingStarts()
 {
     // do nothing
@@ -148,9 +161,25 @@ void GameObject::RefreshDrawSprite()
     mDrawSprite.mPosition.y = mTransformSmooth.mPosition.z;
 
     mDrawSprite.mHeight = mTransformSmooth.mPosition.y;
+    mDrawSprite.GetApproximateBounds(mDrawBounds);
+
+    // draw height depends on map, it is computed only when object is about to be drawn
+    mDrawHeightDirty = true;
+}
+
+void GameObject::RefreshDrawHeight()
+{
+    if (!mDrawHeightDirty)
+        return;
+
+    mDrawHeightDirty = false;
+    if (!mDrawSprite)
+        return;
 
     if (mParentObject)
     {
+        // parent goes first
+        mParentObject->RefreshDrawHeight();
         if (mParentObject->mDrawSprite.mHeight > mDrawSprite.mHeight)
         {
             mDrawSprite.mHeight = mParentObject->mDrawSprite.mHeight;
@@ -159,48 +188,61 @@ void GameObject::RefreshDrawSprite()
     else if ((mPhysicsBody == nullptr) || !mPhysicsBody->mFalling)
     // compute draw height for non-attached objects
     {
-        float newDrawHeight = mDrawSprite.mHeight;
-
+        glm::vec3 points[4];
         if (IsPedestrianClass())
         {
             const float halfBox = Convert::PixelsToMeters(PED_SPRITE_DRAW_BOX_SIZE_PX) * 0.5f;
-            glm::vec3 points[4] = 
-            {
-                { -halfBox, mTransformSmooth.mPosition.y + 0.01f, -halfBox },
-                {  halfBox, mTransformSmooth.mPosition.y + 0.01f, -halfBox },
-                {  halfBox, mTransformSmooth.mPosition.y + 0.01f,  halfBox },
-                { -halfBox, mTransformSmooth.mPosition.y + 0.01f,  halfBox },
-            };
-            for (glm::vec3& currPoint: points)
-            {
-                currPoint.x += mTransformSmooth.mPosition.x;
-                currPoint.z += mTransformSmooth.mPosition.z;
-                // get height
-                float height = gGame.mMap.GetHeightAtPosition(currPoint);
-                if (height > newDrawHeight)
-                {
-                    newDrawHeight = height;
-                }
-            }
+            const float pointsHeight = mTransformSmooth.mPosition.y + 0.01f;
+            points[0] = { mTransformSmooth.mPosition.x - halfBox, pointsHeight, mTransformSmooth.mPosition.z - halfBox };
+            points[1] = { mTransformSmooth.mPosition.x + halfBox, pointsHeight, mTransformSmooth.mPosition.z - halfBox };
+            points[2] = { mTransformSmooth.mPosition.x + halfBox, pointsHeight, mTransformSmooth.mPosition.z + halfBox };
+            points[3] = { mTransformSmooth.mPosition.x - halfBox, pointsHeight, mTransformSmooth.mPosition.z + halfBox };
         }
         else
         {
             glm::vec2 corners[4];
             mDrawSprite.GetCorners(corners);
-            for (glm::vec2& currCorner: corners)
+            for (int icorner = 0; icorner < 4; ++icorner)
+            {
+                points[icorner] = glm::vec3(corners[icorner].x, mTransformSmooth.mPosition.y, corners[icorner].y);
+            }
+        }
+
+        // map height at point depends only on block column and layer unless there is slope,
+        // so probes are skipped while object moves within same blocks
+        bool sameBlocks = mDrawHeightCacheValid && !mDrawHeightCacheSlope;
+        for (int ipoint = 0; ipoint < 4; ++ipoint)
+        {
+            glm::ivec3 currBlock = Convert::MetersToMapUnits(points[ipoint]);
+            if (currBlock != mDrawHeightCacheBlocks[ipoint])
+            {
+                mDrawHeightCacheBlocks[ipoint] = currBlock;
+                sameBlocks = false;
+            }
+        }
+
+        if (!sameBlocks)
+        {
+            mDrawHeightCacheValid = true;
+            mDrawHeightCacheSlope = false;
+            mDrawHeightCache = 0.0f;
+            for (int ipoint = 0; ipoint < 4; ++ipoint)
             {
-                float height = gGame.mMap.GetHeightAtPosition(glm::vec3(currCorner.x, mTransformSmooth.mPosition.y, currCorner.y));
-                if (height > newDrawHeight)
+                bool isSlope = false;
+                float height = gGame.mMap.GetHeightAtPosition(points[ipoint], true, isSlope);
+                if (ipoint == 0 || height > mDrawHeightCache)
                 {
-                    newDrawHeight = height;
+                    mDrawHeightCache = height;
                 }
+                mDrawHeightCacheSlope = mDrawHeightCacheSlope || isSlope;
             }
         }
 
-        mDrawSprite.mHeight = newDrawHeight;
+        if (mDrawHeightCache > mDrawSprite.mHeight)
+        {
+            mDrawSprite.mHeight = mDrawHeightCache;
+        }
     }
-
-    mDrawSprite.GetApproximateBounds(mDrawBounds);
 }
 
 void GameObject::OnParentTransformChanged()
@@ -291,27 +333,12 @@ void GameObject::SyncPhysicsTransform()
     }
 }
 
-void GameObject::ClearContacts()
-{
-    mObjectsContacts.clear();
-}
-
-void GameObject::RegisterContact(const Contact& contactInfo)
-{
-    cxx_assert(contactInfo.mThisObject == this);
-    cxx_assert(contactInfo.mThatObject && (contactInfo.mThatObject != contactInfo.mThisObject));
-
-    mObjectsContacts.push_back(contactInfo);
-}
-
-void GameObject::UnregisterContactsWithObject(GameObject* otherObject)
+ContactsList GameObject::GetContacts() const
 {
-    cxx_assert(otherObject);
+    if (mPhysicsBody == nullptr)
+        return ContactsList();
 
-    cxx::erase_elements_if(mObjectsContacts, [otherObject](const Contact& currContact)
-    {
-        return (currContact.mThatObject == otherObject);
-    });
+    return gGame.mPhysicsMng.GetContacts(mPhysicsBody);
 }
 
 void GameObject::InterpolateTransform(float factor)
@@ -44,13 +44,21 @@ public:
     // Process physics simulation
     virtual void SimulationStep();
 
-    // Whether collision is possible between two contacting game objects
-    virtual bool ShouldCollide(GameObject* otherObject) const;
+    // Process cheap physics simulation for distant objects, collisions are not detected
+    // By default regular simulation step is used
+    virtual void SimulationStepSimplified();
 
     // Handle collision contact between game objects - after it was resolved
     virtual void HandleCollision(const Collision& collision);
     virtual void HandleCollisionWithMap(const MapCollision& collision);
 
+    // Handle contacts with objects that does not collide physically, sent once per objects pair after simulation step
+    // Contact end receives last known contact, other object is still alive at that moment
+    // Objects must not be destroyed immediately within contact handlers, mark them for deletion instead
+    virtual void HandleContactBegin(const Contact& contact);
+    virtual void HandleContactPersist(const Contact& contact);
+    virtual void HandleContactEnd(const Contact& contact);
+
     // Handle additional physics events
     virtual void HandleFallingStarts();
     virtual void HandleFallsOnGround(float fallDistance);
@@ -127,14 +135,16 @@ protected:
     void SetPhysics(PhysicsBody* physicsBody);
     void SetParentObject(GameObject* gameObject);
     void RefreshDrawSprite();
+    // Compute draw height of sprite if it is out of date, parent objects are processed first
+    void RefreshDrawHeight();
 
     void OnParentTransformChanged();
     void OnTransformChanged();
 
     void SyncPhysicsTransform();
-    void ClearContacts();
-    void RegisterContact(const Contact& contactInfo);
-    void UnregisterContactsWithObject(GameObject* otherObject);
+
+    // Get contacts with other objects registered on last simulation step
+    ContactsList GetContacts() const;
 
     void InterpolateTransform(float factor);
 
@@ -143,13 +153,18 @@ protected:
     GameObject* mParentObject = nullptr;
 
     std::vector<GameObject*> mAttachedObjects;
-    std::vector<Contact> mObjectsContacts; // list of contacting colliders (non triggers) on last simulation frame
 
     // drawing spricific data
     Sprite2D mDrawSprite;
     eSpriteOrientation mDrawSpriteOrientation = eSpriteOrientation_S;
     int mRemapClut = 0;
     cxx::aabbox2d_t mDrawBounds; // sprite bounds cache
+    bool mDrawHeightDirty = true; // draw height should be recomputed before drawing
+    // map height under sprite probes, valid while probes stay within same blocks
+    glm::ivec3 mDrawHeightCacheBlocks[4];
+    float mDrawHeightCache = 0.0f;
+    bool mDrawHeightCacheValid = false;
+    bool mDrawHeightCacheSlope = false; // some of probes hit slope block, cache cannot be reused
 
 private:
     // marked object will be destroyed next game frame
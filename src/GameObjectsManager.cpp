@@ -389,7 +389,7 @@ void GameObjectsManager::DestroyAllObjects()
 
 void GameObjectsManager::DestroyMarkedForDeletionObjects()
 {
-    std::vector<GameObject*> toDeleteObjectsList;
+    FrameHeapVector<GameObject*> toDeleteObjectsList (gSystem.mMemoryMng.GetFrameHeapAllocator());
     for (GameObject* currGameObject: mAllObjects)
     {
         if (currGameObject->IsMarkedForDeletion())
@@ -51,10 +51,27 @@ void GameParams::SetToDefaults()
     // ai
     mAiReactOnGunshotsDistance = Convert::MapUnitsToMeters(4.0f);
     mAiReactOnExplosionsDistance = Convert::MapUnitsToMeters(5.0f);
+    mAiLodFullRateDistance = Convert::MapUnitsToMeters(3.0f);
+    mAiLodFarUpdatesPerFrame = 16;
+    mAiPerceptionInterval = 0.2f;
+    mAiPathfindingBudget = 8192;
+    mAiPathCacheSize = 256;
+    mAiFlowFieldBudget = 4096;
+    mAiFlowFieldLifetime = 3.0f;
+    mAiDriverCruiseSpeed = Convert::MapUnitsToMeters(3.0f);
+    mAiDriverTurnSpeed = Convert::MapUnitsToMeters(1.25f);
+    mAiDriverMinGap = Convert::MapUnitsToMeters(1.5f);
+    mAiDriverTimeGap = 0.75f;
+    mAiDriverLookAheadDistance = Convert::MapUnitsToMeters(6.0f);
+    mAiCrowdNeighbourDistance = Convert::MapUnitsToMeters(0.5f);
+    mAiCrowdTimeHorizon = 1.5f;
     // hud
     mHudBigFontMessageShowDuration = 3.0f;
     mHudCarNameShowDuration = 3.0f;
     mHudDistrictNameShowDuration = 3.0f;
     // collision
     mSparksOnCarsContactThreshold = 60.0f;
+    // physics
+    mPhysicsLodDistance = Convert::MapUnitsToMeters(2.0f);
+    mPhysicsLodHysteresis = Convert::MapUnitsToMeters(0.5f);
 }
\ No newline at end of file
@@ -60,6 +60,20 @@ public:
     // ai
     float mAiReactOnGunshotsDistance; // how far pedestrians can hear gunshots
     float mAiReactOnExplosionsDistance; // how far pedestrians can hear explosions
+    float mAiLodFullRateDistance; // ai within this distance from visible area or player updates every frame, meters
+    int mAiLodFarUpdatesPerFrame; // max number of distant ai controllers updated per frame
+    float mAiPerceptionInterval; // how often ai scans surroundings for threats and leader, seconds
+    int mAiPathfindingBudget; // max number of search nodes expanded per frame, pending queries are postponed
+    int mAiPathCacheSize; // max number of completed path queries kept for sharing
+    int mAiFlowFieldBudget; // max number of blocks processed by flow fields builds per frame
+    float mAiFlowFieldLifetime; // how long flow field is kept after last request, seconds
+    float mAiDriverCruiseSpeed; // traffic car speed on straight lanes, meters per second
+    float mAiDriverTurnSpeed; // traffic car speed when approaching turn, meters per second
+    float mAiDriverMinGap; // min distance between centers of traffic car and car ahead, meters
+    float mAiDriverTimeGap; // time to close distance to car ahead, seconds
+    float mAiDriverLookAheadDistance; // how far traffic car driver checks cars ahead, meters
+    float mAiCrowdNeighbourDistance; // how far walking pedestrian looks for other pedestrians to avoid, meters
+    float mAiCrowdTimeHorizon; // how early walking pedestrian reacts on predicted collision, seconds
 
     // hud
     float mHudBigFontMessageShowDuration; // how long show 'wasted' on screen, seconds
@@ -68,4 +82,8 @@ public:
 
     // collision
     float mSparksOnCarsContactThreshold; // how strong should the collision be for sparks to appear
+
+    // physics
+    float mPhysicsLodDistance; // cars and pedestrians beyond this distance from visible area are simulated without box2d, meters
+    float mPhysicsLodHysteresis; // extra distance required to leave full simulation, prevents frequent switching, meters
 };
\ No newline at end of file
@@ -354,20 +354,18 @@ void GameplayGamestate::EnterOrExitCar(bool alternative)
         return;
     }
 
-    PhysicsQueryResult queryResults;
+    PhysicsQueryResult queryResults (gSystem.mMemoryMng.GetFrameHeapAllocator());
 
     glm::vec3 pos = gGame.mPlayerState.mCharacter->mPhysicsBody->GetPosition();
     glm::vec2 posA { pos.x, pos.z };
     glm::vec2 posB = posA + (gGame.mPlayerState.mCharacter->mPhysicsBody->GetSignVector() * gGame.mParams.mPedestrianSpotTheCarDistance);
 
-    gGame.mPhysicsMng.QueryObjectsLinecast(posA, posB, queryResults, CollisionGroup_Car);
+    gGame.mPhysicsMng.QueryObjectsLinecast(posA, posB, PhysicsQueryFilter(CollisionGroup_Car, eGameObjectClass_Car), queryResults);
 
-    // process all cars
-    for (int iElement = 0; iElement < queryResults.mElementsCount; ++iElement)
+    // process nearest car
+    for (const PhysicsQueryElement& currElement: queryResults)
     {
-        PhysicsBody* physicsBody = queryResults.mElements[iElement].mPhysicsObject;
-        cxx_assert(physicsBody);
-        cxx_assert(physicsBody->mGameObject);
+        PhysicsBody* physicsBody = currElement.mPhysicsObject;
         cxx_assert(physicsBody->mGameObject->IsVehicleClass());
 
         Vehicle* carObject = (Vehicle*) physicsBody->mGameObject;
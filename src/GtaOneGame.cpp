@@ -21,6 +21,11 @@ CvarVoid gCvarDbgDumpSpriteDeltas("dbg_dumpSpriteDeltas", "Dump sprite deltas",
 CvarVoid gCvarDbgDumpBlockTextures("dbg_dumpBlocks", "Dump block textures", CvarFlags_None);
 CvarVoid gCvarDbgDumpSprites("dbg_dumpSprites", "Dump all sprites", CvarFlags_None);
 CvarVoid gCvarDbgDumpCarSprites("dbg_dumpCarSprites", "Dump car sprites", CvarFlags_None);
+CvarVoid gCvarDbgBenchCarPhysics("dbg_benchCarPhysics", "Compare batched and per car tire forces computation", CvarFlags_None);
+CvarVoid gCvarDbgBenchPathfinding("dbg_benchPathfinding", "Measure pedestrians pathfinding queries per second on current map", CvarFlags_None);
+CvarVoid gCvarDbgBenchTraffic("dbg_benchTraffic", "Measure frame time with many ai driven traffic cars on current map", CvarFlags_None);
+CvarVoid gCvarDbgBenchPedLocomotion("dbg_benchPedLocomotion", "Compare batched and per pedestrian locomotion computation", CvarFlags_None);
+CvarVoid gCvarDbgTestProjectiles("dbg_testProjectiles", "Check that point blank shot hits adjacent pedestrian", CvarFlags_None);
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -314,6 +319,9 @@ bool GtaOneGame::StartScenario(const std::string& mapName)
         return false;
     }
 
+    mRoadNetwork.BuildFromMap(mMap);
+    mPathfinder.BuildFromMap(mMap);
+
     // load corresponding style data
     std::string styleFileName = mMap.GetStyleFileName();
 
@@ -397,6 +405,11 @@ void GtaOneGame::ShutdownCurrentScenario()
     mObjectsMng.ClearWorld();
     mPhysicsMng.ClearWorld();
     mStyleData.Cleanup();
+    mRoadNetwork.Cleanup();
+    mPathfinder.Cleanup();
+    mFlowFields.Cleanup();
+    mRoadTraffic.Cleanup();
+    mCrowdAvoidance.Cleanup();
     mMap.Cleanup();
     mAudioMng.ReleaseLevelSounds();
     mParticlesMng.ClearWorld();
@@ -468,6 +481,40 @@ void GtaOneGame::ProcessDebugCvars()
         mSpritesMng.DumpCarsTextures(savePath);
         gSystem.LogMessage(eLogMessage_Info, "Car sprites path is '%s'", savePath.c_str());
     }
+
+    if (gCvarDbgBenchCarPhysics.IsModified())
+    {
+        gCvarDbgBenchCarPhysics.ClearModified();
+        const int NumBenchmarkCars = 500;
+        mPhysicsMng.RunVehiclesDynamicsBenchmark(NumBenchmarkCars);
+    }
+
+    if (gCvarDbgBenchPathfinding.IsModified())
+    {
+        gCvarDbgBenchPathfinding.ClearModified();
+        const int NumBenchmarkQueries = 10000;
+        mPathfinder.RunBenchmark(NumBenchmarkQueries);
+    }
+
+    if (gCvarDbgBenchTraffic.IsModified())
+    {
+        gCvarDbgBenchTraffic.ClearModified();
+        const int NumBenchmarkCars = 300;
+        mTrafficMng.RunDrivingBenchmark(NumBenchmarkCars);
+    }
+
+    if (gCvarDbgBenchPedLocomotion.IsModified())
+    {
+        gCvarDbgBenchPedLocomotion.ClearModified();
+        const int NumBenchmarkPeds = 2000;
+        mPhysicsMng.RunPedestriansLocomotionBenchmark(NumBenchmarkPeds);
+    }
+
+    if (gCvarDbgTestProjectiles.IsModified())
+    {
+        gCvarDbgTestProjectiles.ClearModified();
+        mPhysicsMng.RunPointBlankProjectileTest();
+    }
 }
 
 void GtaOneGame::SetCurrentGamestate(Gamestate* gamestate)
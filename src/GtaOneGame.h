@@ -1,6 +1,11 @@
 #pragma once
 
 #include "GameMap.h"
+#include "RoadNetwork.h"
+#include "AiPathfinder.h"
+#include "AiFlowFields.h"
+#include "AiRoadTraffic.h"
+#include "AiCrowdAvoidance.h"
 #include "GameObjectsManager.h"
 #include "PlayerState.h"
 #include "GameplayGamestate.h"
@@ -41,6 +46,11 @@ public:
     GameCamera mCamera;
     GameParams mParams;
     GameMap mMap;
+    RoadNetwork mRoadNetwork;
+    AiPathfinder mPathfinder;
+    AiFlowFields mFlowFields;
+    AiRoadTraffic mRoadTraffic;
+    AiCrowdAvoidance mCrowdAvoidance;
     GameHUD mHUD;
     StyleData mStyleData;
     PlayerState mPlayerState;
@@ -0,0 +1,399 @@
+#include "stdafx.h"
+#include "JobSystem.h"
+
+//////////////////////////////////////////////////////////////////////////
+
+// index of worker queue associated with current thread, main thread uses queue 0
+static thread_local int gCurrentWorkerIndex = 0;
+
+//////////////////////////////////////////////////////////////////////////
+
+bool JobSystem::Initialize(int numWorkers)
+{
+    gSystem.LogMessage(eLogMessage_Info, "Init JobSystem (%d workers)", numWorkers);
+
+    cxx_assert(mWorkerQueues.empty());
+    cxx_assert(numWorkers >= 0);
+
+    numWorkers = std::max(numWorkers, 0);
+
+    mShutdownRequested = false;
+    mQueuedJobsCount = 0;
+
+    // main thread queue goes first
+    for (int iqueue = 0; iqueue < numWorkers + 1; ++iqueue)
+    {
+        mWorkerQueues.push_back(new WorkerQueue);
+    }
+
+    mWorkerThreads.reserve(numWorkers);
+    for (int iworker = 0; iworker < numWorkers; ++iworker)
+    {
+        int workerIndex = iworker + 1;
+        mWorkerThreads.emplace_back(&JobSystem::WorkerThreadProc, this, workerIndex);
+    }
+    return true;
+}
+
+void JobSystem::Deinit()
+{
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mShutdownRequested = true;
+    }
+    mWakeCondition.notify_all();
+
+    for (std::thread& currThread: mWorkerThreads)
+    {
+        currThread.join();
+    }
+    mWorkerThreads.clear();
+
+    // complete remaining jobs on calling thread
+    for (;;)
+    {
+        JobSystemJob* job = TryGetJob(0);
+        if (job == nullptr)
+            break;
+
+        ExecuteJob(job);
+    }
+
+    for (WorkerQueue* currQueue: mWorkerQueues)
+    {
+        cxx_assert(currQueue->mJobs.empty());
+        delete currQueue;
+    }
+    mWorkerQueues.clear();
+    mJobsPool.cleanup();
+}
+
+int JobSystem::GetWorkersCount() const
+{
+    return (int) mWorkerThreads.size();
+}
+
+int JobSystem::GetCurrentWorkerIndex()
+{
+    return gCurrentWorkerIndex;
+}
+
+void JobSystem::ScheduleJob(const JobProc& jobProc, JobCounter* counter, JobCounter* dependency)
+{
+    cxx_assert(jobProc);
+
+    JobSystemJob* job = AllocJob();
+    job->mProc = jobProc;
+    job->mCounter = counter;
+    SubmitJob(job, dependency);
+}
+
+void JobSystem::SubmitJob(JobSystemJob* job, JobCounter* dependency)
+{
+    if (job->mCounter)
+    {
+        job->mCounter->mPendingJobs.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    if (dependency)
+    {
+        std::lock_guard<std::mutex> lock(dependency->mMutex);
+        if (!dependency->IsDone())
+        {
+            // will be scheduled when dependency completes
+            dependency->mContinuations.push_back(job);
+            return;
+        }
+    }
+
+    EnqueueJob(job);
+}
+
+void JobSystem::WaitForCounter(JobCounter& counter)
+{
+    while (!counter.IsDone())
+    {
+        JobSystemJob* job = TryGetJob(gCurrentWorkerIndex);
+        if (job)
+        {
+            ExecuteJob(job);
+            continue;
+        }
+        std::this_thread::yield();
+    }
+
+    // make sure that finishing thread is out of counter critical section
+    std::lock_guard<std::mutex> lock(counter.mMutex);
+}
+
+void JobSystem::ParallelFor(int elementsCount, int batchSize, const ParallelForProc& forProc)
+{
+    if (elementsCount < 1)
+        return;
+
+    batchSize = std::max(batchSize, 1);
+
+    int numBatches = (elementsCount + batchSize - 1) / batchSize;
+    if ((numBatches == 1) || mWorkerThreads.empty())
+    {
+        forProc(0, elementsCount);
+        return;
+    }
+
+    JobCounter counter;
+    // first batch is processed by calling thread
+    for (int ibatch = 1; ibatch < numBatches; ++ibatch)
+    {
+        JobSystemJob* job = AllocJob();
+        job->mCounter = &counter;
+        job->mForProc = &forProc;
+        job->mBeginIndex = ibatch * batchSize;
+        job->mEndIndex = std::min(job->mBeginIndex + batchSize, elementsCount);
+        SubmitJob(job, nullptr);
+    }
+
+    forProc(0, batchSize);
+    WaitForCounter(counter);
+}
+
+void JobSystem::WorkerThreadProc(int workerIndex)
+{
+    gCurrentWorkerIndex = workerIndex;
+
+    for (;;)
+    {
+        JobSystemJob* job = TryGetJob(workerIndex);
+        if (job)
+        {
+            ExecuteJob(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mWakeMutex);
+        mWakeCondition.wait(lock, [this]()
+            {
+                return mShutdownRequested || (mQueuedJobsCount.load() > 0);
+            });
+
+        if (mShutdownRequested)
+            break;
+    }
+}
+
+JobSystemJob* JobSystem::AllocJob()
+{
+    std::lock_guard<std::mutex> lock(mJobsPoolMutex);
+    JobSystemJob* job = mJobsPool.create();
+    cxx_assert(job);
+    return job;
+}
+
+void JobSystem::FreeJob(JobSystemJob* job)
+{
+    std::lock_guard<std::mutex> lock(mJobsPoolMutex);
+    mJobsPool.destroy(job);
+}
+
+void JobSystem::EnqueueJob(JobSystemJob* job)
+{
+    // execute immediately if there is no workers
+    if (mWorkerThreads.empty())
+    {
+        ExecuteJob(job);
+        return;
+    }
+
+    int queueIndex = gCurrentWorkerIndex;
+    if (queueIndex >= (int) mWorkerQueues.size())
+    {
+        queueIndex = 0;
+    }
+
+    WorkerQueue* queue = mWorkerQueues[queueIndex];
+    {
+        std::lock_guard<std::mutex> lock(queue->mMutex);
+        queue->mJobs.push_back(job);
+    }
+
+    // wake up sleeping worker
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        ++mQueuedJobsCount;
+    }
+    mWakeCondition.notify_one();
+}
+
+void JobSystem::ExecuteJob(JobSystemJob* job)
+{
+    cxx_assert(job);
+
+    if (job->mForProc)
+    {
+        (*job->mForProc)(job->mBeginIndex, job->mEndIndex);
+    }
+    else
+    {
+        job->mProc();
+    }
+
+    JobCounter* counter = job->mCounter;
+    FreeJob(job);
+
+    if (counter)
+    {
+        FinishJob(counter);
+    }
+}
+
+void JobSystem::FinishJob(JobCounter* counter)
+{
+    std::vector<JobSystemJob*> continuations;
+    {
+        std::lock_guard<std::mutex> lock(counter->mMutex);
+        if (counter->mPendingJobs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            continuations.swap(counter->mContinuations);
+        }
+    }
+    // counter might be already destroyed at this point
+    for (JobSystemJob* currJob: continuations)
+    {
+        EnqueueJob(currJob);
+    }
+}
+
+JobSystemJob* JobSystem::TryGetJob(int workerIndex)
+{
+    const int numQueues = (int) mWorkerQueues.size();
+    if (numQueues == 0)
+        return nullptr;
+
+    // own queue first, newest jobs are hot in cache
+    {
+        WorkerQueue* queue = mWorkerQueues[workerIndex];
+        std::lock_guard<std::mutex> lock(queue->mMutex);
+        if (!queue->mJobs.empty())
+        {
+            JobSystemJob* job = queue->mJobs.back();
+            queue->mJobs.pop_back();
+            --mQueuedJobsCount;
+            return job;
+        }
+    }
+
+    // steal oldest job from other queues
+    for (int ioffset = 1; ioffset < numQueues; ++ioffset)
+    {
+        WorkerQueue* queue = mWorkerQueues[(workerIndex + ioffset) % numQueues];
+        std::lock_guard<std::mutex> lock(queue->mMutex);
+        if (!queue->mJobs.empty())
+        {
+            JobSystemJob* job = queue->mJobs.front();
+            queue->mJobs.pop_front();
+            --mQueuedJobsCount;
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::RunStressTest()
+{
+    gSystem.LogMessage(eLogMessage_Info, "JobSystem stress test started");
+
+    const int initialWorkersCount = GetWorkersCount();
+    const int maxWorkersCount = std::max((int) std::thread::hardware_concurrency() - 1, initialWorkersCount);
+
+    const int NumElements = 1024 * 1024;
+    const int NumIterations = 8;
+    std::vector<float> elements(NumElements);
+
+    bool testsPassed = true;
+    double baseTime = 0.0;
+
+    for (int numWorkers = 0; numWorkers <= maxWorkersCount; ++numWorkers)
+    {
+        Deinit();
+        Initialize(numWorkers);
+
+        // parallel for correctness
+        std::vector<int> values(NumElements, 0);
+        ParallelFor(NumElements, 1000, [&values](int beginIndex, int endIndex)
+            {
+                for (int icurr = beginIndex; icurr < endIndex; ++icurr)
+                {
+                    values[icurr] += (icurr * 2);
+                }
+            });
+        for (int icurr = 0; icurr < NumElements; ++icurr)
+        {
+            if (values[icurr] != (icurr * 2))
+            {
+                gSystem.LogMessage(eLogMessage_Warning, "ParallelFor test failed at element %d", icurr);
+                testsPassed = false;
+                break;
+            }
+        }
+
+        // dependencies and nested parallel for correctness
+        {
+            const int NumJobs = 256;
+            std::atomic<int> counterValue { 0 };
+            std::atomic<int> nestedSum { 0 };
+            bool dependencyValid = false;
+
+            JobCounter firstStage;
+            JobCounter secondStage;
+            for (int ijob = 0; ijob < NumJobs; ++ijob)
+            {
+                ScheduleJob([this, &counterValue, &nestedSum]()
+                    {
+                        ++counterValue;
+                        ParallelFor(64, 8, [&nestedSum](int beginIndex, int endIndex)
+                            {
+                                nestedSum += (endIndex - beginIndex);
+                            });
+                    }, &firstStage);
+            }
+            ScheduleJob([&counterValue, &dependencyValid]()
+                {
+                    dependencyValid = (counterValue.load() == NumJobs);
+                }, &secondStage, &firstStage);
+
+            WaitForCounter(secondStage);
+
+            if (!dependencyValid || (nestedSum.load() != NumJobs * 64))
+            {
+                gSystem.LogMessage(eLogMessage_Warning, "Dependencies test failed with %d workers", numWorkers);
+                testsPassed = false;
+            }
+        }
+
+        // scaling
+        double startTime = gSystem.GetSystemSeconds();
+        for (int iteration = 0; iteration < NumIterations; ++iteration)
+        {
+            ParallelFor(NumElements, 4096, [&elements, iteration](int beginIndex, int endIndex)
+                {
+                    for (int icurr = beginIndex; icurr < endIndex; ++icurr)
+                    {
+                        float value = (float) (icurr + iteration);
+                        elements[icurr] = sqrtf(value) * sinf(value) + cosf(value * 0.5f);
+                    }
+                });
+        }
+        double elapsedTime = gSystem.GetSystemSeconds() - startTime;
+        if (numWorkers == 0)
+        {
+            baseTime = elapsedTime;
+        }
+        double speedup = (elapsedTime > 0.0) ? (baseTime / elapsedTime) : 0.0;
+        gSystem.LogMessage(eLogMessage_Info, "Threads: %d, time: %.2f ms, speedup: %.2fx", numWorkers + 1, elapsedTime * 1000.0, speedup);
+    }
+
+    // restore workers
+    Deinit();
+    Initialize(initialWorkersCount);
+
+    gSystem.LogMessage(eLogMessage_Info, "JobSystem stress test %s", testsPassed ? "passed" : "failed");
+}
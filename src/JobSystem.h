@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+// forwards
+class JobCounter;
+
+// job procedure
+using JobProc = std::function<void()>;
+
+// parallel for procedure, processes elements in range [beginIndex, endIndex)
+using ParallelForProc = std::function<void(int beginIndex, int endIndex)>;
+
+// scheduled job data, used internally by jobs system
+struct JobSystemJob
+{
+public:
+    JobSystemJob() = default;
+public:
+    JobProc mProc;
+    JobCounter* mCounter = nullptr;
+    // parallel for batch
+    const ParallelForProc* mForProc = nullptr;
+    int mBeginIndex = 0;
+    int mEndIndex = 0;
+};
+
+// tracks completion of a group of scheduled jobs, also used to express dependencies between jobs
+// counter must outlive all jobs it was attached to
+class JobCounter final: public cxx::noncopyable
+{
+    friend class JobSystem;
+
+public:
+    JobCounter() = default;
+
+    // Whether all jobs attached to counter are finished
+    inline bool IsDone() const
+    {
+        return mPendingJobs.load(std::memory_order_acquire) == 0;
+    }
+
+private:
+    std::atomic<int> mPendingJobs { 0 };
+    std::mutex mMutex; // protects continuations list
+    std::vector<JobSystemJob*> mContinuations; // jobs waiting for this counter
+};
+
+// defines jobs system with fixed workers pool and work stealing scheduler
+class JobSystem final: public cxx::noncopyable
+{
+public:
+    // Setup workers pool
+    // @param numWorkers: Number of worker threads, 0 means all jobs are executed on calling thread
+    // @returns false on error
+    bool Initialize(int numWorkers);
+    void Deinit();
+
+    // Get number of running worker threads, main thread is not counted
+    int GetWorkersCount() const;
+
+    // Get index of worker running on calling thread, main thread is 0
+    static int GetCurrentWorkerIndex();
+
+    // Schedule job for execution on workers pool
+    // @param jobProc: Job procedure, cannot be null
+    // @param counter: Optional completion counter, incremented immediately and decremented when job is done
+    // @param dependency: Optional counter, job will not start until all its jobs are done
+    void ScheduleJob(const JobProc& jobProc, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+
+    // Wait until all jobs attached to counter are done, calling thread executes pending jobs while waiting
+    // @param counter: Completion counter
+    void WaitForCounter(JobCounter& counter);
+
+    // Split range of elements into batches and process them in parallel, blocks until all done
+    // Batches layout depends only on elements count and batch size so results are deterministic as long as
+    // procedure writes to disjoint data
+    // @param elementsCount: Number of elements to process
+    // @param batchSize: Minimum number of elements processed by single job
+    // @param forProc: Batch procedure
+    void ParallelFor(int elementsCount, int batchSize, const ParallelForProc& forProc);
+
+    // Run jobs system correctness check and measure scaling from 1 to max workers, results are printed to log
+    void RunStressTest();
+
+private:
+    struct WorkerQueue
+    {
+        std::mutex mMutex;
+        std::deque<JobSystemJob*> mJobs;
+    };
+
+    void WorkerThreadProc(int workerIndex);
+    JobSystemJob* AllocJob();
+    void SubmitJob(JobSystemJob* job, JobCounter* dependency);
+    void EnqueueJob(JobSystemJob* job);
+    void ExecuteJob(JobSystemJob* job);
+    void FinishJob(JobCounter* counter);
+    void FreeJob(JobSystemJob* job);
+
+    // Pop job from own queue or steal from other workers
+    JobSystemJob* TryGetJob(int workerIndex);
+
+private:
+    std::vector<std::thread> mWorkerThreads;
+    std::vector<WorkerQueue*> mWorkerQueues; // queue 0 belongs to main thread
+
+    cxx::object_pool<JobSystemJob> mJobsPool;
+    std::mutex mJobsPoolMutex;
+
+    std::mutex mWakeMutex;
+    std::condition_variable mWakeCondition;
+    std::atomic<int> mQueuedJobsCount { 0 };
+    std::atomic<bool> mShutdownRequested { false };
+};
@@ -1,10 +1,39 @@
 #include "stdafx.h"
 #include "MemoryManager.h"
+#include "JobSystem.h"
 #include "cvars.h"
 
 //////////////////////////////////////////////////////////////////////////
 
 const int SysMemoryFrameHeapSize = 12 * 1024 * 1024;
+const int SysMemoryWorkerFrameHeapSize = 1 * 1024 * 1024;
+
+//////////////////////////////////////////////////////////////////////////
+
+// counts all heap allocations made through operator new, reset each frame
+static std::atomic<int> gHeapAllocationsCounter { 0 };
+
+void* operator new(std::size_t dataLength)
+{
+    gHeapAllocationsCounter.fetch_add(1, std::memory_order_relaxed);
+
+    void* dataPointer = malloc(dataLength ? dataLength : 1);
+    if (dataPointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return dataPointer;
+}
+
+void operator delete(void* dataPointer) noexcept
+{
+    free(dataPointer);
+}
+
+void operator delete(void* dataPointer, std::size_t dataLength) noexcept
+{
+    free(dataPointer);
+}
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -37,6 +66,10 @@ bool MemoryManager::Initialize()
         gSystem.LogMessage(eLogMessage_Info, "Frame heap memory disabled");
     }
 
+    // reserve frame heap slots for all workers that job system might start
+    int maxWorkersCount = std::max((int) std::thread::hardware_concurrency(), gCvarSysWorkerThreads.mValue + 1);
+    mWorkerFrameHeapAllocators.resize(std::max(maxWorkersCount, 1), nullptr);
+
     mHeapAllocator = new cxx::heap_memory_allocator;
     mHeapAllocator->init_allocator(0);
 
@@ -51,14 +84,63 @@ bool MemoryManager::Initialize()
 
 void MemoryManager::Deinit()
 {
+    for (cxx::linear_memory_allocator*& currAllocator: mWorkerFrameHeapAllocators)
+    {
+        SafeDelete(currAllocator);
+    }
+    mWorkerFrameHeapAllocators.clear();
     SafeDelete(mFrameHeapAllocator);
     SafeDelete(mHeapAllocator);
 }
 
 void MemoryManager::FlushFrameHeapMemory()
 {
+    // workers are idle between frames
     if (mFrameHeapAllocator)
     {
         mFrameHeapAllocator->reset();
     }
+
+    for (cxx::linear_memory_allocator* currAllocator: mWorkerFrameHeapAllocators)
+    {
+        if (currAllocator)
+        {
+            currAllocator->reset();
+        }
+    }
+
+    mHeapAllocationsLastFrame = gHeapAllocationsCounter.exchange(0);
+}
+
+int MemoryManager::GetHeapAllocationsCount() const
+{
+    return gHeapAllocationsCounter.load(std::memory_order_relaxed);
+}
+
+cxx::memory_allocator* MemoryManager::GetFrameHeapAllocator()
+{
+    if (mFrameHeapAllocator == nullptr)
+        return mHeapAllocator;
+
+    int workerIndex = JobSystem::GetCurrentWorkerIndex();
+    if (workerIndex == 0)
+        return mFrameHeapAllocator;
+
+    if (workerIndex >= (int) mWorkerFrameHeapAllocators.size())
+        return mHeapAllocator;
+
+    // each worker touches only its own slot
+    cxx::linear_memory_allocator*& workerAllocator = mWorkerFrameHeapAllocators[workerIndex];
+    if (workerAllocator == nullptr)
+    {
+        workerAllocator = new cxx::linear_memory_allocator;
+        if (!workerAllocator->init_allocator(SysMemoryWorkerFrameHeapSize))
+        {
+            gSystem.LogMessage(eLogMessage_Warning, "Fail to allocate worker frame heap memory buffer");
+            SafeDelete(workerAllocator);
+            return mHeapAllocator;
+        }
+        workerAllocator->mOutOfMemoryProc = mFrameHeapAllocator->mOutOfMemoryProc;
+    }
+    return workerAllocator;
 }
\ No newline at end of file
@@ -2,6 +2,10 @@
 
 #include "mem_allocators.h"
 
+// std vector allocated on frame heap
+template<typename TElement>
+using FrameHeapVector = std::vector<TElement, cxx::stl_memory_allocator<TElement>>;
+
 // defines system memory manager class
 class MemoryManager final: public cxx::noncopyable
 {
@@ -10,10 +14,13 @@ public:
 
     // it's intended for objects that only should exist for a short period of time
     // all allocated memory most likely will be invalidated at start of next frame
-    cxx::memory_allocator* mFrameHeapAllocator = nullptr;
+    cxx::linear_memory_allocator* mFrameHeapAllocator = nullptr;
 
     cxx::memory_allocator* mHeapAllocator = nullptr; // standard heap memory allocator
 
+    // heap allocations made during previous frame, including std containers and operator new
+    int mHeapAllocationsLastFrame = 0;
+
 public:
     // setup memory manager internal resources
     // @returns false on error
@@ -23,4 +30,15 @@ public:
 
     // will reset previously allocated frame heap memory
     void FlushFrameHeapMemory();
+
+    // Get frame heap of calling thread, worker threads have their own frame heaps
+    // Falls back to standard heap allocator if frame heap is disabled
+    // Use cxx::memory_allocator_scope to release scratch memory before end of frame
+    cxx::memory_allocator* GetFrameHeapAllocator();
+
+    // Get number of heap allocations made on all threads since start of current frame
+    int GetHeapAllocationsCount() const;
+
+private:
+    std::vector<cxx::linear_memory_allocator*> mWorkerFrameHeapAllocators; // created on first use, main thread uses own heap
 };
\ No newline at end of file
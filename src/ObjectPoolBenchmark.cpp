@@ -0,0 +1,224 @@
+#include "stdafx.h"
+#include "ObjectPoolBenchmark.h"
+
+//////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // previous pool implementation kept as reference: chunks are chained, each chunk has own free list,
+    // so both allocation and deallocation walk chunks chain
+    template<typename TPoolElement, int BlockSize = 1024>
+    class legacy_object_pool_chunk
+    {
+        struct pool_node
+        {
+            typename std::aligned_storage<sizeof(TPoolElement), alignof(TPoolElement)>::type mData;
+            pool_node* mNextFreeNode;
+            pool_node* mPrevFreeNode;
+        };
+
+    public:
+        legacy_object_pool_chunk()
+        {
+            for (int inode = 0; inode < BlockSize; ++inode)
+            {
+                mNodes[inode].mNextFreeNode = (inode < BlockSize - 1) ? &mNodes[inode + 1] : nullptr;
+                mNodes[inode].mPrevFreeNode = (inode > 0) ? &mNodes[inode - 1] : nullptr;
+            }
+            mFreeNodesHead = mNodes;
+        }
+        ~legacy_object_pool_chunk()
+        {
+            delete mNextChunk;
+        }
+        TPoolElement* allocate_object()
+        {
+            if (mFreeNodesHead == nullptr)
+            {
+                if (mNextChunk == nullptr)
+                {
+                    mNextChunk = new legacy_object_pool_chunk;
+                }
+                return mNextChunk->allocate_object();
+            }
+
+            pool_node* node = mFreeNodesHead;
+            if (node->mNextFreeNode)
+                node->mNextFreeNode->mPrevFreeNode = nullptr;
+
+            mFreeNodesHead = node->mNextFreeNode;
+            node->mNextFreeNode = nullptr;
+            node->mPrevFreeNode = nullptr;
+            return new (&node->mData) TPoolElement;
+        }
+        void deallocate_object(TPoolElement* element)
+        {
+            pool_node* node = reinterpret_cast<pool_node*>(element);
+            if (node >= mNodes && node < mNodes + BlockSize)
+            {
+                element->~TPoolElement();
+                node->mNextFreeNode = mFreeNodesHead;
+                if (mFreeNodesHead)
+                {
+                    mFreeNodesHead->mPrevFreeNode = node;
+                }
+                mFreeNodesHead = node;
+                return;
+            }
+            cxx_assert(mNextChunk);
+            mNextChunk->deallocate_object(element);
+        }
+    private:
+        legacy_object_pool_chunk* mNextChunk = nullptr;
+        pool_node* mFreeNodesHead = nullptr;
+        pool_node mNodes[BlockSize];
+    };
+
+    // object of typical game object size
+    struct BenchmarkObject
+    {
+    public:
+        float mValues[24];
+        int mCounter = 0;
+    };
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+
+void RunObjectPoolBenchmark(int numObjects)
+{
+    gSystem.LogMessage(eLogMessage_Info, "Object pool benchmark started (%d objects)", numObjects);
+
+    const int NumIterations = 10;
+
+    // same random order of destruction for both pools
+    std::vector<int> destroyOrder(numObjects);
+    for (int iobject = 0; iobject < numObjects; ++iobject)
+    {
+        destroyOrder[iobject] = iobject;
+    }
+    std::mt19937 randomEngine(numObjects);
+    std::shuffle(destroyOrder.begin(), destroyOrder.end(), randomEngine);
+
+    const int numChurnObjects = numObjects / 2;
+
+    std::vector<BenchmarkObject*> objects(numObjects);
+
+    // legacy pool
+    double legacyTime = 0.0;
+    double legacyIterateTime = 0.0;
+    int legacyChecksum = 0;
+    {
+        legacy_object_pool_chunk<BenchmarkObject> legacyPool;
+
+        double startTime = gSystem.GetSystemSeconds();
+        for (int iteration = 0; iteration < NumIterations; ++iteration)
+        {
+            for (int iobject = 0; iobject < numObjects; ++iobject)
+            {
+                objects[iobject] = legacyPool.allocate_object();
+            }
+            // free random half and allocate it again
+            for (int ichurn = 0; ichurn < numChurnObjects; ++ichurn)
+            {
+                legacyPool.deallocate_object(objects[destroyOrder[ichurn]]);
+            }
+            for (int ichurn = 0; ichurn < numChurnObjects; ++ichurn)
+            {
+                objects[destroyOrder[ichurn]] = legacyPool.allocate_object();
+            }
+            if (iteration == NumIterations - 1)
+                break; // keep objects for iteration test
+
+            for (int iobject = 0; iobject < numObjects; ++iobject)
+            {
+                legacyPool.deallocate_object(objects[destroyOrder[iobject]]);
+            }
+        }
+        legacyTime = gSystem.GetSystemSeconds() - startTime;
+
+        // objects are iterated through separate pointers list
+        startTime = gSystem.GetSystemSeconds();
+        for (int iteration = 0; iteration < NumIterations; ++iteration)
+        {
+            for (BenchmarkObject* currObject: objects)
+            {
+                currObject->mCounter += iteration;
+                legacyChecksum += currObject->mCounter;
+            }
+        }
+        legacyIterateTime = gSystem.GetSystemSeconds() - startTime;
+
+        for (int iobject = 0; iobject < numObjects; ++iobject)
+        {
+            legacyPool.deallocate_object(objects[iobject]);
+        }
+    }
+
+    // current pool
+    double currentTime = 0.0;
+    double currentIterateTime = 0.0;
+    int currentChecksum = 0;
+    {
+        cxx::object_pool<BenchmarkObject> currentPool;
+
+        double startTime = gSystem.GetSystemSeconds();
+        for (int iteration = 0; iteration < NumIterations; ++iteration)
+        {
+            for (int iobject = 0; iobject < numObjects; ++iobject)
+            {
+                objects[iobject] = currentPool.create();
+            }
+            // free random half and allocate it again
+            for (int ichurn = 0; ichurn < numChurnObjects; ++ichurn)
+            {
+                currentPool.destroy(objects[destroyOrder[ichurn]]);
+            }
+            for (int ichurn = 0; ichurn < numChurnObjects; ++ichurn)
+            {
+                objects[destroyOrder[ichurn]] = currentPool.create();
+            }
+            if (iteration == NumIterations - 1)
+                break; // keep objects for iteration test
+
+            for (int iobject = 0; iobject < numObjects; ++iobject)
+            {
+                currentPool.destroy(objects[destroyOrder[iobject]]);
+            }
+        }
+        currentTime = gSystem.GetSystemSeconds() - startTime;
+
+        // objects are iterated directly in pool
+        startTime = gSystem.GetSystemSeconds();
+        for (int iteration = 0; iteration < NumIterations; ++iteration)
+        {
+            currentPool.for_each([iteration, &currentChecksum](BenchmarkObject* currObject)
+            {
+                currObject->mCounter += iteration;
+                currentChecksum += currObject->mCounter;
+            });
+        }
+        currentIterateTime = gSystem.GetSystemSeconds() - startTime;
+
+        if (currentPool.get_objects_count() != numObjects)
+        {
+            gSystem.LogMessage(eLogMessage_Warning, "Object pool live objects count mismatch: %d", currentPool.get_objects_count());
+        }
+        gSystem.LogMessage(eLogMessage_Info, "Object pool chunks: %d", currentPool.get_chunks_count());
+
+        for (int iobject = 0; iobject < numObjects; ++iobject)
+        {
+            currentPool.destroy(objects[iobject]);
+        }
+    }
+
+    if (legacyChecksum != currentChecksum)
+    {
+        gSystem.LogMessage(eLogMessage_Warning, "Object pool iteration checksum mismatch");
+    }
+
+    gSystem.LogMessage(eLogMessage_Info, "Legacy pool alloc/free: %.2f ms, iterate pointers: %.2f ms", legacyTime * 1000.0, legacyIterateTime * 1000.0);
+    gSystem.LogMessage(eLogMessage_Info, "Current pool alloc/free: %.2f ms, iterate for_each: %.2f ms", currentTime * 1000.0, currentIterateTime * 1000.0);
+    gSystem.LogMessage(eLogMessage_Info, "Alloc/free speedup: %.2fx", (currentTime > 0.0) ? (legacyTime / currentTime) : 0.0);
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// Compare cxx::object_pool with previous chunk chain implementation and print results to log
+// @param numObjects: Number of objects allocated in pool
+void RunObjectPoolBenchmark(int numObjects);
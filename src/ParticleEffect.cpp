@@ -3,6 +3,9 @@
 #include "GtaOneGame.h"
 #include "ParticleRenderdata.h"
 
+// number of particles updated by single job
+const int ParticlesUpdateBatchSize = 256;
+
 ParticleEffect::~ParticleEffect()
 {
     cxx_assert(mRenderdata == nullptr);
@@ -309,16 +312,29 @@ void ParticleEffect::GenerateNewParticles()
 
 void ParticleEffect::UpdateAliveParticles(float deltaTime)
 {
+    // update particles in parallel, each batch touches only its own range
+    gSystem.mJobs.ParallelFor(mAliveParticlesCount, ParticlesUpdateBatchSize, [this, deltaTime](int beginIndex, int endIndex)
+    {
+        for (int icurr = beginIndex; icurr < endIndex; ++icurr)
+        {
+            Particle& currParticle = mParticles[icurr];
+            if (!UpdateParticle(currParticle, deltaTime))
+            {
+                currParticle.mState = eParticleState_Dead;
+            }
+        }
+    });
+
+    // remove dead particles
     for (int icurr = 0; icurr < mAliveParticlesCount; )
     {
         Particle& currParticle = mParticles[icurr];
-        if (UpdateParticle(currParticle, deltaTime))
+        if (currParticle.mState != eParticleState_Dead)
         {
             ++icurr;
             continue;
         }
 
-        currParticle.mState = eParticleState_Dead;
         // kill particle
         if (icurr < (mAliveParticlesCount - 1))
         {
@@ -77,11 +77,6 @@ void Pedestrian::HandleDespawn()
     GameObject::HandleDespawn();
 }
 
-bool Pedestrian::ShouldCollide(GameObject* otherObject) const
-{
-    return false;
-}
-
 void Pedestrian::HandleFallingStarts()
 {
     cxx_assert(mPhysicsBody);
@@ -173,7 +168,7 @@ void Pedestrian::SimulationStep()
     float maxCarSpeed = 0.0f;
 
     // inspect current contacts
-    for (const Contact& currContact: mObjectsContacts)
+    for (const Contact& currContact: GetContacts())
     {
         if (Pedestrian* otherPedestrian = ToPedestrian(currContact.mThatObject))
         {
@@ -287,7 +282,7 @@ void Pedestrian::UpdateLocomotion()
         if (!isSlideOverCar)
         {
             // prevent walking through cars
-            for (const Contact& currContact: mObjectsContacts)
+            for (const Contact& currContact: GetContacts())
             {
                 if (!currContact.mThatObject->IsVehicleClass())
                     continue;
@@ -16,6 +16,7 @@ class Pedestrian final: public GameObject, public SpriteAnimListener
     friend class PedestrianPhysics;
     friend class PedestrianStatesManager;
     friend class GameCheatsWindow;
+    friend class PhysicsManager;
 
 public:
     // public for convenience, should not be modified directly
@@ -49,7 +50,6 @@ public:
     void DebugDraw(DebugRenderer& debugRender) override;
     void HandleSpawn() override;
     void HandleDespawn() override;
-    bool ShouldCollide(GameObject* otherObject) const override;
     void HandleFallingStarts() override;
     void HandleFallsOnGround(float fallDistance) override;
     void HandleFallsOnWater(float fallDistance) override;
@@ -97,7 +97,7 @@ void PhysicsBody::SetupFlags(PhysicsBodyFlags flags)
     }
 
     bool isDisabled = CheckFlags(PhysicsBodyFlags_Disabled);
-    mBox2Body->SetEnabled(!isDisabled);
+    mBox2Body->SetEnabled(!isDisabled && !mSimplifiedSimulation);
 
     bool isHovering = CheckFlags(PhysicsBodyFlags_NoGravity);
 
@@ -113,6 +113,18 @@ void PhysicsBody::SetupFlags(PhysicsBodyFlags flags)
     mBox2Body->SetBullet(isBullet);
 }
 
+void PhysicsBody::SetSimplifiedSimulation(bool isSimplified)
+{
+    cxx_assert(!gGame.mPhysicsMng.IsSimulationStepInProgress());
+    if (mSimplifiedSimulation == isSimplified)
+        return;
+
+    mSimplifiedSimulation = isSimplified;
+
+    bool isDisabled = CheckFlags(PhysicsBodyFlags_Disabled);
+    mBox2Body->SetEnabled(!isDisabled && !mSimplifiedSimulation);
+}
+
 void PhysicsBody::ChangeFlags(PhysicsBodyFlags enableFlags, PhysicsBodyFlags disableFlags)
 {
     PhysicsBodyFlags newFlags = (mBodyFlags | enableFlags) & ~disableFlags;
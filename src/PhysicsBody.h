@@ -23,6 +23,8 @@ public:
     bool mFalling = false; // falling from a height
     float mFallStartHeight = 0.0f; // specified if mFalling is set
 
+    bool mSimplifiedSimulation = false; // body is far from camera, box2d simulation is off and it moves kinematically
+
 public:
     PhysicsBody(GameObject* owner, PhysicsBodyFlags flags);
     ~PhysicsBody();
@@ -105,7 +107,15 @@ public:
     void SetAwake(bool isAwake);
     bool IsAwake() const;
 
+private:
+    // Switch body between box2d and kinematic simulation, used by physics manager
+    void SetSimplifiedSimulation(bool isSimplified);
+
 private:
     PhysicsBodyFlags mBodyFlags = PhysicsBodyFlags_None;
     b2Body* mBox2Body = nullptr;
+
+    // contacts range in physics manager contacts arenas, current and previous step
+    int mContactsStart[2] = {};
+    int mContactsCount[2] = {};
 };
@@ -1,12 +1,14 @@
 #pragma once
 
+#include "GameDefs.h"
+
 // forwards
 class PhysicsBody;
 class Collider;
 class Collision;
+class GameObject;
 
 // constants
-const int MaxPhysicsQueryElements = 32;
 const int MaxCollisionContactPoints = 2;
 
 enum PhysicsBodyFlags
@@ -139,21 +141,32 @@ public:
     // these valid for linecast only:
     glm::vec2 mNormal;
     glm::vec2 mIntersectionPoint;
+    float mFraction = 0.0f; // distance from line start in fractions of line length
 };
 
-// physical components query result
-struct PhysicsQueryResult
+// physical components query filter, applied while collecting elements
+struct PhysicsQueryFilter
 {
 public:
-    PhysicsQueryResult() = default;
-    inline void Clear() { mElementsCount = 0; }
-    inline bool IsNull() const { return mElementsCount == 0; }
-    inline bool IsFull() const { return mElementsCount == MaxPhysicsQueryElements; }
+    PhysicsQueryFilter() = default;
+    PhysicsQueryFilter(CollisionGroup collisionMask, eGameObjectClass objectClass = eGameObjectClass_COUNT, GameObject* ignoreObject = nullptr)
+        : mCollisionMask(collisionMask)
+        , mObjectClass(objectClass)
+        , mIgnoreObject(ignoreObject)
+    {
+    }
 public:
-    int mElementsCount = 0;
-    PhysicsQueryElement mElements[MaxPhysicsQueryElements];
+    CollisionGroup mCollisionMask = CollisionGroup_None;
+    eGameObjectClass mObjectClass = eGameObjectClass_COUNT; // any class if count
+    GameObject* mIgnoreObject = nullptr;
 };
 
+// receives physical components query elements one by one, returns false to stop query
+using PhysicsQueryProc = std::function<bool(const PhysicsQueryElement& queryElement)>;
+
+// physical components query result, each body is listed once
+using PhysicsQueryResult = FrameHeapVector<PhysicsQueryElement>;
+
 // collision contact point info
 struct ContactPoint
 {
@@ -9,11 +9,25 @@
 #include "PhysicsBody.h"
 #include "Collision.h"
 #include "GameObjectHelpers.h"
+#include "Vehicle.h"
+#include "Projectile.h"
+
+//////////////////////////////////////////////////////////////////////////
+
+CvarBoolean gCvarPhysicsBatchedCars("g_physicsBatchedCars", true, "Compute car tire forces for all cars at once", CvarFlags_Archive);
+CvarBoolean gCvarPhysicsBatchedPeds("g_physicsBatchedPeds", true, "Compute idle pedestrians locomotion for all pedestrians at once", CvarFlags_Archive);
 
 //////////////////////////////////////////////////////////////////////////
 
 static cxx::object_pool<PhysicsBody> gPhysicsBodiesPool;
 
+const int VehiclesDynamicsBatchSize = 64;
+const int PedestriansLocomotionBatchSize = 256;
+const int ProjectileRaysBatchSize = 64;
+
+// max height difference between projectile and object it can hit, meters
+const float ProjectileHitMaxHeight = 2.0f;
+
 //////////////////////////////////////////////////////////////////////////
 
 union b2FixtureData_map
@@ -41,6 +55,27 @@ inline bool CheckCollisionGroup(const b2Fixture* fixture, CollisionGroup collisi
     return (filterData.categoryBits & collisionGroup) > 0;
 }
 
+// same as b2Body::ApplyLinearImpulse, arm is offset of impulse point from center of mass
+inline void ApplyImpulseToVelocity(float invMass, float invInertia, float armX, float armY, float impulseX, float impulseY,
+    float& velocityX, float& velocityY, float& angularVelocity)
+{
+    velocityX += invMass * impulseX;
+    velocityY += invMass * impulseY;
+    angularVelocity += invInertia * (armX * impulseY - armY * impulseX);
+}
+
+// kill lateral velocity of tire, same as in Vehicle::UpdateFriction
+inline void KillTireLateralVelocity(float mass, float invMass, float invInertia, float armX, float armY, float lateralX, float lateralY,
+    float& velocityX, float& velocityY, float& angularVelocity)
+{
+    const float lateralKillCoef = 0.20f;
+
+    float pointVelocityX = velocityX - angularVelocity * armY;
+    float pointVelocityY = velocityY + angularVelocity * armX;
+    float impulse = -mass * lateralKillCoef * (lateralX * pointVelocityX + lateralY * pointVelocityY);
+    ApplyImpulseToVelocity(invMass, invInertia, armX, armY, impulse * lateralX, impulse * lateralY, velocityX, velocityY, angularVelocity);
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 PhysicsManager::PhysicsManager()
@@ -48,6 +83,54 @@ PhysicsManager::PhysicsManager()
     , mBox2World()
     , mGravity()
 {
+    InitObjectsCollisionTable();
+}
+
+void PhysicsManager::InitObjectsCollisionTable()
+{
+    // whether object of specific class gets collision response from other object
+    auto class_collides_with = [](eGameObjectClass objectClass, eGameObjectClass otherClass)
+    {
+        if (objectClass == eGameObjectClass_Pedestrian)
+            return false;
+
+        if (objectClass == eGameObjectClass_Car)
+            return (otherClass == eGameObjectClass_Car) || (otherClass == eGameObjectClass_Obstacle);
+
+        return true;
+    };
+
+    for (int iclassA = 0; iclassA < eGameObjectClass_COUNT; ++iclassA)
+    {
+        for (int iclassB = 0; iclassB < eGameObjectClass_COUNT; ++iclassB)
+        {
+            eGameObjectClass classA = (eGameObjectClass) iclassA;
+            eGameObjectClass classB = (eGameObjectClass) iclassB;
+            eObjectsCollision classesCollision = eObjectsCollision_Contact;
+            if (class_collides_with(classA, classB) && class_collides_with(classB, classA))
+            {
+                classesCollision = eObjectsCollision_Response;
+            }
+
+            for (int istateA = 0; istateA < ObjectCollisionStatesCount; ++istateA)
+            {
+                for (int istateB = 0; istateB < ObjectCollisionStatesCount; ++istateB)
+                {
+                    // ai pedestrians avoid each other without contacts
+                    bool crowdAgents = (istateA == ObjectCollisionState_CrowdAgent) && (istateB == ObjectCollisionState_CrowdAgent);
+                    mObjectsCollisionTable[iclassA][istateA][iclassB][istateB] = crowdAgents ? eObjectsCollision_None : classesCollision;
+                }
+            }
+        }
+    }
+}
+
+int PhysicsManager::GetObjectCollisionState(GameObject* gameObject) const
+{
+    if (gGame.mCrowdAvoidance.IsCrowdAgent(gameObject))
+        return ObjectCollisionState_CrowdAgent;
+
+    return ObjectCollisionState_Regular;
 }
 
 void PhysicsManager::EnterWorld()
@@ -70,12 +153,24 @@ void PhysicsManager::ClearWorld()
         mBox2MapBody = nullptr;
     }
     SafeDelete(mBox2World);
+
+    mPendingContacts.clear();
+    mContactsArenas[0].clear();
+    mContactsArenas[1].clear();
+
+    for (ProjectileRay& currRay: mProjectileRays)
+    {
+        currRay.mProjectile->mProjectileRayIndex = -1;
+    }
+    mProjectileRays.clear();
 }
 
 void PhysicsManager::UpdateFrame()
 {
     mSimulationTimeAccumulator += gGame.mTimeMng.mGameFrameDelta;
 
+    UpdateSimulationLod();
+
     while (mSimulationTimeAccumulator >= mSimulationStepTime)
     {
         ProcessSimulationStep();
@@ -94,23 +189,50 @@ void PhysicsManager::ProcessSimulationStep()
     for (size_t i = 0, NumElements = mBodiesList.size(); i < NumElements; ++i)
     {
         PhysicsBody* currObjectBody = mBodiesList[i];
-        if (!currObjectBody->CheckFlags(PhysicsBodyFlags_Disabled))
+        if (currObjectBody->CheckFlags(PhysicsBodyFlags_Disabled))
+            continue;
+
+        GameObject* currGameObject = currObjectBody->mGameObject;
+        if (currObjectBody->mSimplifiedSimulation)
+        {
+            currGameObject->SimulationStepSimplified();
+        }
+        else if (gCvarPhysicsBatchedCars.mValue && currGameObject->IsVehicleClass())
+        {
+            GatherVehicleDynamics(static_cast<Vehicle*>(currGameObject));
+        }
+        else if (gCvarPhysicsBatchedPeds.mValue && currGameObject->IsPedestrianClass() && 
+            CanUseBatchedLocomotion(static_cast<Pedestrian*>(currGameObject)))
+        {
+            GatherPedestrianLocomotion(static_cast<Pedestrian*>(currGameObject));
+        }
+        else
         {
-            GameObject* currGameObject = currObjectBody->mGameObject;
             currGameObject->SimulationStep();
         }
     }
 
-    // drop old contacts before new simulation frame
+    ProcessVehiclesDynamics();
+    ProcessPedestriansLocomotion();
+
     for (PhysicsBody* currObjectBody: mBodiesList)
     {
-        GameObject* currGameObject = currObjectBody->mGameObject;
         currObjectBody->SetAwake(true); // force contacting bodies awaken
-        currGameObject->ClearContacts();
     }
 
     mBox2World->Step(mSimulationStepTime, velocityIterations, positionIterations);
 
+    BuildContactsArena();
+
+    // move distant bodies, they are not present in box2d world
+    for (PhysicsBody* currObjectBody: mBodiesList)
+    {
+        if (currObjectBody->mSimplifiedSimulation)
+        {
+            IntegrateSimplifiedBody(currObjectBody);
+        }
+    }
+
     // process y position
     for (PhysicsBody* currObjectBody: mBodiesList)
     {
@@ -122,6 +244,7 @@ void PhysicsManager::ProcessSimulationStep()
     }
 
     DispatchCollisionEvents();
+    DispatchContactEvents();
 
     // sync transform
     for (PhysicsBody* currObjectBody: mBodiesList)
@@ -132,6 +255,8 @@ void PhysicsManager::ProcessSimulationStep()
             currGameObject->SyncPhysicsTransform();
         }
     }
+
+    ProcessProjectiles();
 }
 
 PhysicsBody* PhysicsManager::CreateBody(GameObject* gameObject, PhysicsBodyFlags flags)
@@ -235,6 +360,7 @@ void PhysicsManager::CreateMapCollisionShape()
 void PhysicsManager::DestroyBody(PhysicsBody* physicsBody)
 {
     cxx_assert(!IsSimulationStepInProgress());
+    cxx_assert(!mContactEventsDispatchInProgress);
 
     cxx_assert(physicsBody);
     if (physicsBody == nullptr)
@@ -245,12 +371,20 @@ void PhysicsManager::DestroyBody(PhysicsBody* physicsBody)
     if (gameObject)
     {
         cxx::erase_elements(mBodiesList, physicsBody);
-        // remove contacts
-        for (const Contact& currContact: gameObject->mObjectsContacts)
+        // remove contacts from other objects in both arenas
+        for (int iarena = 0; iarena < 2; ++iarena)
         {
-            currContact.mThatObject->UnregisterContactsWithObject(gameObject);
+            const Contact* contacts = mContactsArenas[iarena].data() + physicsBody->mContactsStart[iarena];
+            for (int icontact = 0; icontact < physicsBody->mContactsCount[iarena]; ++icontact)
+            {
+                PhysicsBody* otherBody = contacts[icontact].mThatObject->mPhysicsBody;
+                if (otherBody)
+                {
+                    RemoveContactsWithObject(iarena, otherBody, gameObject);
+                }
+            }
+            physicsBody->mContactsCount[iarena] = 0;
         }
-        gameObject->ClearContacts();
     }
 
     gPhysicsBodiesPool.destroy(physicsBody);
@@ -303,22 +437,19 @@ void PhysicsManager::PostSolve(b2Contact* contact, const b2ContactImpulse* impul
     if (CheckCollisionGroup(fixtureA, CollisionGroup_MapBlock | CollisionGroup_Wall))
     {
         // assume fixtureB is game object collider
-        HandleCollision_ObjectWithMap(fixtureB, fixtureA, contact, impulse);
+        QueueCollisionEvent(fixtureB, fixtureA, true, contact, impulse);
         return;
     }
 
     if (CheckCollisionGroup(fixtureB, CollisionGroup_MapBlock | CollisionGroup_Wall))
     {
         // assume fixtureA is game object collider
-        HandleCollision_ObjectWithMap(fixtureA, fixtureB, contact, impulse);
+        QueueCollisionEvent(fixtureA, fixtureB, true, contact, impulse);
         return;
     }
 
     // object vs object
-    {
-        HandleCollision_Objects(fixtureA, fixtureB, contact, impulse);
-        return;
-    }
+    QueueCollisionEvent(fixtureA, fixtureB, false, contact, impulse);
 }
 
 void PhysicsManager::UpdateHeightPosition(PhysicsBody* physicsBody)
@@ -381,335 +512,1426 @@ void PhysicsManager::UpdateHeightPosition(PhysicsBody* physicsBody)
     }
 }
 
-void PhysicsManager::QueryObjectsLinecast(const glm::vec2& pointA, const glm::vec2& pointB, PhysicsQueryResult& outputResult, CollisionGroup collisionMask) const
+void PhysicsManager::UpdateSimulationLod()
 {
-    outputResult.Clear();
-
-    collisionMask = collisionMask & ~(CollisionGroup_MapBlock | CollisionGroup_Wall); // ignore map
-    if (collisionMask == CollisionGroup_None)
-        return;
-
-    struct _raycast_callback: public b2RayCastCallback
+    const float lodDistance = gGame.mParams.mPhysicsLodDistance;
+    if (lodDistance <= 0.0f)
     {
-    public:
-        _raycast_callback(PhysicsQueryResult& out, CollisionGroup collisionMask)
-            : mOutput(out)
-            , mCollisionMask(collisionMask)
-        {
-        }
-	    float ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float fraction) override
+        // simplified simulation is disabled, bring all bodies back
+        for (PhysicsBody* currObjectBody: mBodiesList)
         {
-            if (mOutput.IsFull())
-                return 0.0f;
-
-            const b2Filter& filterData = fixture->GetFilterData();
-            if ((filterData.categoryBits & mCollisionMask) > 0)
-            {
-                PhysicsQueryElement& currHit = mOutput.mElements[mOutput.mElementsCount];
-                currHit.mPhysicsObject = b2Fixture_get_physics_body(fixture);
-                if (currHit.mPhysicsObject)
-                {
-                    ++mOutput.mElementsCount;
-
-                    currHit.mIntersectionPoint = convert_vec2(point);
-                    currHit.mNormal = convert_vec2(point);
-                }
-            }
-            return 1.0f;
+            currObjectBody->SetSimplifiedSimulation(false);
         }
-    public:
-        PhysicsQueryResult& mOutput;
-        CollisionGroup mCollisionMask;
-    };
-
-    _raycast_callback raycast_callback {outputResult, collisionMask};
-    b2Vec2 p1 = convert_vec2(pointA);
-    b2Vec2 p2 = convert_vec2(pointB);
-    mBox2World->RayCast(&raycast_callback, p1, p2);
-}
+        return;
+    }
 
-void PhysicsManager::QueryObjectsWithinBox(const glm::vec2& center, const glm::vec2& extents, PhysicsQueryResult& outputResult, CollisionGroup collisionMask) const
-{
-    outputResult.Clear();
+    // bodies inside inner area always uses full simulation, outside of outer area - simplified
+    // bodies in between keeps current mode
+    cxx::aabbox2d_t innerArea = gGame.mCamera.mOnScreenMapArea;
+    innerArea.mMin -= glm::vec2(lodDistance);
+    innerArea.mMax += glm::vec2(lodDistance);
 
-    collisionMask = collisionMask & ~(CollisionGroup_MapBlock | CollisionGroup_Wall); // ignore map
-    if (collisionMask == CollisionGroup_None)
-        return;
+    cxx::aabbox2d_t outerArea = innerArea;
+    outerArea.mMin -= glm::vec2(gGame.mParams.mPhysicsLodHysteresis);
+    outerArea.mMax += glm::vec2(gGame.mParams.mPhysicsLodHysteresis);
 
-    struct _query_callback: public b2QueryCallback
+    for (PhysicsBody* currObjectBody: mBodiesList)
     {
-    public:
-        _query_callback(PhysicsQueryResult& out, CollisionGroup collisionMask)
-            : mOutput(out)
-            , mCollisionMask(collisionMask)
+        if (!CanUseSimplifiedSimulation(currObjectBody))
+        {
+            currObjectBody->SetSimplifiedSimulation(false);
+            continue;
+        }
+
+        glm::vec2 position = currObjectBody->GetPosition2();
+        if (currObjectBody->mSimplifiedSimulation)
         {
+            if (innerArea.contains(position))
+            {
+                currObjectBody->SetSimplifiedSimulation(false);
+            }
         }
-        bool ReportFixture(b2Fixture* fixture) override
+        else
         {
-            if (mOutput.IsFull())
-                return false;
-
-            const b2Filter& filterData = fixture->GetFilterData();
-            if ((filterData.categoryBits & mCollisionMask) > 0)
+            if (!outerArea.contains(position))
             {
-                PhysicsQueryElement& currHit = mOutput.mElements[mOutput.mElementsCount];
-                currHit.mPhysicsObject = b2Fixture_get_physics_body(fixture);
-                if (currHit.mPhysicsObject)
-                {
-                    ++mOutput.mElementsCount;
-                }
+                currObjectBody->SetSimplifiedSimulation(true);
             }
-            return true;
         }
-    public:
-        PhysicsQueryResult& mOutput;
-        CollisionGroup mCollisionMask;
-    };
-    _query_callback query_callback {outputResult, collisionMask};
-
-    b2AABB aabb;
-    aabb.lowerBound.x = (center.x - extents.x);
-    aabb.lowerBound.y = (center.y - extents.y);
-    aabb.upperBound.x = (center.x + extents.x);
-    aabb.upperBound.y = (center.y + extents.y);
-    mBox2World->QueryAABB(&query_callback, aabb);
-}
-
-bool PhysicsManager::IsSimulationStepInProgress() const
-{
-    return mBox2World->IsLocked();
+    }
 }
 
-bool PhysicsManager::ShouldCollide_ObjectWithMap(b2Contact* contact, b2Fixture* objectFixture, b2Fixture* mapFixture) const
+bool PhysicsManager::CanUseSimplifiedSimulation(PhysicsBody* physicsBody) const
 {
-    GameObject* gameObject = b2Fixture_get_game_object(objectFixture);
-
-    cxx_assert(gameObject);
-    cxx_assert(!gameObject->IsAttachedToObject());
+    if (physicsBody->CheckFlags(PhysicsBodyFlags_Static | PhysicsBodyFlags_Linked | PhysicsBodyFlags_Disabled))
+        return false;
 
-    if (gameObject->IsMarkedForDeletion())
+    if (physicsBody->mWaterContact)
         return false;
 
-    cxx_assert(gameObject->mPhysicsBody);
-    if (gameObject->mPhysicsBody->CheckFlags(PhysicsBodyFlags_Disabled))
+    GameObject* gameObject = physicsBody->mGameObject;
+    if (gameObject->IsAttachedToObject() || gameObject->IsMarkedForDeletion())
         return false;
 
-    float height = gGame.mMap.GetHeightAtPosition(gameObject->mPhysicsBody->GetPosition());
-    int mapLayer = (int) (Convert::MetersToMapUnits(height) + 0.5f);
+    if (Pedestrian* pedestrian = ToPedestrian(gameObject))
+    {
+        return !pedestrian->IsPlayerCharacter();
+    }
 
-    // todo: this is temporary implementation
+    if (Vehicle* vehicle = ToVehicle(gameObject))
+    {
+        Pedestrian* carDriver = vehicle->GetCarDriver();
+        return (carDriver == nullptr) || !carDriver->IsPlayerCharacter();
+    }
 
-    b2FixtureData_map fxdata = (b2FixtureData_map*) mapFixture->GetUserData().pointer;
-    const MapBlockInfo* blockData = gGame.mMap.GetBlockInfo(fxdata.mX, fxdata.mZ, mapLayer);
-    return (blockData->mGroundType == eGroundType_Building);
+    // projectiles, obstacles and other stuff always uses full simulation
+    return false;
 }
 
-bool PhysicsManager::ShouldCollide_Objects(b2Contact* box2contact, b2Fixture* fixtureA, b2Fixture* fixtureB) const
+void PhysicsManager::IntegrateSimplifiedBody(PhysicsBody* physicsBody)
 {
-    GameObject* gameObjectA = b2Fixture_get_game_object(fixtureA);
-    GameObject* gameObjectB = b2Fixture_get_game_object(fixtureB);
+    b2Body* box2body = physicsBody->mBox2Body;
 
-    cxx_assert(gameObjectA);
-    cxx_assert(gameObjectB);
-    cxx_assert(gameObjectA != gameObjectB);
-
-    if (gameObjectA->IsMarkedForDeletion() || gameObjectB->IsMarkedForDeletion())
-        return false;
+    b2Vec2 linearVelocity = box2body->GetLinearVelocity();
+    float angularVelocity = box2body->GetAngularVelocity();
+    if (linearVelocity.LengthSquared() == 0.0f && angularVelocity == 0.0f)
+        return;
 
-    cxx_assert(gameObjectA->mPhysicsBody);
-    cxx_assert(gameObjectB->mPhysicsBody);
+    b2Vec2 position = box2body->GetPosition() + mSimulationStepTime * linearVelocity;
+    float angle = box2body->GetAngle() + mSimulationStepTime * angularVelocity;
 
-    if (gameObjectA->mPhysicsBody->CheckFlags(PhysicsBodyFlags_Disabled))
-        return false;
+    // there is no contacts with map blocks, so just stop before solid block
+    glm::vec2 mapPosition = Convert::MetersToMapUnits(convert_vec2(position));
+    int mapLayer = (int) (Convert::MetersToMapUnits(physicsBody->mPositionY) + 0.5f);
 
-    if (gameObjectB->mPhysicsBody->CheckFlags(PhysicsBodyFlags_Disabled))
-        return false;
+    const MapBlockInfo* blockData = gGame.mMap.GetBlockInfo((int) mapPosition.x, (int) mapPosition.y, mapLayer);
+    if (blockData->mGroundType == eGroundType_Building)
+    {
+        box2body->SetLinearVelocity(b2Vec2_zero);
+        position = box2body->GetPosition();
+    }
+    box2body->SetTransform(position, angle);
+}
 
-    // todo: check y positions!
-    float objectA_posY = gameObjectA->mPhysicsBody->mPositionY;
-    float objectB_posY = gameObjectB->mPhysicsBody->mPositionY;
+void PhysicsManager::GatherVehicleDynamics(Vehicle* vehicle)
+{
+    b2Body* box2body = vehicle->mPhysicsBody->mBox2Body;
+
+    Vehicle::DriveCtlState currCtlState;
+    vehicle->GetDriveCtlState(currCtlState);
+
+    VehiclesDynamicsBatch& batch = mVehiclesDynamics;
+
+    int elementIndex = batch.GetElementsCount();
+    batch.Resize(elementIndex + 1);
+    batch.mVehicles[elementIndex] = vehicle;
+
+    const b2Transform& transform = box2body->GetTransform();
+    const b2Vec2& centerOfMass = box2body->GetWorldCenter();
+    const b2Vec2& localCenter = box2body->GetLocalCenter();
+    const b2Vec2& linearVelocity = box2body->GetLinearVelocity();
+
+    float mass = box2body->GetMass();
+    float inertia = box2body->GetInertia() - mass * b2Dot(localCenter, localCenter); // about center of mass
+    batch.mMass[elementIndex] = mass;
+    batch.mInvMass[elementIndex] = (mass > 0.0f) ? (1.0f / mass) : 0.0f;
+    batch.mInvInertia[elementIndex] = (inertia > 0.0f) ? (1.0f / inertia) : 0.0f;
+    batch.mPositionX[elementIndex] = transform.p.x;
+    batch.mPositionY[elementIndex] = transform.p.y;
+    batch.mCenterX[elementIndex] = centerOfMass.x;
+    batch.mCenterY[elementIndex] = centerOfMass.y;
+    batch.mCos[elementIndex] = transform.q.c;
+    batch.mSin[elementIndex] = transform.q.s;
+    batch.mVelocityX[elementIndex] = linearVelocity.x;
+    batch.mVelocityY[elementIndex] = linearVelocity.y;
+    batch.mAngularVelocity[elementIndex] = box2body->GetAngularVelocity();
+    batch.mFrontTireOffset[elementIndex] = vehicle->mFrontTireOffset;
+    batch.mRearTireOffset[elementIndex] = vehicle->mRearTireOffset;
+    batch.mSteerCos[elementIndex] = cosf(vehicle->mSteeringAngleRadians);
+    batch.mSteerSin[elementIndex] = sinf(vehicle->mSteeringAngleRadians);
+    // speed is not known until friction impulses are applied, so keep both brake and reverse forces
+    batch.mDriveForce[elementIndex] = vehicle->GetEngineForce(currCtlState, 1.0f) * currCtlState.mDriveDirection;
+    batch.mReverseDriveForce[elementIndex] = vehicle->GetEngineForce(currCtlState, 0.0f) * currCtlState.mDriveDirection;
+
+    // steering changes after forces are computed, same order as in Vehicle::SimulationStep
+    vehicle->UpdateSteer(currCtlState);
+}
 
-    // todo: this is temporary implementation!
-    if (fabs(objectA_posY - objectB_posY) > 2.0f)
-        return false;
+void PhysicsManager::ComputeVehiclesDynamics(int beginIndex, int endIndex)
+{
+    const float rrCoef = 50.0f;
+    const float dragForceCoef = 102.0f;
 
-    if (gameObjectA->IsAttachedToObject() || gameObjectB->IsAttachedToObject())
+    VehiclesDynamicsBatch& batch = mVehiclesDynamics;
+    for (int i = beginIndex; i < endIndex; ++i)
     {
-        if (gameObjectA->IsSameHierarchy(gameObjectB))
-            return false;
-    }
+        const float mass = batch.mMass[i];
+        const float invMass = batch.mInvMass[i];
+        const float invInertia = batch.mInvInertia[i];
+        const float c = batch.mCos[i];
+        const float s = batch.mSin[i];
+
+        float velocityX = batch.mVelocityX[i];
+        float velocityY = batch.mVelocityY[i];
+        float angularVelocity = batch.mAngularVelocity[i];
+
+        // resistance is computed from velocity before any impulses
+        const float initialVelocityX = velocityX;
+        const float initialVelocityY = velocityY;
+        const float linearSpeed = sqrtf(velocityX * velocityX + velocityY * velocityY);
+
+        // tire positions relative to center of mass
+        const float frontArmX = batch.mPositionX[i] + c * batch.mFrontTireOffset[i] - batch.mCenterX[i];
+        const float frontArmY = batch.mPositionY[i] + s * batch.mFrontTireOffset[i] - batch.mCenterY[i];
+        const float rearArmX = batch.mPositionX[i] + c * batch.mRearTireOffset[i] - batch.mCenterX[i];
+        const float rearArmY = batch.mPositionY[i] + s * batch.mRearTireOffset[i] - batch.mCenterY[i];
+
+        // lateral vectors in world space, front tire is rotated by steering angle
+        const float frontLateralX = -(c * batch.mSteerSin[i] + s * batch.mSteerCos[i]);
+        const float frontLateralY = c * batch.mSteerCos[i] - s * batch.mSteerSin[i];
+        const float rearLateralX = -s;
+        const float rearLateralY = c;
+
+        KillTireLateralVelocity(mass, invMass, invInertia, frontArmX, frontArmY, frontLateralX, frontLateralY, velocityX, velocityY, angularVelocity);
+        KillTireLateralVelocity(mass, invMass, invInertia, rearArmX, rearArmY, rearLateralX, rearLateralY, velocityX, velocityY, angularVelocity);
+
+        float forceX = 0.0f;
+        float forceY = 0.0f;
+        float torque = 0.0f;
+
+        if (linearSpeed > 0.0f)
+        {
+            // rolling resistance
+            const float rrImpulseX = -rrCoef * initialVelocityX;
+            const float rrImpulseY = -rrCoef * initialVelocityY;
+            ApplyImpulseToVelocity(invMass, invInertia, frontArmX, frontArmY, rrImpulseX, rrImpulseY, velocityX, velocityY, angularVelocity);
+            ApplyImpulseToVelocity(invMass, invInertia, rearArmX, rearArmY, rrImpulseX, rrImpulseY, velocityX, velocityY, angularVelocity);
+
+            // drag force
+            forceX -= dragForceCoef * linearSpeed * initialVelocityX;
+            forceY -= dragForceCoef * linearSpeed * initialVelocityY;
+        }
 
-    bool shouldCollide = gameObjectA->ShouldCollide(gameObjectB) && gameObjectB->ShouldCollide(gameObjectA);
+        // drive force along rear tire, brake or reverse depends on speed after impulses as in Vehicle::UpdateDrive
+        const float forwardSpeed = velocityX * c + velocityY * s;
+        const float driveForce = (forwardSpeed > 0.0f) ? batch.mDriveForce[i] : batch.mReverseDriveForce[i];
+        const float driveForceX = driveForce * c;
+        const float driveForceY = driveForce * s;
+        forceX += driveForceX;
+        forceY += driveForceY;
+        torque += rearArmX * driveForceY - rearArmY * driveForceX;
+
+        batch.mVelocityX[i] = velocityX;
+        batch.mVelocityY[i] = velocityY;
+        batch.mAngularVelocity[i] = angularVelocity;
+        batch.mForceX[i] = forceX;
+        batch.mForceY[i] = forceY;
+        batch.mTorque[i] = torque;
+    }
+}
 
-    if (!shouldCollide)
+void PhysicsManager::ScatterVehiclesDynamics()
+{
+    VehiclesDynamicsBatch& batch = mVehiclesDynamics;
+    for (int i = 0, NumElements = batch.GetElementsCount(); i < NumElements; ++i)
     {
-        // register contact between objects
-        Contact objectsContact;
+        b2Body* box2body = batch.mVehicles[i]->mPhysicsBody->mBox2Body;
+        box2body->SetLinearVelocity(b2Vec2(batch.mVelocityX[i], batch.mVelocityY[i]));
+        box2body->SetAngularVelocity(batch.mAngularVelocity[i]);
 
-        objectsContact.SetupWithBox2Data(box2contact, fixtureA, fixtureB);
-        gameObjectA->RegisterContact(objectsContact);
+        if (batch.mForceX[i] != 0.0f || batch.mForceY[i] != 0.0f)
+        {
+            box2body->ApplyForceToCenter(b2Vec2(batch.mForceX[i], batch.mForceY[i]), true);
+        }
 
-        objectsContact.SetupWithBox2Data(box2contact, fixtureB, fixtureA);
-        gameObjectB->RegisterContact(objectsContact);
+        if (batch.mTorque[i] != 0.0f)
+        {
+            box2body->ApplyTorque(batch.mTorque[i], true);
+        }
     }
-    return shouldCollide;
 }
 
-void PhysicsManager::HandleCollision_ObjectWithMap(b2Fixture* objectFixture, b2Fixture* mapFixture, b2Contact* contact, const b2ContactImpulse* impulse)
+void PhysicsManager::ProcessVehiclesDynamics()
 {
-    GameObject* gameObject = b2Fixture_get_game_object(objectFixture);
-    cxx_assert(gameObject);
-
-    float height = gGame.mMap.GetHeightAtPosition(gameObject->mPhysicsBody->GetPosition());
-    int mapLayer = (int) (Convert::MetersToMapUnits(height) + 0.5f);
-
-    b2FixtureData_map fxdata = (b2FixtureData_map*) mapFixture->GetUserData().pointer;
+    int numElements = mVehiclesDynamics.GetElementsCount();
+    if (numElements == 0)
+        return;
 
-    // queue collision event
-    mObjectsCollisionList.emplace_back();
+    gSystem.mJobs.ParallelFor(numElements, VehiclesDynamicsBatchSize, [this](int beginIndex, int endIndex)
+    {
+        ComputeVehiclesDynamics(beginIndex, endIndex);
+    });
 
-    CollisionEvent& collisionEvent = mObjectsCollisionList.back();
-    collisionEvent.mBox2Impulse = *impulse;
-    collisionEvent.mBox2Contact = contact;
-    collisionEvent.mBox2FixtureA = objectFixture;
-    collisionEvent.mMapBlockInfo = gGame.mMap.GetBlockInfo(fxdata.mX, fxdata.mZ, mapLayer);
-    cxx_assert(collisionEvent.mMapBlockInfo);
+    ScatterVehiclesDynamics();
+    mVehiclesDynamics.Clear();
+}
 
-    if (Vehicle* carObject = ToVehicle(gameObject))
-    {
-        HandleCollision_CarVsMap(carObject, contact, impulse);
-        return;
-    }
+bool PhysicsManager::CanUseBatchedLocomotion(Pedestrian* pedestrian) const
+{
+    // contacts with cars and other pedestrians require per pedestrian processing
+    return pedestrian->IsIdle() && pedestrian->GetContacts().empty();
 }
 
-void PhysicsManager::HandleCollision_Objects(b2Fixture* fixtureA, b2Fixture* fixtureB, b2Contact* contact, const b2ContactImpulse* impulse)
+void PhysicsManager::GatherPedestrianLocomotion(Pedestrian* pedestrian)
 {
-    // queue collision event
-    mObjectsCollisionList.emplace_back();
+    // there are no contacts to inspect and idle states have no simulation frame logic
+    pedestrian->mContactingOtherPeds = false;
+    pedestrian->mContactingCars = false;
 
-    CollisionEvent& collisionEvent = mObjectsCollisionList.back();
-    collisionEvent.mBox2Impulse = *impulse;
-    collisionEvent.mBox2Contact = contact;
-    collisionEvent.mBox2FixtureA = fixtureA;
-    collisionEvent.mBox2FixtureB = fixtureB;
+    const PedestrianCtlState& ctlState = pedestrian->GetCtlState();
 
-    // handle collision
-    GameObject* objectA = b2Fixture_get_game_object(fixtureA);
-    GameObject* objectB = b2Fixture_get_game_object(fixtureB);
-    cxx_assert(objectA && objectB);
+    PedestriansLocomotionBatch& batch = mPedestriansLocomotion;
 
-    if (IsSameClass(objectA, objectB, eGameObjectClass_Car))
-    {
-        Vehicle* carA = ToVehicle(objectA);
-        Vehicle* carB = ToVehicle(objectB);
+    int elementIndex = batch.GetElementsCount();
+    batch.Resize(elementIndex + 1);
+    batch.mPedestrians[elementIndex] = pedestrian;
+    batch.mHeading[elementIndex] = pedestrian->mPhysicsBody->mBox2Body->GetAngle();
+    batch.mDesiredHeading[elementIndex] = ctlState.mDesiredRotationAngle.to_degrees();
+    batch.mRotateToDesired[elementIndex] = ctlState.mRotateToDesiredAngle ? 1 : 0;
 
-        HandleCollision_CarVsCar(carA, carB, contact, impulse);
-        return;
+    float turnSpeed = 0.0f;
+    if (ctlState.mTurnLeft || ctlState.mTurnRight)
+    {
+        turnSpeed = gGame.mParams.mPedestrianTurnSpeed * (ctlState.mTurnLeft ? -1.0f : 1.0f);
     }
-}
-
-void PhysicsManager::HandleCollision_CarVsCar(Vehicle* carA, Vehicle* carB, b2Contact* contact, const b2ContactImpulse* impulse)
-{
-    cxx_assert(carA && carB);
+    batch.mTurnSpeed[elementIndex] = turnSpeed;
 
-    if (gGame.mParticlesMng.IsCarSparksEffectEnabled())
+    float moveSpeed = 0.0f;
+    if (ctlState.mWalkForward || ctlState.mWalkBackward || ctlState.mRun)
     {
-        int pointCount = contact->GetManifold()->pointCount;
-        float impact = 0.0f;
-        for (int i = 0; i < pointCount; ++i)
+        if (ctlState.mRun && pedestrian->CanRun())
         {
-            impact = b2Max(impact, impulse->normalImpulses[i]);
+            moveSpeed = gGame.mParams.mPedestrianRunSpeed;
         }
-        b2WorldManifold wmanifold;
-        contact->GetWorldManifold(&wmanifold);
-
-        if (impact > gGame.mParams.mSparksOnCarsContactThreshold)
+        else
         {
-            glm::vec3 contactPoint(wmanifold.points->x, carA->mPhysicsBody->mPositionY, wmanifold.points->y);
-            glm::vec2 velocity2 = glm::normalize(
-                carA->mPhysicsBody->GetLinearVelocity() +
-                carB->mPhysicsBody->GetLinearVelocity());
-            glm::vec3 velocity = -glm::vec3(velocity2.x, 0.0f, velocity2.y) * 1.8f;
-            gGame.mParticlesMng.StartCarSparks(contactPoint, velocity, 3);
+            moveSpeed = gGame.mParams.mPedestrianWalkSpeed * (ctlState.mWalkBackward ? -1.0f : 1.0f);
         }
     }
+    batch.mMoveSpeed[elementIndex] = moveSpeed;
 }
 
-void PhysicsManager::HandleCollision_CarVsMap(Vehicle* car, b2Contact* contact, const b2ContactImpulse* impulse)
+void PhysicsManager::ComputePedestriansLocomotion(int beginIndex, int endIndex)
 {
-    cxx_assert(car);
-
-    int pointCount = contact->GetManifold()->pointCount;
-    float impact = 0.0f;
-    for (int i = 0; i < pointCount; ++i)
-    {
-        impact = b2Max(impact, impulse->normalImpulses[i]);
-    }
+    const float instantTurnSpeed = 360.0f * 10.0f;
+    const float stepTime = mSimulationStepTime;
 
-    if (gGame.mParticlesMng.IsCarSparksEffectEnabled())
+    PedestriansLocomotionBatch& batch = mPedestriansLocomotion;
+    for (int i = beginIndex; i < endIndex; ++i)
     {
-        b2WorldManifold wmanifold;
-        contact->GetWorldManifold(&wmanifold);
+        const float heading = batch.mHeading[i];
 
-        if (impact > gGame.mParams.mSparksOnCarsContactThreshold)
+        float angularVelocity = batch.mTurnSpeed[i];
+        if (batch.mRotateToDesired[i])
         {
-            glm::vec3 contactPoint(wmanifold.points->x, car->mPhysicsBody->mPositionY, wmanifold.points->y);
-            glm::vec2 velocity2 = glm::normalize(car->mPhysicsBody->GetLinearVelocity());
-            glm::vec3 velocity = -glm::vec3(velocity2.x, 0.0f, velocity2.y) * 1.8f;
-            gGame.mParticlesMng.StartCarSparks(contactPoint, velocity, 3);
+            angularVelocity = 0.0f;
+
+            float turnSpeed = instantTurnSpeed;
+            const float angleDelta = cxx::wrap_angle_neg_180(batch.mDesiredHeading[i] - glm::degrees(heading));
+            if (angleDelta < stepTime * turnSpeed)
+            {
+                turnSpeed = angleDelta / stepTime;
+            }
+            if (fabsf(turnSpeed) > 1.0f)
+            {
+                angularVelocity = turnSpeed;
+            }
         }
-    }
 
+        // move along current heading, rotation applies on next step
+        batch.mVelocityX[i] = cosf(heading) * batch.mMoveSpeed[i];
+        batch.mVelocityY[i] = sinf(heading) * batch.mMoveSpeed[i];
+        batch.mAngularVelocity[i] = angularVelocity;
+    }
+}
 
-    // sound
-    if (impact > 700.0f)
+void PhysicsManager::ScatterPedestriansLocomotion()
+{
+    PedestriansLocomotionBatch& batch = mPedestriansLocomotion;
+    for (int i = 0, NumElements = batch.GetElementsCount(); i < NumElements; ++i)
     {
-        //gAudioManager.StartSound(eSfxSampleType_Level, SfxLevel_CarCrash4, SfxFlags_RandomPitch, car->mTransform.mPosition);
+        b2Body* box2body = batch.mPedestrians[i]->mPhysicsBody->mBox2Body;
+        box2body->SetLinearVelocity(b2Vec2(batch.mVelocityX[i], batch.mVelocityY[i]));
+        box2body->SetAngularVelocity(glm::radians(batch.mAngularVelocity[i]));
     }
-
-    // bounce
-
 }
 
-void PhysicsManager::ProcessInterpolation()
+void PhysicsManager::ProcessPedestriansLocomotion()
 {
-    float mixFactor = mSimulationTimeAccumulator / mSimulationStepTime;
+    int numElements = mPedestriansLocomotion.GetElementsCount();
+    if (numElements == 0)
+        return;
 
-    for (PhysicsBody* currBody: mBodiesList)
+    gSystem.mJobs.ParallelFor(numElements, PedestriansLocomotionBatchSize, [this](int beginIndex, int endIndex)
     {
-        GameObject* gameObject = currBody->mGameObject;
-        if (!gameObject->IsAttachedToObject()) // interpolate roots
-        {
-            gameObject->InterpolateTransform(mixFactor);
-        }
-    }
+        ComputePedestriansLocomotion(beginIndex, endIndex);
+    });
+
+    ScatterPedestriansLocomotion();
+    mPedestriansLocomotion.Clear();
 }
 
-void PhysicsManager::DispatchCollisionEvents()
+void PhysicsManager::RunVehiclesDynamicsBenchmark(int numCars)
 {
-    for (const CollisionEvent& currCollision: mObjectsCollisionList)
+    if (mBox2World == nullptr)
     {
-        if (currCollision.mMapBlockInfo)
-        {
-            MapCollision collisionInfo;
+        gSystem.LogMessage(eLogMessage_Warning, "Cannot run vehicles dynamics benchmark, physics world is not created");
+        return;
+    }
+
+    cxx_assert(!IsSimulationStepInProgress());
+
+    gSystem.LogMessage(eLogMessage_Info, "Vehicles dynamics benchmark started");
+
+    const int NumIterations = 100;
+
+    std::vector<Vehicle*> cars;
+    for (Vehicle* currVehicle: gGame.mObjectsMng.mVehicles)
+    {
+        if ((int) cars.size() == numCars)
+            break;
+
+        if (currVehicle->mPhysicsBody == nullptr || currVehicle->mPhysicsBody->mSimplifiedSimulation ||
+            currVehicle->mPhysicsBody->CheckFlags(PhysicsBodyFlags_Disabled))
+        {
+            continue;
+        }
+        cars.push_back(currVehicle);
+    }
+
+    // spawn missing cars around the camera, they are moving but not stepped so overlapping is ok
+    cxx::randomizer random;
+    std::vector<Vehicle*> spawnedCars;
+    glm::vec2 spawnCenter = gGame.mCamera.mOnScreenMapArea.get_center();
+    while ((int) cars.size() < numCars)
+    {
+        glm::vec3 position(
+            spawnCenter.x + random.generate_float(-1.0f, 1.0f) * Convert::MapUnitsToMeters(4.0f), 0.0f,
+            spawnCenter.y + random.generate_float(-1.0f, 1.0f) * Convert::MapUnitsToMeters(4.0f));
+        position.y = gGame.mMap.GetHeightAtPosition(position);
+
+        Vehicle* vehicle = gGame.mObjectsMng.CreateVehicle(position, cxx::angle_t::from_degrees(random.generate_float(0.0f, 360.0f)), eVehicle_BeastGTS_1);
+        if (vehicle == nullptr)
+            break;
+
+        glm::vec2 forwardVector = vehicle->mPhysicsBody->GetWorldVector(LocalForwardVector);
+        vehicle->mPhysicsBody->SetLinearVelocity(forwardVector * random.generate_float(1.0f, 10.0f));
+        vehicle->mPhysicsBody->SetAngularVelocity(cxx::angle_t::from_degrees(random.generate_float(-45.0f, 45.0f)));
+        vehicle->mSteeringAngleRadians = glm::radians(random.generate_float(-30.0f, 30.0f));
+
+        spawnedCars.push_back(vehicle);
+        cars.push_back(vehicle);
+    }
+
+    struct CarState
+    {
+        glm::vec2 mLinearVelocity;
+        cxx::angle_t mAngularVelocity;
+        float mSteeringAngleRadians;
+    };
+    std::vector<CarState> initialState;
+    for (Vehicle* currVehicle: cars)
+    {
+        initialState.push_back({currVehicle->mPhysicsBody->GetLinearVelocity(), currVehicle->mPhysicsBody->GetAngularVelocity(), currVehicle->mSteeringAngleRadians});
+    }
+
+    auto restore_cars = [&cars, &initialState]()
+    {
+        for (size_t icar = 0; icar < cars.size(); ++icar)
+        {
+            cars[icar]->mPhysicsBody->ClearForces();
+            cars[icar]->mPhysicsBody->SetLinearVelocity(initialState[icar].mLinearVelocity);
+            cars[icar]->mPhysicsBody->SetAngularVelocity(initialState[icar].mAngularVelocity);
+            cars[icar]->mSteeringAngleRadians = initialState[icar].mSteeringAngleRadians;
+        }
+    };
+
+    // per car
+    std::vector<glm::vec2> perCarVelocities;
+    double startTime = gSystem.GetSystemSeconds();
+    for (int iteration = 0; iteration < NumIterations; ++iteration)
+    {
+        restore_cars();
+        for (Vehicle* currVehicle: cars)
+        {
+            currVehicle->SimulationStep();
+        }
+    }
+    double perCarTime = gSystem.GetSystemSeconds() - startTime;
+    for (Vehicle* currVehicle: cars)
+    {
+        perCarVelocities.push_back(currVehicle->mPhysicsBody->GetLinearVelocity());
+    }
+
+    // batched
+    startTime = gSystem.GetSystemSeconds();
+    for (int iteration = 0; iteration < NumIterations; ++iteration)
+    {
+        restore_cars();
+        for (Vehicle* currVehicle: cars)
+        {
+            GatherVehicleDynamics(currVehicle);
+        }
+        ProcessVehiclesDynamics();
+    }
+    double batchedTime = gSystem.GetSystemSeconds() - startTime;
+
+    float maxVelocityError = 0.0f;
+    for (size_t icar = 0; icar < cars.size(); ++icar)
+    {
+        float velocityError = glm::length(cars[icar]->mPhysicsBody->GetLinearVelocity() - perCarVelocities[icar]);
+        maxVelocityError = std::max(maxVelocityError, velocityError);
+    }
+
+    restore_cars();
+    for (Vehicle* currVehicle: spawnedCars)
+    {
+        gGame.mObjectsMng.DestroyGameObject(currVehicle);
+    }
+
+    double speedup = (batchedTime > 0.0) ? (perCarTime / batchedTime) : 0.0;
+    gSystem.LogMessage(eLogMessage_Info, "Cars: %d, per car: %.3f ms, batched: %.3f ms, speedup: %.2fx, max velocity error: %f",
+        (int) cars.size(), (perCarTime * 1000.0) / NumIterations, (batchedTime * 1000.0) / NumIterations, speedup, maxVelocityError);
+}
+
+void PhysicsManager::RunPedestriansLocomotionBenchmark(int numPeds)
+{
+    if (mBox2World == nullptr)
+    {
+        gSystem.LogMessage(eLogMessage_Warning, "Cannot run pedestrians locomotion benchmark, physics world is not created");
+        return;
+    }
+
+    cxx_assert(!IsSimulationStepInProgress());
+
+    gSystem.LogMessage(eLogMessage_Info, "Pedestrians locomotion benchmark started");
+
+    const int NumIterations = 100;
+    const double BatchedTimeBudget = 2.0; // milliseconds per step
+
+    std::vector<Pedestrian*> peds;
+    for (Pedestrian* currPedestrian: gGame.mObjectsMng.mPedestrians)
+    {
+        if ((int) peds.size() == numPeds)
+            break;
+
+        if (currPedestrian->mPhysicsBody == nullptr || currPedestrian->mPhysicsBody->mSimplifiedSimulation ||
+            currPedestrian->mPhysicsBody->CheckFlags(PhysicsBodyFlags_Disabled) || !CanUseBatchedLocomotion(currPedestrian))
+        {
+            continue;
+        }
+        peds.push_back(currPedestrian);
+    }
+
+    // spawn missing pedestrians around the camera, they are walking but not stepped so overlapping is ok
+    cxx::randomizer random;
+    std::vector<Pedestrian*> spawnedPeds;
+    std::vector<PedestrianCtlState> spawnedCtlStates;
+    spawnedCtlStates.reserve(numPeds); // keep pointers valid
+    glm::vec2 spawnCenter = gGame.mCamera.mOnScreenMapArea.get_center();
+    while ((int) peds.size() < numPeds)
+    {
+        glm::vec3 position(
+            spawnCenter.x + random.generate_float(-1.0f, 1.0f) * Convert::MapUnitsToMeters(4.0f), 0.0f,
+            spawnCenter.y + random.generate_float(-1.0f, 1.0f) * Convert::MapUnitsToMeters(4.0f));
+        position.y = gGame.mMap.GetHeightAtPosition(position);
+
+        Pedestrian* pedestrian = gGame.mObjectsMng.CreatePedestrian(position, cxx::angle_t::from_degrees(random.generate_float(0.0f, 360.0f)), ePedestrianType_Civilian);
+        if (pedestrian == nullptr)
+            break;
+
+        PedestrianCtlState ctlState;
+        ctlState.mWalkForward = true;
+        ctlState.mRun = random.random_chance(30);
+        ctlState.mRotateToDesiredAngle = true;
+        ctlState.mDesiredRotationAngle = cxx::angle_t::from_degrees(random.generate_float(0.0f, 360.0f));
+        spawnedCtlStates.push_back(ctlState);
+        pedestrian->mCtlState = &spawnedCtlStates.back();
+
+        spawnedPeds.push_back(pedestrian);
+        peds.push_back(pedestrian);
+    }
+
+    auto restore_peds = [&peds]()
+    {
+        for (Pedestrian* currPedestrian: peds)
+        {
+            currPedestrian->mPhysicsBody->ClearForces();
+        }
+    };
+
+    // per pedestrian
+    std::vector<glm::vec2> perPedVelocities;
+    double startTime = gSystem.GetSystemSeconds();
+    for (int iteration = 0; iteration < NumIterations; ++iteration)
+    {
+        restore_peds();
+        for (Pedestrian* currPedestrian: peds)
+        {
+            currPedestrian->SimulationStep();
+        }
+    }
+    double perPedTime = gSystem.GetSystemSeconds() - startTime;
+    for (Pedestrian* currPedestrian: peds)
+    {
+        perPedVelocities.push_back(currPedestrian->mPhysicsBody->GetLinearVelocity());
+    }
+
+    // batched
+    startTime = gSystem.GetSystemSeconds();
+    for (int iteration = 0; iteration < NumIterations; ++iteration)
+    {
+        restore_peds();
+        for (Pedestrian* currPedestrian: peds)
+        {
+            GatherPedestrianLocomotion(currPedestrian);
+        }
+        ProcessPedestriansLocomotion();
+    }
+    double batchedTime = gSystem.GetSystemSeconds() - startTime;
+
+    float maxVelocityError = 0.0f;
+    for (size_t iped = 0; iped < peds.size(); ++iped)
+    {
+        float velocityError = glm::length(peds[iped]->mPhysicsBody->GetLinearVelocity() - perPedVelocities[iped]);
+        maxVelocityError = std::max(maxVelocityError, velocityError);
+    }
+
+    restore_peds();
+    for (Pedestrian* currPedestrian: spawnedPeds)
+    {
+        currPedestrian->mCtlState = nullptr;
+        gGame.mObjectsMng.DestroyGameObject(currPedestrian);
+    }
+
+    double speedup = (batchedTime > 0.0) ? (perPedTime / batchedTime) : 0.0;
+    double batchedStepTime = (batchedTime * 1000.0) / NumIterations;
+    gSystem.LogMessage(eLogMessage_Info, "Pedestrians: %d, per pedestrian: %.3f ms, batched: %.3f ms, speedup: %.2fx, max velocity error: %f",
+        (int) peds.size(), (perPedTime * 1000.0) / NumIterations, batchedStepTime, speedup, maxVelocityError);
+
+    if (batchedStepTime > BatchedTimeBudget)
+    {
+        gSystem.LogMessage(eLogMessage_Warning, "Batched pedestrians locomotion is over budget: %.3f ms > %.3f ms", batchedStepTime, BatchedTimeBudget);
+    }
+}
+
+void PhysicsManager::RunPointBlankProjectileTest()
+{
+    if (mBox2World == nullptr)
+    {
+        gSystem.LogMessage(eLogMessage_Warning, "Cannot run point blank projectile test, physics world is not created");
+        return;
+    }
+
+    cxx_assert(!IsSimulationStepInProgress());
+
+    // projectile starts inside target which stands right before shooter
+    glm::vec2 spawnCenter = gGame.mCamera.mOnScreenMapArea.get_center();
+    glm::vec3 shooterPosition (spawnCenter.x, 0.0f, spawnCenter.y);
+    shooterPosition.y = gGame.mMap.GetHeightAtPosition(shooterPosition);
+
+    WeaponInfo* weaponInfo = &gGame.mStyleData.mWeaponTypes[eWeapon_Pistol];
+    Pedestrian* shooter = gGame.mObjectsMng.CreatePedestrian(shooterPosition, cxx::angle_t::from_degrees(0.0f), ePedestrianType_Civilian);
+    if (shooter == nullptr)
+    {
+        gSystem.LogMessage(eLogMessage_Warning, "Cannot run point blank projectile test, shooter is not created");
+        return;
+    }
+
+    glm::vec2 offset = shooter->mTransform.GetDirectionVector() * (gGame.mParams.mPedestrianBoundsSphereRadius + weaponInfo->mProjectileSize);
+    glm::vec3 projectilePosition (shooterPosition.x + offset.x, shooterPosition.y, shooterPosition.z + offset.y);
+
+    bool hasHit = false;
+    Pedestrian* target = gGame.mObjectsMng.CreatePedestrian(projectilePosition, cxx::angle_t::from_degrees(180.0f), ePedestrianType_Civilian);
+    if (target)
+    {
+        Projectile* projectile = gGame.mObjectsMng.CreateProjectile(projectilePosition, shooter->mTransform.mOrientation, weaponInfo, shooter);
+        if (projectile)
+        {
+            // single step of test projectile only, hit is registered but never applied
+            int rayIndex = projectile->mProjectileRayIndex;
+            cxx_assert(rayIndex != -1);
+
+            PhysicsQueryResult queryResult (gSystem.mMemoryMng.GetFrameHeapAllocator());
+            TraceProjectilesMap(rayIndex, rayIndex + 1);
+            TraceProjectileObjects(mProjectileRays[rayIndex], queryResult);
+            hasHit = projectile->mHitSomething && (projectile->mHitObject == target);
+
+            gGame.mObjectsMng.DestroyGameObject(projectile);
+        }
+        gGame.mObjectsMng.DestroyGameObject(target);
+    }
+    gGame.mObjectsMng.DestroyGameObject(shooter);
+
+    if (!hasHit)
+    {
+        gSystem.LogMessage(eLogMessage_Warning, "Point blank projectile test failed, adjacent pedestrian is not hit");
+        return;
+    }
+    gSystem.LogMessage(eLogMessage_Info, "Point blank projectile test passed");
+}
+
+void PhysicsManager::QueryObjectsLinecast(const glm::vec2& pointA, const glm::vec2& pointB, const PhysicsQueryFilter& queryFilter, const PhysicsQueryProc& queryProc) const
+{
+    cxx_assert(queryProc);
+
+    struct _raycast_callback: public b2RayCastCallback
+    {
+    public:
+        _raycast_callback(const PhysicsManager& physicsManager, const PhysicsQueryFilter& queryFilter, const PhysicsQueryProc& queryProc)
+            : mPhysicsManager(physicsManager)
+            , mQueryFilter(queryFilter)
+            , mQueryProc(queryProc)
+        {
+        }
+        float ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float fraction) override
+        {
+            PhysicsQueryElement currHit;
+            currHit.mPhysicsObject = mPhysicsManager.FilterQueryFixture(fixture, mQueryFilter);
+            if (currHit.mPhysicsObject == nullptr)
+                return 1.0f;
+
+            currHit.mIntersectionPoint = convert_vec2(point);
+            currHit.mNormal = convert_vec2(normal);
+            currHit.mFraction = fraction;
+            return mQueryProc(currHit) ? 1.0f : 0.0f;
+        }
+    public:
+        const PhysicsManager& mPhysicsManager;
+        const PhysicsQueryFilter& mQueryFilter;
+        const PhysicsQueryProc& mQueryProc;
+    };
+
+    if ((queryFilter.mCollisionMask & ~(CollisionGroup_MapBlock | CollisionGroup_Wall)) == CollisionGroup_None)
+        return;
+
+    _raycast_callback raycast_callback {*this, queryFilter, queryProc};
+    b2Vec2 p1 = convert_vec2(pointA);
+    b2Vec2 p2 = convert_vec2(pointB);
+    mBox2World->RayCast(&raycast_callback, p1, p2);
+}
+
+void PhysicsManager::QueryObjectsLinecast(const glm::vec2& pointA, const glm::vec2& pointB, const PhysicsQueryFilter& queryFilter, PhysicsQueryResult& outputResult) const
+{
+    outputResult.clear();
+    QueryObjectsLinecast(pointA, pointB, queryFilter, [&outputResult](const PhysicsQueryElement& queryElement)
+    {
+        outputResult.push_back(queryElement);
+        return true;
+    });
+
+    if (outputResult.size() < 2)
+        return;
+
+    // keep nearest hit of each body
+    std::sort(outputResult.begin(), outputResult.end(), [](const PhysicsQueryElement& lhs, const PhysicsQueryElement& rhs)
+    {
+        if (lhs.mPhysicsObject != rhs.mPhysicsObject)
+            return lhs.mPhysicsObject < rhs.mPhysicsObject;
+
+        return lhs.mFraction < rhs.mFraction;
+    });
+    auto uniqueEnd = std::unique(outputResult.begin(), outputResult.end(), [](const PhysicsQueryElement& lhs, const PhysicsQueryElement& rhs)
+    {
+        return lhs.mPhysicsObject == rhs.mPhysicsObject;
+    });
+    outputResult.erase(uniqueEnd, outputResult.end());
+
+    std::sort(outputResult.begin(), outputResult.end(), [](const PhysicsQueryElement& lhs, const PhysicsQueryElement& rhs)
+    {
+        return lhs.mFraction < rhs.mFraction;
+    });
+}
+
+void PhysicsManager::QueryObjectsWithinBox(const glm::vec2& center, const glm::vec2& extents, const PhysicsQueryFilter& queryFilter, const PhysicsQueryProc& queryProc) const
+{
+    cxx_assert(queryProc);
+
+    struct _query_callback: public b2QueryCallback
+    {
+    public:
+        _query_callback(const PhysicsManager& physicsManager, const PhysicsQueryFilter& queryFilter, const PhysicsQueryProc& queryProc)
+            : mPhysicsManager(physicsManager)
+            , mQueryFilter(queryFilter)
+            , mQueryProc(queryProc)
+        {
+        }
+        bool ReportFixture(b2Fixture* fixture) override
+        {
+            PhysicsQueryElement currHit;
+            currHit.mPhysicsObject = mPhysicsManager.FilterQueryFixture(fixture, mQueryFilter);
+            if (currHit.mPhysicsObject == nullptr)
+                return true;
+
+            return mQueryProc(currHit);
+        }
+    public:
+        const PhysicsManager& mPhysicsManager;
+        const PhysicsQueryFilter& mQueryFilter;
+        const PhysicsQueryProc& mQueryProc;
+    };
+
+    if ((queryFilter.mCollisionMask & ~(CollisionGroup_MapBlock | CollisionGroup_Wall)) == CollisionGroup_None)
+        return;
+
+    _query_callback query_callback {*this, queryFilter, queryProc};
+
+    b2AABB aabb;
+    aabb.lowerBound.x = (center.x - extents.x);
+    aabb.lowerBound.y = (center.y - extents.y);
+    aabb.upperBound.x = (center.x + extents.x);
+    aabb.upperBound.y = (center.y + extents.y);
+    mBox2World->QueryAABB(&query_callback, aabb);
+}
+
+void PhysicsManager::QueryObjectsWithinBox(const glm::vec2& center, const glm::vec2& extents, const PhysicsQueryFilter& queryFilter, PhysicsQueryResult& outputResult) const
+{
+    outputResult.clear();
+    QueryObjectsWithinBox(center, extents, queryFilter, [&outputResult](const PhysicsQueryElement& queryElement)
+    {
+        // colliders of same body are usually reported in row
+        if (outputResult.empty() || (outputResult.back().mPhysicsObject != queryElement.mPhysicsObject))
+        {
+            outputResult.push_back(queryElement);
+        }
+        return true;
+    });
+
+    if (outputResult.size() < 2)
+        return;
+
+    std::sort(outputResult.begin(), outputResult.end(), [](const PhysicsQueryElement& lhs, const PhysicsQueryElement& rhs)
+    {
+        return lhs.mPhysicsObject < rhs.mPhysicsObject;
+    });
+    auto uniqueEnd = std::unique(outputResult.begin(), outputResult.end(), [](const PhysicsQueryElement& lhs, const PhysicsQueryElement& rhs)
+    {
+        return lhs.mPhysicsObject == rhs.mPhysicsObject;
+    });
+    outputResult.erase(uniqueEnd, outputResult.end());
+}
+
+PhysicsBody* PhysicsManager::FilterQueryFixture(b2Fixture* fixture, const PhysicsQueryFilter& queryFilter) const
+{
+    // map is ignored
+    const CollisionGroup collisionMask = (CollisionGroup) (queryFilter.mCollisionMask & ~(CollisionGroup_MapBlock | CollisionGroup_Wall));
+
+    const b2Filter& filterData = fixture->GetFilterData();
+    if ((filterData.categoryBits & collisionMask) == 0)
+        return nullptr;
+
+    PhysicsBody* physicsBody = b2Fixture_get_physics_body(fixture);
+    if ((physicsBody == nullptr) || (physicsBody->mGameObject == nullptr))
+        return nullptr;
+
+    if ((queryFilter.mObjectClass != eGameObjectClass_COUNT) && (physicsBody->mGameObject->mClassID != queryFilter.mObjectClass))
+        return nullptr;
+
+    if (physicsBody->mGameObject == queryFilter.mIgnoreObject)
+        return nullptr;
+
+    return physicsBody;
+}
+
+bool PhysicsManager::IsSimulationStepInProgress() const
+{
+    return mBox2World->IsLocked();
+}
+
+bool PhysicsManager::ShouldCollide_ObjectWithMap(b2Contact* contact, b2Fixture* objectFixture, b2Fixture* mapFixture) const
+{
+    GameObject* gameObject = b2Fixture_get_game_object(objectFixture);
+
+    cxx_assert(gameObject);
+    cxx_assert(!gameObject->IsAttachedToObject());
+
+    if (gameObject->IsMarkedForDeletion())
+        return false;
+
+    cxx_assert(gameObject->mPhysicsBody);
+    if (gameObject->mPhysicsBody->CheckFlags(PhysicsBodyFlags_Disabled))
+        return false;
+
+    float height = gGame.mMap.GetHeightAtPosition(gameObject->mPhysicsBody->GetPosition());
+    int mapLayer = (int) (Convert::MetersToMapUnits(height) + 0.5f);
+
+    // todo: this is temporary implementation
+
+    b2FixtureData_map fxdata = (b2FixtureData_map*) mapFixture->GetUserData().pointer;
+    const MapBlockInfo* blockData = gGame.mMap.GetBlockInfo(fxdata.mX, fxdata.mZ, mapLayer);
+    return (blockData->mGroundType == eGroundType_Building);
+}
+
+bool PhysicsManager::ShouldCollide_Objects(b2Contact* box2contact, b2Fixture* fixtureA, b2Fixture* fixtureB)
+{
+    GameObject* gameObjectA = b2Fixture_get_game_object(fixtureA);
+    GameObject* gameObjectB = b2Fixture_get_game_object(fixtureB);
+
+    cxx_assert(gameObjectA);
+    cxx_assert(gameObjectB);
+    cxx_assert(gameObjectA != gameObjectB);
+
+    if (gameObjectA->IsMarkedForDeletion() || gameObjectB->IsMarkedForDeletion())
+        return false;
+
+    // decision depends on objects classes and states only, the rest are checked for specific pair
+    const eObjectsCollision objectsCollision = mObjectsCollisionTable[gameObjectA->mClassID][GetObjectCollisionState(gameObjectA)]
+        [gameObjectB->mClassID][GetObjectCollisionState(gameObjectB)];
+    if (objectsCollision == eObjectsCollision_None)
+        return false;
+
+    cxx_assert(gameObjectA->mPhysicsBody);
+    cxx_assert(gameObjectB->mPhysicsBody);
+
+    if (gameObjectA->mPhysicsBody->CheckFlags(PhysicsBodyFlags_Disabled))
+        return false;
+
+    if (gameObjectB->mPhysicsBody->CheckFlags(PhysicsBodyFlags_Disabled))
+        return false;
+
+    // todo: check y positions!
+    float objectA_posY = gameObjectA->mPhysicsBody->mPositionY;
+    float objectB_posY = gameObjectB->mPhysicsBody->mPositionY;
+
+    // todo: this is temporary implementation!
+    if (fabs(objectA_posY - objectB_posY) > 2.0f)
+        return false;
+
+    if (gameObjectA->IsAttachedToObject() || gameObjectB->IsAttachedToObject())
+    {
+        if (gameObjectA->IsSameHierarchy(gameObjectB))
+            return false;
+    }
+
+    bool shouldCollide = (objectsCollision == eObjectsCollision_Response);
+    if (!shouldCollide)
+    {
+        // register contact between objects, contacts are grouped by objects after simulation step
+        mPendingContacts.emplace_back();
+        mPendingContacts.back().SetupWithBox2Data(box2contact, fixtureA, fixtureB);
+
+        mPendingContacts.emplace_back();
+        mPendingContacts.back().SetupWithBox2Data(box2contact, fixtureB, fixtureA);
+    }
+    return shouldCollide;
+}
+
+void PhysicsManager::QueueCollisionEvent(b2Fixture* objectFixture, b2Fixture* otherFixture, bool isMapCollision, b2Contact* contact, const b2ContactImpulse* impulse)
+{
+    mObjectsCollisionList.emplace_back();
+
+    CollisionEvent& collisionEvent = mObjectsCollisionList.back();
+    collisionEvent.mObjectA = b2Fixture_get_game_object(objectFixture);
+    collisionEvent.mObjectB = isMapCollision ? nullptr : b2Fixture_get_game_object(otherFixture);
+    cxx_assert(collisionEvent.mObjectA);
+    cxx_assert(isMapCollision || collisionEvent.mObjectB);
+    collisionEvent.mBox2FixtureA = objectFixture;
+    collisionEvent.mBox2FixtureB = otherFixture;
+
+    for (int ipoint = 0; ipoint < impulse->count; ++ipoint)
+    {
+        collisionEvent.mContactImpulse += impulse->normalImpulses[ipoint];
+        collisionEvent.mPointImpulse = std::max(collisionEvent.mPointImpulse, impulse->normalImpulses[ipoint]);
+    }
+
+    b2WorldManifold wmanifold;
+    contact->GetWorldManifold(&wmanifold);
+
+    int pointCount = std::min(contact->GetManifold()->pointCount, b2_maxManifoldPoints);
+    for (int ipoint = 0; ipoint < pointCount; ++ipoint)
+    {
+        collisionEvent.mContactPointsSum += convert_vec2(wmanifold.points[ipoint]);
+    }
+    collisionEvent.mContactPointsCount = pointCount;
+    collisionEvent.mNormal = convert_vec2(wmanifold.normal);
+    collisionEvent.mSeparation = wmanifold.separations[0];
+}
+
+void PhysicsManager::CoalesceCollisionEvents()
+{
+    int numEvents = (int) mObjectsCollisionList.size();
+    if (numEvents < 2)
+        return;
+
+    auto get_pair_key = [](const CollisionEvent& collisionEvent)
+    {
+        uintptr_t objectA = reinterpret_cast<uintptr_t>(collisionEvent.mObjectA);
+        uintptr_t objectB = reinterpret_cast<uintptr_t>(collisionEvent.mObjectB);
+        return (objectB < objectA) ? std::make_pair(objectB, objectA) : std::make_pair(objectA, objectB);
+    };
+
+    // group events by objects pair, order of contacts within pair is kept
+    FrameHeapVector<int> eventsOrder (gSystem.mMemoryMng.GetFrameHeapAllocator());
+    eventsOrder.resize(numEvents);
+    for (int ievent = 0; ievent < numEvents; ++ievent)
+    {
+        eventsOrder[ievent] = ievent;
+    }
+    std::stable_sort(eventsOrder.begin(), eventsOrder.end(), [this, &get_pair_key](int lhs, int rhs)
+    {
+        return get_pair_key(mObjectsCollisionList[lhs]) < get_pair_key(mObjectsCollisionList[rhs]);
+    });
+
+    // merge events of each pair into first one
+    FrameHeapVector<int> firstEvents (gSystem.mMemoryMng.GetFrameHeapAllocator());
+    for (int isorted = 0; isorted < numEvents; )
+    {
+        int firstEvent = eventsOrder[isorted];
+        CollisionEvent& mergedEvent = mObjectsCollisionList[firstEvent];
+        const auto pairKey = get_pair_key(mergedEvent);
+        for (++isorted; (isorted < numEvents) && (get_pair_key(mObjectsCollisionList[eventsOrder[isorted]]) == pairKey); ++isorted)
+        {
+            const CollisionEvent& currEvent = mObjectsCollisionList[eventsOrder[isorted]];
+            // strongest contact defines colliders and normal, objects order of first contact is kept
+            if (currEvent.mContactImpulse > mergedEvent.mContactImpulse)
+            {
+                mergedEvent.mContactImpulse = currEvent.mContactImpulse;
+                mergedEvent.mNormal = currEvent.mNormal;
+                mergedEvent.mSeparation = currEvent.mSeparation;
+                if (currEvent.mObjectA == mergedEvent.mObjectA)
+                {
+                    mergedEvent.mBox2FixtureA = currEvent.mBox2FixtureA;
+                    mergedEvent.mBox2FixtureB = currEvent.mBox2FixtureB;
+                }
+                else
+                {
+                    // objects are swapped, so normal should point other way
+                    mergedEvent.mBox2FixtureA = currEvent.mBox2FixtureB;
+                    mergedEvent.mBox2FixtureB = currEvent.mBox2FixtureA;
+                    mergedEvent.mNormal = -currEvent.mNormal;
+                }
+            }
+            mergedEvent.mPointImpulse = std::max(mergedEvent.mPointImpulse, currEvent.mPointImpulse);
+            mergedEvent.mContactPointsSum += currEvent.mContactPointsSum;
+            mergedEvent.mContactPointsCount += currEvent.mContactPointsCount;
+        }
+        firstEvents.push_back(firstEvent);
+    }
+
+    // restore order of first contacts, merged events are only moved towards list start
+    std::sort(firstEvents.begin(), firstEvents.end());
+    for (int ievent = 0, NumMergedEvents = (int) firstEvents.size(); ievent < NumMergedEvents; ++ievent)
+    {
+        if (ievent != firstEvents[ievent])
+        {
+            mObjectsCollisionList[ievent] = mObjectsCollisionList[firstEvents[ievent]];
+        }
+    }
+    mObjectsCollisionList.resize(firstEvents.size());
+}
+
+void PhysicsManager::HandleCollision_CarVsCar(Vehicle* carA, Vehicle* carB, const CollisionEvent& collisionEvent, const glm::vec2& contactPoint)
+{
+    cxx_assert(carA && carB);
+
+    if (gGame.mParticlesMng.IsCarSparksEffectEnabled())
+    {
+        if (collisionEvent.mPointImpulse > gGame.mParams.mSparksOnCarsContactThreshold)
+        {
+            glm::vec3 sparksPoint(contactPoint.x, carA->mPhysicsBody->mPositionY, contactPoint.y);
+            glm::vec2 velocity2 = glm::normalize(
+                carA->mPhysicsBody->GetLinearVelocity() +
+                carB->mPhysicsBody->GetLinearVelocity());
+            glm::vec3 velocity = -glm::vec3(velocity2.x, 0.0f, velocity2.y) * 1.8f;
+            gGame.mParticlesMng.StartCarSparks(sparksPoint, velocity, 3);
+        }
+    }
+}
+
+void PhysicsManager::HandleCollision_CarVsMap(Vehicle* car, const CollisionEvent& collisionEvent, const glm::vec2& contactPoint)
+{
+    cxx_assert(car);
+
+    float impact = collisionEvent.mPointImpulse;
+
+    if (gGame.mParticlesMng.IsCarSparksEffectEnabled())
+    {
+        if (impact > gGame.mParams.mSparksOnCarsContactThreshold)
+        {
+            glm::vec3 sparksPoint(contactPoint.x, car->mPhysicsBody->mPositionY, contactPoint.y);
+            glm::vec2 velocity2 = glm::normalize(car->mPhysicsBody->GetLinearVelocity());
+            glm::vec3 velocity = -glm::vec3(velocity2.x, 0.0f, velocity2.y) * 1.8f;
+            gGame.mParticlesMng.StartCarSparks(sparksPoint, velocity, 3);
+        }
+    }
+
+
+    // sound
+    if (impact > 700.0f)
+    {
+        //gAudioManager.StartSound(eSfxSampleType_Level, SfxLevel_CarCrash4, SfxFlags_RandomPitch, car->mTransform.mPosition);
+    }
+
+    // bounce
+
+}
+
+void PhysicsManager::ProcessInterpolation()
+{
+    float mixFactor = mSimulationTimeAccumulator / mSimulationStepTime;
+
+    for (PhysicsBody* currBody: mBodiesList)
+    {
+        GameObject* gameObject = currBody->mGameObject;
+        if (!gameObject->IsAttachedToObject()) // interpolate roots
+        {
+            gameObject->InterpolateTransform(mixFactor);
+        }
+    }
+
+    for (ProjectileRay& currRay: mProjectileRays)
+    {
+        currRay.mProjectile->InterpolateTransform(mixFactor);
+    }
+}
+
+void PhysicsManager::DispatchCollisionEvents()
+{
+    // single event per objects pair
+    CoalesceCollisionEvents();
+
+    for (const CollisionEvent& currCollision: mObjectsCollisionList)
+    {
+        // post solve is reported for touching contacts only
+        cxx_assert(currCollision.mContactPointsCount > 0);
+        glm::vec2 contactPoint = currCollision.mContactPointsSum / (float) std::max(currCollision.mContactPointsCount, 1);
+
+        Collider* colliderA = b2Fixture_get_collider(currCollision.mBox2FixtureA);
+        cxx_assert(colliderA);
 
-            collisionInfo.SetupWithBox2Data(currCollision.mBox2Contact, currCollision.mBox2FixtureA, currCollision.mMapBlockInfo, &currCollision.mBox2Impulse);
-            collisionInfo.mThisObject->HandleCollisionWithMap(collisionInfo);
+        if (currCollision.mObjectB == nullptr)
+        {
+            GameObject* gameObject = currCollision.mObjectA;
+
+            float height = gGame.mMap.GetHeightAtPosition(gameObject->mPhysicsBody->GetPosition());
+            int mapLayer = (int) (Convert::MetersToMapUnits(height) + 0.5f);
+
+            b2FixtureData_map fxdata = (b2FixtureData_map*) currCollision.mBox2FixtureB->GetUserData().pointer;
+
+            MapCollision collisionInfo;
+            collisionInfo.Setup(colliderA, gGame.mMap.GetBlockInfo(fxdata.mX, fxdata.mZ, mapLayer),
+                contactPoint, currCollision.mNormal, currCollision.mSeparation, currCollision.mContactImpulse);
+
+            if (Vehicle* carObject = ToVehicle(gameObject))
+            {
+                HandleCollision_CarVsMap(carObject, currCollision, contactPoint);
+            }
+            gameObject->HandleCollisionWithMap(collisionInfo);
         }
         else
         {
-            Collision collisionInfo;
+            Collider* colliderB = b2Fixture_get_collider(currCollision.mBox2FixtureB);
+            cxx_assert(colliderB);
+
+            if (IsSameClass(currCollision.mObjectA, currCollision.mObjectB, eGameObjectClass_Car))
+            {
+                HandleCollision_CarVsCar(ToVehicle(currCollision.mObjectA), ToVehicle(currCollision.mObjectB), currCollision, contactPoint);
+            }
 
-            collisionInfo.SetupWithBox2Data(currCollision.mBox2Contact, currCollision.mBox2FixtureA, currCollision.mBox2FixtureB, &currCollision.mBox2Impulse);
-            collisionInfo.mContactInfo.mThisObject->HandleCollision(collisionInfo);
+            Collision collisionInfo;
+            collisionInfo.Setup(colliderA, colliderB, contactPoint, currCollision.mNormal, currCollision.mSeparation, currCollision.mContactImpulse);
+            currCollision.mObjectA->HandleCollision(collisionInfo);
 
-            collisionInfo.SetupWithBox2Data(currCollision.mBox2Contact, currCollision.mBox2FixtureB, currCollision.mBox2FixtureA, &currCollision.mBox2Impulse);
-            collisionInfo.mContactInfo.mThisObject->HandleCollision(collisionInfo);
+            collisionInfo.Setup(colliderB, colliderA, contactPoint, currCollision.mNormal, currCollision.mSeparation, currCollision.mContactImpulse);
+            currCollision.mObjectB->HandleCollision(collisionInfo);
         }
     }
     mObjectsCollisionList.clear();
 }
 
+void PhysicsManager::BuildContactsArena()
+{
+    const int arenaIndex = 1 - mCurrentContactsArena;
+
+    // count contacts of each body
+    for (PhysicsBody* currBody: mBodiesList)
+    {
+        currBody->mContactsCount[arenaIndex] = 0;
+    }
+    for (const Contact& currContact: mPendingContacts)
+    {
+        ++currContact.mThisObject->mPhysicsBody->mContactsCount[arenaIndex];
+    }
+
+    // assign ranges
+    int contactsCount = 0;
+    for (PhysicsBody* currBody: mBodiesList)
+    {
+        currBody->mContactsStart[arenaIndex] = contactsCount;
+        contactsCount += currBody->mContactsCount[arenaIndex];
+        currBody->mContactsCount[arenaIndex] = 0;
+    }
+
+    // scatter, order of contacts within body range is same as registration order
+    std::vector<Contact>& contactsArena = mContactsArenas[arenaIndex];
+    contactsArena.resize(contactsCount);
+    for (const Contact& currContact: mPendingContacts)
+    {
+        PhysicsBody* physicsBody = currContact.mThisObject->mPhysicsBody;
+        contactsArena[physicsBody->mContactsStart[arenaIndex] + physicsBody->mContactsCount[arenaIndex]++] = currContact;
+    }
+    mPendingContacts.clear();
+    mCurrentContactsArena = arenaIndex;
+}
+
+void PhysicsManager::DispatchContactEvents()
+{
+    auto find_contact = [](const ContactsList& contacts, const Contact* endContact, GameObject* otherObject)
+    {
+        for (const Contact* currContact = contacts.begin(); currContact != endContact; ++currContact)
+        {
+            if (currContact->mThatObject == otherObject)
+                return true;
+        }
+        return false;
+    };
+
+    // handlers might create new objects, bodies created here have no contacts yet so they are not visited
+    // destroying bodies is not allowed, objects should be marked for deletion instead
+    FrameHeapVector<PhysicsBody*> bodiesList (mBodiesList.begin(), mBodiesList.end(), gSystem.mMemoryMng.GetFrameHeapAllocator());
+
+    mContactEventsDispatchInProgress = true;
+    for (PhysicsBody* currBody: bodiesList)
+    {
+        GameObject* gameObject = currBody->mGameObject;
+        if (gameObject->IsMarkedForDeletion())
+            continue;
+
+        ContactsList currentContacts = GetContacts(currBody);
+        ContactsList previousContacts = GetPreviousContacts(currBody);
+
+        // objects pair might have multiple contacts, report first one
+        for (const Contact& currContact: currentContacts)
+        {
+            if (find_contact(currentContacts, &currContact, currContact.mThatObject))
+                continue;
+
+            if (find_contact(previousContacts, previousContacts.end(), currContact.mThatObject))
+            {
+                gameObject->HandleContactPersist(currContact);
+            }
+            else
+            {
+                gameObject->HandleContactBegin(currContact);
+            }
+        }
+
+        for (const Contact& prevContact: previousContacts)
+        {
+            if (find_contact(previousContacts, &prevContact, prevContact.mThatObject))
+                continue;
+
+            if (!find_contact(currentContacts, currentContacts.end(), prevContact.mThatObject))
+            {
+                gameObject->HandleContactEnd(prevContact);
+            }
+        }
+    }
+    mContactEventsDispatchInProgress = false;
+}
+
+void PhysicsManager::RemoveContactsWithObject(int arenaIndex, PhysicsBody* physicsBody, GameObject* otherObject)
+{
+    Contact* contacts = mContactsArenas[arenaIndex].data() + physicsBody->mContactsStart[arenaIndex];
+    int& contactsCount = physicsBody->mContactsCount[arenaIndex];
+    for (int icontact = 0; icontact < contactsCount; )
+    {
+        if (contacts[icontact].mThatObject == otherObject)
+        {
+            contacts[icontact] = contacts[--contactsCount];
+            continue;
+        }
+        ++icontact;
+    }
+}
+
+ContactsList PhysicsManager::GetContacts(const PhysicsBody* physicsBody) const
+{
+    cxx_assert(physicsBody);
+
+    const int arenaIndex = mCurrentContactsArena;
+    return ContactsList(mContactsArenas[arenaIndex].data() + physicsBody->mContactsStart[arenaIndex], physicsBody->mContactsCount[arenaIndex]);
+}
+
+ContactsList PhysicsManager::GetPreviousContacts(const PhysicsBody* physicsBody) const
+{
+    cxx_assert(physicsBody);
+
+    const int arenaIndex = 1 - mCurrentContactsArena;
+    return ContactsList(mContactsArenas[arenaIndex].data() + physicsBody->mContactsStart[arenaIndex], physicsBody->mContactsCount[arenaIndex]);
+}
+
+void PhysicsManager::RegisterProjectile(Projectile* projectile)
+{
+    cxx_assert(projectile);
+    cxx_assert(projectile->mProjectileRayIndex == -1);
+
+    projectile->mProjectileRayIndex = (int) mProjectileRays.size();
+
+    ProjectileRay projectileRay;
+    projectileRay.mProjectile = projectile;
+    projectileRay.mPosition = projectile->mTransform.mPosition;
+    projectileRay.mDirection = projectile->mTransform.GetDirectionVector();
+    if (projectile->mWeaponInfo)
+    {
+        projectileRay.mSpeed = projectile->mWeaponInfo->mProjectileSpeed;
+        projectileRay.mDistanceLeft = projectile->mWeaponInfo->mBaseHitRange;
+    }
+    mProjectileRays.push_back(projectileRay);
+}
+
+void PhysicsManager::UnregisterProjectile(Projectile* projectile)
+{
+    cxx_assert(projectile);
+
+    int rayIndex = projectile->mProjectileRayIndex;
+    if (rayIndex == -1)
+        return;
+
+    cxx_assert(mProjectileRays[rayIndex].mProjectile == projectile);
+    projectile->mProjectileRayIndex = -1;
+
+    // move last ray in place of removed one
+    if (rayIndex != (int) mProjectileRays.size() - 1)
+    {
+        mProjectileRays[rayIndex] = mProjectileRays.back();
+        mProjectileRays[rayIndex].mProjectile->mProjectileRayIndex = rayIndex;
+    }
+    mProjectileRays.pop_back();
+}
+
+void PhysicsManager::ProcessProjectiles()
+{
+    int numElements = (int) mProjectileRays.size();
+    if (numElements == 0)
+        return;
+
+    // map is read-only, each job writes only its own rays
+    gSystem.mJobs.ParallelFor(numElements, ProjectileRaysBatchSize, [this](int beginIndex, int endIndex)
+    {
+        TraceProjectilesMap(beginIndex, endIndex);
+    });
+
+    // objects are traced serially in rays order, hits are only registered here and applied by projectile on next frame
+    PhysicsQueryResult queryResult (gSystem.mMemoryMng.GetFrameHeapAllocator());
+    for (ProjectileRay& currRay: mProjectileRays)
+    {
+        TraceProjectileObjects(currRay, queryResult);
+    }
+}
+
+void PhysicsManager::TraceProjectileObjects(ProjectileRay& currRay, PhysicsQueryResult& queryResult)
+{
+    Projectile* projectile = currRay.mProjectile;
+    if (projectile->mHitSomething || projectile->IsMarkedForDeletion())
+        return;
+
+    // queries work in 2d, so objects on other floors are rejected by height
+    auto try_hit_body = [&currRay](PhysicsBody* physicsBody, const ContactPoint& hitPoint)
+    {
+        if (physicsBody->CheckFlags(PhysicsBodyFlags_Disabled) || physicsBody->mGameObject->IsMarkedForDeletion())
+            return false;
+
+        if (fabs(physicsBody->mPositionY - currRay.mPosition.y) > ProjectileHitMaxHeight)
+            return false;
+
+        return currRay.mProjectile->TryHitObject(physicsBody->mGameObject, hitPoint);
+    };
+
+    glm::vec2 origin (currRay.mPosition.x, currRay.mPosition.z);
+    glm::vec2 destination (currRay.mStepDestination.x, currRay.mStepDestination.z);
+    if (currRay.mMapHit.mHasHit)
+    {
+        destination = glm::vec2(currRay.mMapHit.mPosition.x, currRay.mMapHit.mPosition.z);
+    }
+
+    PhysicsQueryFilter queryFilter (CollisionGroup_Pedestrian | CollisionGroup_Car | CollisionGroup_Obstacle, eGameObjectClass_COUNT, projectile->mShooter);
+
+    // linecast does not report shapes which contain its start point, so check objects around muzzle first
+    if (currRay.mFirstStep)
+    {
+        currRay.mFirstStep = false;
+
+        float projectileSize = projectile->mWeaponInfo ? projectile->mWeaponInfo->mProjectileSize : 0.0f;
+        QueryObjectsWithinBox(origin, glm::vec2(projectileSize), queryFilter, queryResult);
+        for (const PhysicsQueryElement& currElement: queryResult)
+        {
+            ContactPoint hitPoint (origin, currRay.mPosition.y, -currRay.mDirection, 0.0f);
+            if (try_hit_body(currElement.mPhysicsObject, hitPoint))
+            {
+                destination = origin;
+                break;
+            }
+        }
+    }
+
+    if (!projectile->mHitSomething && (glm::distance2(origin, destination) > 0.0f))
+    {
+        QueryObjectsLinecast(origin, destination, queryFilter, queryResult);
+
+        // nearest hittable object
+        for (const PhysicsQueryElement& currElement: queryResult)
+        {
+            ContactPoint hitPoint (currElement.mIntersectionPoint, currRay.mPosition.y, currElement.mNormal, 0.0f);
+            if (try_hit_body(currElement.mPhysicsObject, hitPoint))
+            {
+                destination = currElement.mIntersectionPoint;
+                break;
+            }
+        }
+    }
+
+    if (!projectile->mHitSomething && currRay.mMapHit.mHasHit)
+    {
+        const MapRaycastHit& mapHit = currRay.mMapHit;
+
+        MapCollision mapCollision;
+        mapCollision.mThisObject = projectile;
+        mapCollision.mMapBlockInfo = gGame.mMap.GetBlockInfo(mapHit.mBlock.x, mapHit.mBlock.z, mapHit.mBlock.y);
+        mapCollision.mContactPoints[0] = ContactPoint(destination, currRay.mPosition.y, glm::vec2(mapHit.mNormal.x, mapHit.mNormal.z), 0.0f);
+        mapCollision.mContactPointsCount = 1;
+        projectile->HandleCollisionWithMap(mapCollision);
+    }
+
+    currRay.mDistanceLeft -= glm::distance(origin, destination);
+    currRay.mPosition = glm::vec3(destination.x, currRay.mPosition.y, destination.y);
+    MoveProjectile(projectile, currRay.mPosition);
+
+    if (!projectile->mHitSomething && (currRay.mDistanceLeft <= 0.0f))
+    {
+        projectile->MarkForDeletion();
+    }
+}
+
+void PhysicsManager::TraceProjectilesMap(int beginIndex, int endIndex)
+{
+    for (int iray = beginIndex; iray < endIndex; ++iray)
+    {
+        ProjectileRay& currRay = mProjectileRays[iray];
+
+        float stepDistance = std::min(currRay.mSpeed * mSimulationStepTime, std::max(currRay.mDistanceLeft, 0.0f));
+        glm::vec2 origin (currRay.mPosition.x, currRay.mPosition.z);
+        glm::vec2 destination = origin + currRay.mDirection * stepDistance;
+        currRay.mStepDestination = glm::vec3(destination.x, currRay.mPosition.y, destination.y);
+
+        // projectile hits only buildings on its own layer
+        int mapLayer = (int) (Convert::MetersToMapUnits(currRay.mPosition.y) + 0.5f);
+        GameMapRaycast::Raycast2D(gGame.mMap, origin, destination, mapLayer, currRay.mMapHit);
+    }
+}
+
+void PhysicsManager::MoveProjectile(Projectile* projectile, const glm::vec3& position)
+{
+    // same as physics transform sync, previous position is kept for interpolation
+    projectile->mPreviousTransform = projectile->mTransform;
+    projectile->mTransformSmooth = projectile->mTransform;
+    if (projectile->mTransform.mPosition == position)
+        return;
+
+    projectile->mTransform.mPosition = position;
+    projectile->RefreshDrawSprite();
+}
+
 void PhysicsManager::HandleFallingStarts(PhysicsBody* physicsBody)
 {
     if (physicsBody->mFalling)
@@ -775,3 +1997,54 @@ float PhysicsManager::GetSimulationStepTime() const
 {
     return mSimulationStepTime;
 }
+
+//////////////////////////////////////////////////////////////////////////
+
+void PhysicsManager::PedestriansLocomotionBatch::Clear()
+{
+    Resize(0);
+}
+
+void PhysicsManager::PedestriansLocomotionBatch::Resize(int elementsCount)
+{
+    mPedestrians.resize(elementsCount);
+    mHeading.resize(elementsCount);
+    mDesiredHeading.resize(elementsCount);
+    mTurnSpeed.resize(elementsCount);
+    mRotateToDesired.resize(elementsCount);
+    mMoveSpeed.resize(elementsCount);
+    mVelocityX.resize(elementsCount);
+    mVelocityY.resize(elementsCount);
+    mAngularVelocity.resize(elementsCount);
+}
+
+void PhysicsManager::VehiclesDynamicsBatch::Clear()
+{
+    Resize(0);
+}
+
+void PhysicsManager::VehiclesDynamicsBatch::Resize(int elementsCount)
+{
+    mVehicles.resize(elementsCount);
+    mMass.resize(elementsCount);
+    mInvMass.resize(elementsCount);
+    mInvInertia.resize(elementsCount);
+    mPositionX.resize(elementsCount);
+    mPositionY.resize(elementsCount);
+    mCenterX.resize(elementsCount);
+    mCenterY.resize(elementsCount);
+    mCos.resize(elementsCount);
+    mSin.resize(elementsCount);
+    mVelocityX.resize(elementsCount);
+    mVelocityY.resize(elementsCount);
+    mAngularVelocity.resize(elementsCount);
+    mFrontTireOffset.resize(elementsCount);
+    mRearTireOffset.resize(elementsCount);
+    mSteerCos.resize(elementsCount);
+    mSteerSin.resize(elementsCount);
+    mDriveForce.resize(elementsCount);
+    mReverseDriveForce.resize(elementsCount);
+    mForceX.resize(elementsCount);
+    mForceY.resize(elementsCount);
+    mTorque.resize(elementsCount);
+}
@@ -2,6 +2,8 @@
 
 #include "PhysicsDefs.h"
 #include "GameDefs.h"
+#include "Collision.h"
+#include "GameMapRaycast.h"
 
 // note that the physics only works with meter units (Mt) not map units
 
@@ -29,30 +31,74 @@ public:
 
     void DestroyBody(PhysicsBody* physicsBody);
 
+    // Add or remove projectile from projectiles list, projectiles does not have box2d bodies
+    // they are moved each simulation step by ray marching against map blocks and objects
+    // @param projectile: Projectile object, cannot be null
+    void RegisterProjectile(Projectile* projectile);
+    void UnregisterProjectile(Projectile* projectile);
+
+    // Measure batched cars tire forces against per car simulation step, results are printed to log
+    // Missing cars are spawned temporarily to get required number
+    // @param numCars: Number of cars
+    void RunVehiclesDynamicsBenchmark(int numCars);
+
+    // Measure batched pedestrians locomotion against per pedestrian simulation step, results are printed to log
+    // Missing pedestrians are spawned temporarily to get required number, warns if batched step is over 2 ms
+    // @param numPeds: Number of pedestrians
+    void RunPedestriansLocomotionBenchmark(int numPeds);
+
+    // Check that projectile spawned inside adjacent pedestrian hits it, result is printed to log
+    // Shooter and target are spawned temporarily, other projectiles are not advanced
+    void RunPointBlankProjectileTest();
+
     // query physics objects
     // note that depth is ignored so pointA and pointB has only 2 components
+    // map is ignored, objects are not allowed to be created or destroyed within query proc
     // @param pointA, pointB: Line of intersect points
-    // @param aaboxCenter, aabboxExtents: AABBox area of intersections
-    // @param outputResult: Output objects
-    void QueryObjectsLinecast(const glm::vec2& pointA, const glm::vec2& pointB, PhysicsQueryResult& outputResult, CollisionGroup collisionMask) const;
-    void QueryObjectsWithinBox(const glm::vec2& center, const glm::vec2& extents, PhysicsQueryResult& outputResult, CollisionGroup collisionMask) const;
+    // @param center, extents: AABBox area of intersections
+    // @param queryFilter: Objects filter
+    // @param queryProc: Receives objects in arbitrary order, body with multiple colliders might be reported multiple times
+    // @param outputResult: Output objects without duplicates, linecast results are sorted by distance from pointA
+    void QueryObjectsLinecast(const glm::vec2& pointA, const glm::vec2& pointB, const PhysicsQueryFilter& queryFilter, const PhysicsQueryProc& queryProc) const;
+    void QueryObjectsLinecast(const glm::vec2& pointA, const glm::vec2& pointB, const PhysicsQueryFilter& queryFilter, PhysicsQueryResult& outputResult) const;
+    void QueryObjectsWithinBox(const glm::vec2& center, const glm::vec2& extents, const PhysicsQueryFilter& queryFilter, const PhysicsQueryProc& queryProc) const;
+    void QueryObjectsWithinBox(const glm::vec2& center, const glm::vec2& extents, const PhysicsQueryFilter& queryFilter, PhysicsQueryResult& outputResult) const;
+
+    // Get contacts of body registered on last or previous simulation step
+    // contacts are registered only between objects that does not collide physically
+    // @param physicsBody: Physics body, cannot be null
+    ContactsList GetContacts(const PhysicsBody* physicsBody) const;
+    ContactsList GetPreviousContacts(const PhysicsBody* physicsBody) const;
 
 private:
+    struct CollisionEvent;
+    struct ProjectileRay;
+
     // override b2ContactListener
     void BeginContact(b2Contact* contact) override;
     void EndContact(b2Contact* contact) override;
     void PreSolve(b2Contact* contact, const b2Manifold* oldManifold) override;
     void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse) override;
 
+    // Test whether fixture passes query filter
+    // @returns physics body of fixture or null if fixture is filtered out
+    PhysicsBody* FilterQueryFixture(b2Fixture* fixture, const PhysicsQueryFilter& queryFilter) const;
+
+    // Precompute objects collision decisions for all classes and states pairs
+    void InitObjectsCollisionTable();
+    int GetObjectCollisionState(GameObject* gameObject) const;
+
     bool ShouldCollide_ObjectWithMap(b2Contact* contact, b2Fixture* objectFixture, b2Fixture* mapFixture) const;
-    bool ShouldCollide_Objects(b2Contact* contact, b2Fixture* fixtureA, b2Fixture* fixtureB) const;
+    bool ShouldCollide_Objects(b2Contact* contact, b2Fixture* fixtureA, b2Fixture* fixtureB);
 
-    void HandleCollision_ObjectWithMap(b2Fixture* objectFixture, b2Fixture* mapFixture, b2Contact* contact, const b2ContactImpulse* impulse);
-    void HandleCollision_Objects(b2Fixture* fixtureA, b2Fixture* fixtureB, b2Contact* contact, const b2ContactImpulse* impulse);
+    // Register contact impulse applied during simulation step, events are dispatched after step
+    // @param objectFixture: Game object collider
+    // @param otherFixture: Other game object collider or map block
+    void QueueCollisionEvent(b2Fixture* objectFixture, b2Fixture* otherFixture, bool isMapCollision, b2Contact* contact, const b2ContactImpulse* impulse);
 
     // collision handlers
-    void HandleCollision_CarVsCar(Vehicle* carA, Vehicle* carB, b2Contact* contact, const b2ContactImpulse* impulse);
-    void HandleCollision_CarVsMap(Vehicle* car, b2Contact* contact, const b2ContactImpulse* impulse);
+    void HandleCollision_CarVsCar(Vehicle* carA, Vehicle* carB, const CollisionEvent& collisionEvent, const glm::vec2& contactPoint);
+    void HandleCollision_CarVsMap(Vehicle* car, const CollisionEvent& collisionEvent, const glm::vec2& contactPoint);
 
     // create level map body, used internally
     void CreateMapCollisionShape();
@@ -61,27 +107,148 @@ private:
     void ProcessSimulationStep();
     void UpdateHeightPosition(PhysicsBody* physicsBody);
 
+    // Switch distant cars and pedestrians to simplified simulation and nearby back to box2d
+    void UpdateSimulationLod();
+    bool CanUseSimplifiedSimulation(PhysicsBody* physicsBody) const;
+
+    // Move body without box2d using its current velocities, map blocks are still solid
+    void IntegrateSimplifiedBody(PhysicsBody* physicsBody);
+
+    // Batched cars tire forces, same math as in Vehicle::SimulationStep but for all cars at once
+    void GatherVehicleDynamics(Vehicle* vehicle);
+    void ComputeVehiclesDynamics(int beginIndex, int endIndex);
+    void ScatterVehiclesDynamics();
+    void ProcessVehiclesDynamics();
+
+    // Batched walking and turning of idle pedestrians, same math as in Pedestrian::SimulationStep
+    // Pedestrians in other states or with contacts are processed by their own simulation step
+    bool CanUseBatchedLocomotion(Pedestrian* pedestrian) const;
+    void GatherPedestrianLocomotion(Pedestrian* pedestrian);
+    void ComputePedestriansLocomotion(int beginIndex, int endIndex);
+    void ScatterPedestriansLocomotion();
+    void ProcessPedestriansLocomotion();
+
+    // Merge collision events of same objects pair into single event, keeps max impulse and contact points centroid
+    void CoalesceCollisionEvents();
     void DispatchCollisionEvents();
 
+    // Sort contacts registered during simulation step by objects and swap contacts arenas
+    void BuildContactsArena();
+    void DispatchContactEvents();
+    // Remove contacts with other object from body contacts range
+    void RemoveContactsWithObject(int arenaIndex, PhysicsBody* physicsBody, GameObject* otherObject);
+
+    // Advance projectiles and dispatch hits, map blocks are traced on worker threads
+    void ProcessProjectiles();
+    void TraceProjectilesMap(int beginIndex, int endIndex);
+    void TraceProjectileObjects(ProjectileRay& currRay, PhysicsQueryResult& queryResult);
+    void MoveProjectile(Projectile* projectile, const glm::vec3& position);
+
     void HandleFallingStarts(PhysicsBody* physicsBody);
     void HandleFallsOnGround(PhysicsBody* physicsBody);
     void HandleFallsOnWater(PhysicsBody* physicsBody);
 
 private:
 
+    // how pair of objects interacts when their colliders are touching
+    enum eObjectsCollision: unsigned char
+    {
+        eObjectsCollision_None, // ignored
+        eObjectsCollision_Contact, // contact is registered but not resolved
+        eObjectsCollision_Response, // collision is resolved physically
+    };
+
+    // object state affecting collision decision
+    enum
+    {
+        ObjectCollisionState_Regular,
+        ObjectCollisionState_CrowdAgent, // ai pedestrian kept apart from others by crowd avoidance
+        ObjectCollisionStatesCount
+    };
+
+    // collision between objects pair or object and map, coalesced over all contacts within simulation step
     struct CollisionEvent
     {
     public:
         CollisionEvent() = default;
 
-        // object vs map
-        const MapBlockInfo* mMapBlockInfo = nullptr;
-        // object vs object
-        b2Fixture* mBox2FixtureA = nullptr;
-        b2Fixture* mBox2FixtureB = nullptr;
-        // common
-        b2Contact* mBox2Contact = nullptr;
-        b2ContactImpulse mBox2Impulse;
+        GameObject* mObjectA = nullptr;
+        GameObject* mObjectB = nullptr; // null if object vs map
+        b2Fixture* mBox2FixtureA = nullptr; // object A collider
+        b2Fixture* mBox2FixtureB = nullptr; // object B collider or map block
+        float mContactImpulse = 0.0f; // max total impulse of single contact
+        float mPointImpulse = 0.0f; // max impulse of single contact point
+        glm::vec2 mContactPointsSum {0.0f, 0.0f};
+        int mContactPointsCount = 0;
+        glm::vec2 mNormal {0.0f, 0.0f}; // normal of strongest contact
+        float mSeparation = 0.0f; // separation of strongest contact
+    };
+
+    // projectile moved by ray marching
+    struct ProjectileRay
+    {
+    public:
+        ProjectileRay() = default;
+
+        Projectile* mProjectile = nullptr;
+        glm::vec3 mPosition; // meters
+        glm::vec2 mDirection;
+        float mSpeed = 0.0f; // meters per second
+        float mDistanceLeft = 0.0f; // meters before projectile disappears
+        bool mFirstStep = true; // projectile might be spawned inside object
+        // current step
+        glm::vec3 mStepDestination;
+        MapRaycastHit mMapHit;
+    };
+
+    // cars state for batched tire forces computation, structure of arrays
+    struct VehiclesDynamicsBatch
+    {
+    public:
+        VehiclesDynamicsBatch() = default;
+        void Clear();
+        void Resize(int elementsCount);
+        inline int GetElementsCount() const { return (int) mVehicles.size(); }
+
+        std::vector<Vehicle*> mVehicles;
+        // body
+        std::vector<float> mMass;
+        std::vector<float> mInvMass;
+        std::vector<float> mInvInertia;
+        std::vector<float> mPositionX, mPositionY; // body origin
+        std::vector<float> mCenterX, mCenterY; // center of mass, world space
+        std::vector<float> mCos, mSin; // body rotation
+        std::vector<float> mVelocityX, mVelocityY; // updated with impulses
+        std::vector<float> mAngularVelocity; // updated with impulses
+        // tires
+        std::vector<float> mFrontTireOffset;
+        std::vector<float> mRearTireOffset;
+        std::vector<float> mSteerCos, mSteerSin; // front tire rotation
+        std::vector<float> mDriveForce; // signed engine force along rear tire if moving forward
+        std::vector<float> mReverseDriveForce; // signed engine force along rear tire if standing or moving backward
+        // output
+        std::vector<float> mForceX, mForceY;
+        std::vector<float> mTorque;
+    };
+
+    // idle pedestrians state for batched locomotion, structure of arrays
+    struct PedestriansLocomotionBatch
+    {
+    public:
+        PedestriansLocomotionBatch() = default;
+        void Clear();
+        void Resize(int elementsCount);
+        inline int GetElementsCount() const { return (int) mPedestrians.size(); }
+
+        std::vector<Pedestrian*> mPedestrians;
+        std::vector<float> mHeading; // body rotation, radians
+        std::vector<float> mDesiredHeading; // degrees, used if rotates to desired angle
+        std::vector<float> mTurnSpeed; // signed turn speed, degrees per second, used if not rotates to desired angle
+        std::vector<unsigned char> mRotateToDesired;
+        std::vector<float> mMoveSpeed; // signed speed along heading
+        // output
+        std::vector<float> mVelocityX, mVelocityY;
+        std::vector<float> mAngularVelocity; // degrees per second
     };
 
 private:
@@ -96,4 +263,17 @@ private:
     std::vector<PhysicsBody*> mBodiesList;
 
     std::vector<CollisionEvent> mObjectsCollisionList;
+
+    std::vector<Contact> mPendingContacts; // registered during simulation step
+    std::vector<Contact> mContactsArenas[2]; // contacts grouped by objects, current and previous step
+    int mCurrentContactsArena = 0;
+    bool mContactEventsDispatchInProgress = false; // bodies cannot be destroyed from contact handlers
+
+    std::vector<ProjectileRay> mProjectileRays; // packed, projectile keeps its index
+
+    // class and state of object A, class and state of object B
+    eObjectsCollision mObjectsCollisionTable[eGameObjectClass_COUNT][ObjectCollisionStatesCount][eGameObjectClass_COUNT][ObjectCollisionStatesCount];
+
+    VehiclesDynamicsBatch mVehiclesDynamics;
+    PedestriansLocomotionBatch mPedestriansLocomotion;
 };
\ No newline at end of file
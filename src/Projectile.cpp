@@ -13,22 +13,11 @@ void Projectile::HandleSpawn()
 {
     cxx_assert(mWeaponInfo);
 
-    mStartPosition = mTransform.mPosition;
     mDrawSpriteOrientation = eSpriteOrientation_N;
 
     mRemapClut = 0;
 
-    PhysicsBody* projectilePhysics = gGame.mPhysicsMng.CreateBody(this, PhysicsBodyFlags_Bullet | PhysicsBodyFlags_FixRotation | PhysicsBodyFlags_NoGravity);
-    cxx_assert(projectilePhysics);
-
-    CollisionShape shapeData;
-    shapeData.SetAsCircle(mWeaponInfo ? mWeaponInfo->mProjectileSize : 0.1f);
-    PhysicsMaterial shapeMaterial;
-    Collider* collisionShape = projectilePhysics->AddCollider(0, shapeData, shapeMaterial, CollisionGroup_Projectile, 
-        CollisionGroup_Pedestrian | CollisionGroup_Car | CollisionGroup_Obstacle | CollisionGroup_MapBlock, ColliderFlags_None);
-    cxx_assert(collisionShape);
-
-    SetPhysics(projectilePhysics);
+    gGame.mPhysicsMng.RegisterProjectile(this);
 
     // setup animation
     mAnimationState.Clear();
@@ -56,71 +45,42 @@ void Projectile::HandleSpawn()
     ClearCurrentHit();
 }
 
-void Projectile::SimulationStep()
+void Projectile::HandleDespawn()
 {
-    cxx_assert(mPhysicsBody);
+    gGame.mPhysicsMng.UnregisterProjectile(this);
 
-    if (mHitObject)
-    {
-        mPhysicsBody->ClearForces(); // stop
-        return;
-    }
+    GameObject::HandleDespawn();
+}
 
-    if (mWeaponInfo == nullptr)
-    {
-        cxx_assert(false);
-        return;
-    }
+bool Projectile::TryHitObject(GameObject* gameObject, const ContactPoint& hitPoint)
+{
+    if (mHitSomething || (mWeaponInfo == nullptr))
+        return false;
 
-    // setup physics
-    glm::vec2 velocity = mTransform.GetDirectionVector();
-    mPhysicsBody->SetLinearVelocity(velocity * mWeaponInfo->mProjectileSpeed);
+    if (gameObject->IsPedestrianClass())
+    {
+        Pedestrian* otherPedestrian = (Pedestrian*) gameObject;
+        if (mShooter && (mShooter == otherPedestrian)) // ignore shooter ped
+            return false;
 
-    glm::vec2 currPosition = mTransform.GetPosition2();
-    glm::vec2 startPosition(mStartPosition.x, mStartPosition.z);
+        if (otherPedestrian->IsDead() || otherPedestrian->IsAttachedToObject())
+            return false;
 
-    if (glm::distance(startPosition, currPosition) >= mWeaponInfo->mBaseHitRange)
-    {
-        MarkForDeletion();
+        if (mWeaponInfo->IsFireDamage() && otherPedestrian->IsBurn())
+            return false;
     }
 
-    // inspect current contacts
-    for (const Contact& currContact: mObjectsContacts)
+    if (gameObject->IsVehicleClass())
     {
-        if (!currContact.HasContactPoints())
-            continue;
-
-        if (currContact.mThatObject->IsPedestrianClass())
-        {
-            Pedestrian* otherPedestrian = (Pedestrian*) currContact.mThatObject;
-            if (mShooter && (mShooter == otherPedestrian)) // ignore shooter ped
-                continue;
-
-            if (otherPedestrian->IsDead() || otherPedestrian->IsAttachedToObject())
-                continue;
-
-            if (mWeaponInfo->IsFireDamage() && otherPedestrian->IsBurn())
-                continue;
-        }
-
-        if (currContact.mThatObject->IsVehicleClass())
-        {
-            Vehicle* otherCar = (Vehicle*) currContact.mThatObject;
-            if (mWeaponInfo->IsFireDamage() && otherCar->IsWrecked())
-                continue;
-        }
-
-        mHitSomething = true;
-        mHitObject = currContact.mThatObject;
-        mHitPoint = currContact.mContactPoints[0]; // get first contact point
-        break;
+        Vehicle* otherCar = (Vehicle*) gameObject;
+        if (mWeaponInfo->IsFireDamage() && otherCar->IsWrecked())
+            return false;
     }
-}
 
-bool Projectile::ShouldCollide(GameObject* otherObject) const
-{
-    // disable collision resolving
-    return false;
+    mHitSomething = true;
+    mHitObject = gameObject;
+    mHitPoint = hitPoint;
+    return true;
 }
 
 void Projectile::HandleCollisionWithMap(const MapCollision& collision)
@@ -197,7 +157,7 @@ void Projectile::DebugDraw(DebugRenderer& debugRender)
 {   
     if (mWeaponInfo)
     {
-        cxx::bounding_sphere_t bsphere (mPhysicsBody->GetPosition(), mWeaponInfo->mProjectileSize);
+        cxx::bounding_sphere_t bsphere (mTransform.mPosition, mWeaponInfo->mProjectileSize);
         debugRender.DrawSphere(bsphere, Color32_Orange, false);
     }
 }
@@ -4,9 +4,11 @@
 #include "GameObject.h"
 #include "PhysicsBody.h"
 
+// projectile does not have physics body, it is moved by physics manager along with other projectiles
 class Projectile final: public GameObject
 {
     friend class GameObjectsManager;
+    friend class PhysicsManager;
 
 public:
     // readonly
@@ -18,20 +20,23 @@ public:
 
     // override GameObject
     void UpdateFrame() override;
-    void SimulationStep() override;
     void DebugDraw(DebugRenderer& debugRender) override;
     void HandleSpawn() override;
-    bool ShouldCollide(GameObject* otherObject) const override;
+    void HandleDespawn() override;
     void HandleCollisionWithMap(const MapCollision& collision) override;
 
 private:
     void ClearCurrentHit();
+    // Register hit if object can be hit by projectile
+    // @returns false if object should be passed through
+    bool TryHitObject(GameObject* gameObject, const ContactPoint& hitPoint);
 
 private:
     SpriteAnimation mAnimationState;
-    glm::vec3 mStartPosition;
 
     bool mHitSomething = false;
     GameObjectHandle mHitObject; // null if hit wall
     ContactPoint mHitPoint;
+
+    int mProjectileRayIndex = -1; // index in physics manager projectiles list
 };
\ No newline at end of file
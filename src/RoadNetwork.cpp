@@ -0,0 +1,457 @@
+#include "stdafx.h"
+#include "RoadNetwork.h"
+#include "GameMap.h"
+#include "DebugRenderer.h"
+#include "GtaOneGame.h"
+
+//////////////////////////////////////////////////////////////////////////
+
+// straight directions in order of directions mask bits
+static const eMapDirection2D RoadDirections[] =
+{
+    eMapDirection2D_N,
+    eMapDirection2D_E,
+    eMapDirection2D_S,
+    eMapDirection2D_W,
+};
+
+static const Point RoadDirectionOffsets[] =
+{
+    { 0, -1}, // N
+    { 1,  0}, // E
+    { 0,  1}, // S
+    {-1,  0}, // W
+};
+
+const int NumRoadDirections = CountOf(RoadDirections);
+
+inline eMapDirection2D GetRoadDirectionBetween(const RoadBlock& blockA, const RoadBlock& blockB)
+{
+    if (blockB.mX > blockA.mX) return eMapDirection2D_E;
+    if (blockB.mX < blockA.mX) return eMapDirection2D_W;
+    if (blockB.mZ > blockA.mZ) return eMapDirection2D_S;
+    return eMapDirection2D_N;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+void RoadNetwork::BuildFromMap(const GameMap& gameMap)
+{
+    Cleanup();
+
+    double startTime = gSystem.GetSystemSeconds();
+
+    mBlockRefs.resize(MAP_DIMENSIONS * MAP_DIMENSIONS);
+
+    // collect top surface road blocks
+    std::vector<RoadCell> roadCells(MAP_DIMENSIONS * MAP_DIMENSIONS);
+    for (int coordz = 0; coordz < MAP_DIMENSIONS; ++coordz)
+    for (int coordx = 0; coordx < MAP_DIMENSIONS; ++coordx)
+    {
+        for (int layer = (MAP_LAYERS_COUNT - 1); layer > -1; --layer)
+        {
+            const MapBlockInfo* mapBlock = gameMap.GetBlockInfo(coordx, coordz, layer);
+            if (mapBlock->mGroundType == eGroundType_Air)
+                continue;
+
+            if (mapBlock->mGroundType == eGroundType_Road)
+            {
+                RoadCell& roadCell = roadCells[GetBlockRefIndex(coordx, coordz)];
+                roadCell.mDirections =
+                    (mapBlock->mUpDirection ? BIT(0) : 0) |
+                    (mapBlock->mRightDirection ? BIT(1) : 0) |
+                    (mapBlock->mDownDirection ? BIT(2) : 0) |
+                    (mapBlock->mLeftDirection ? BIT(3) : 0);
+
+                if (roadCell.mDirections)
+                {
+                    roadCell.mLayer = layer;
+                    if (mapBlock->mIsRailway)
+                    {
+                        roadCell.mFlags = roadCell.mFlags | RoadEdgeFlags_Railway;
+                    }
+                    if (mapBlock->mTrafficHint == eTrafficHint_TrafficLights)
+                    {
+                        roadCell.mFlags = roadCell.mFlags | RoadEdgeFlags_TrafficLights;
+                    }
+                }
+            }
+            break;
+        }
+    }
+
+    // count incoming connections
+    for (int icell = 0, NumCells = (int) roadCells.size(); icell < NumCells; ++icell)
+    {
+        for (int idirection = 0; idirection < NumRoadDirections; ++idirection)
+        {
+            int nextCell = GetNextRoadCell(roadCells, icell, idirection);
+            if (nextCell != -1)
+            {
+                ++roadCells[nextCell].mIncomingCount;
+            }
+        }
+    }
+
+    // everything except of simple lane blocks with single entry and single exit becomes node
+    for (int icell = 0, NumCells = (int) roadCells.size(); icell < NumCells; ++icell)
+    {
+        const RoadCell& roadCell = roadCells[icell];
+        if (roadCell.mLayer == -1)
+            continue;
+
+        int outgoingCount = 0;
+        for (int idirection = 0; idirection < NumRoadDirections; ++idirection)
+        {
+            if (GetNextRoadCell(roadCells, icell, idirection) != -1)
+            {
+                ++outgoingCount;
+            }
+        }
+
+        if (outgoingCount == 1 && roadCell.mIncomingCount == 1)
+            continue;
+
+        mBlockRefs[icell].mNodeIndex = (int) mNodes.size();
+        mNodes.emplace_back();
+
+        RoadNode& roadNode = mNodes.back();
+        roadNode.mBlock.mX = (unsigned char) (icell % MAP_DIMENSIONS);
+        roadNode.mBlock.mZ = (unsigned char) (icell / MAP_DIMENSIONS);
+        roadNode.mBlock.mLayer = (unsigned char) roadCell.mLayer;
+        roadNode.mFlags = roadCell.mFlags;
+    }
+
+    for (int inode = 0, NumNodes = (int) mNodes.size(); inode < NumNodes; ++inode)
+    {
+        TraceEdges(inode, roadCells);
+    }
+
+    // lane blocks that are not reachable from any node are closed loops, break them with extra node
+    for (int icell = 0, NumCells = (int) roadCells.size(); icell < NumCells; ++icell)
+    {
+        const RoadCell& roadCell = roadCells[icell];
+        if (roadCell.mLayer == -1)
+            continue;
+
+        const BlockRef& blockRef = mBlockRefs[icell];
+        if (blockRef.mNodeIndex != -1 || blockRef.mEdgeIndex != -1)
+            continue;
+
+        int nodeIndex = (int) mNodes.size();
+        mBlockRefs[icell].mNodeIndex = nodeIndex;
+        mNodes.emplace_back();
+
+        RoadNode& roadNode = mNodes.back();
+        roadNode.mBlock.mX = (unsigned char) (icell % MAP_DIMENSIONS);
+        roadNode.mBlock.mZ = (unsigned char) (icell / MAP_DIMENSIONS);
+        roadNode.mBlock.mLayer = (unsigned char) roadCell.mLayer;
+        roadNode.mFlags = roadCell.mFlags;
+
+        TraceEdges(nodeIndex, roadCells);
+    }
+
+    double buildTime = gSystem.GetSystemSeconds() - startTime;
+    gSystem.LogMessage(eLogMessage_Info, "Road network: %d nodes, %d edges, %d lane blocks (%.2f ms)",
+        (int) mNodes.size(), (int) mEdges.size(), (int) mLaneBlocks.size(), buildTime * 1000.0);
+}
+
+void RoadNetwork::Cleanup()
+{
+    mNodes.clear();
+    mEdges.clear();
+    mLaneBlocks.clear();
+    mBlockRefs.clear();
+}
+
+int RoadNetwork::GetNextRoadCell(const std::vector<RoadCell>& roadCells, int cellIndex, int directionIndex) const
+{
+    const RoadCell& roadCell = roadCells[cellIndex];
+    if (roadCell.mLayer == -1 || (roadCell.mDirections & BIT(directionIndex)) == 0)
+        return -1;
+
+    int coordx = (cellIndex % MAP_DIMENSIONS) + RoadDirectionOffsets[directionIndex].x;
+    int coordz = (cellIndex / MAP_DIMENSIONS) + RoadDirectionOffsets[directionIndex].y;
+    if (coordx < 0 || coordx >= MAP_DIMENSIONS || coordz < 0 || coordz >= MAP_DIMENSIONS)
+        return -1;
+
+    int nextCellIndex = GetBlockRefIndex(coordx, coordz);
+
+    const RoadCell& nextCell = roadCells[nextCellIndex];
+    if (nextCell.mLayer == -1 || abs(nextCell.mLayer - roadCell.mLayer) > 1)
+        return -1;
+
+    return nextCellIndex;
+}
+
+void RoadNetwork::TraceEdges(int nodeIndex, const std::vector<RoadCell>& roadCells)
+{
+    const RoadBlock nodeBlock = mNodes[nodeIndex].mBlock;
+    const int nodeCellIndex = GetBlockRefIndex(nodeBlock.mX, nodeBlock.mZ);
+
+    mNodes[nodeIndex].mFirstEdge = (int) mEdges.size();
+    mNodes[nodeIndex].mEdgesCount = 0;
+
+    for (int idirection = 0; idirection < NumRoadDirections; ++idirection)
+    {
+        int currCellIndex = GetNextRoadCell(roadCells, nodeCellIndex, idirection);
+        if (currCellIndex == -1)
+            continue;
+
+        int edgeIndex = (int) mEdges.size();
+        mEdges.emplace_back();
+
+        RoadEdge& roadEdge = mEdges.back();
+        roadEdge.mStartNode = nodeIndex;
+        roadEdge.mStartDirection = RoadDirections[idirection];
+        roadEdge.mEndDirection = RoadDirections[idirection];
+        roadEdge.mFirstBlock = (int) mLaneBlocks.size();
+        roadEdge.mLayer = nodeBlock.mLayer;
+
+        int prevLayer = nodeBlock.mLayer;
+        for (;;)
+        {
+            const RoadCell& currCell = roadCells[currCellIndex];
+            roadEdge.mFlags = roadEdge.mFlags | currCell.mFlags;
+            if (currCell.mLayer != prevLayer)
+            {
+                roadEdge.mFlags = roadEdge.mFlags | RoadEdgeFlags_Slope;
+            }
+            prevLayer = currCell.mLayer;
+
+            BlockRef& blockRef = mBlockRefs[currCellIndex];
+            if (blockRef.mNodeIndex != -1)
+            {
+                roadEdge.mEndNode = blockRef.mNodeIndex;
+                break;
+            }
+
+            // lane block has single entry so it belongs to one edge only
+            cxx_assert(blockRef.mEdgeIndex == -1);
+            blockRef.mEdgeIndex = edgeIndex;
+            blockRef.mBlockIndex = roadEdge.mBlocksCount++;
+
+            RoadBlock laneBlock;
+            laneBlock.mX = (unsigned char) (currCellIndex % MAP_DIMENSIONS);
+            laneBlock.mZ = (unsigned char) (currCellIndex / MAP_DIMENSIONS);
+            laneBlock.mLayer = (unsigned char) currCell.mLayer;
+            mLaneBlocks.push_back(laneBlock);
+
+            // lane block has single exit
+            int nextCellIndex = -1;
+            for (int inextDirection = 0; inextDirection < NumRoadDirections; ++inextDirection)
+            {
+                nextCellIndex = GetNextRoadCell(roadCells, currCellIndex, inextDirection);
+                if (nextCellIndex != -1)
+                {
+                    roadEdge.mEndDirection = RoadDirections[inextDirection];
+                    break;
+                }
+            }
+            cxx_assert(nextCellIndex != -1);
+            currCellIndex = nextCellIndex;
+        }
+        ++mNodes[nodeIndex].mEdgesCount;
+    }
+}
+
+void RoadNetwork::DebugDraw(DebugRenderer& debugRender)
+{
+    const cxx::aabbox2d_t& onScreenArea = gGame.mCamera.mOnScreenMapArea;
+
+    auto get_block_center = [](const RoadBlock& roadBlock)
+    {
+        return Convert::MapUnitsToMeters(glm::vec3(roadBlock.mX + 0.5f, roadBlock.mLayer + 0.1f, roadBlock.mZ + 0.5f));
+    };
+
+    for (const RoadEdge& currEdge: mEdges)
+    {
+        const RoadNode& startNode = mNodes[currEdge.mStartNode];
+        const RoadNode& endNode = mNodes[currEdge.mEndNode];
+
+        Color32 edgeColor = Color32_Green;
+        if (currEdge.mFlags & RoadEdgeFlags_Railway)
+        {
+            edgeColor = Color32_Brown;
+        }
+        else if (currEdge.mFlags & RoadEdgeFlags_TrafficLights)
+        {
+            edgeColor = Color32_Yellow;
+        }
+
+        glm::vec3 prevPoint = get_block_center(startNode.mBlock);
+        for (int iblock = 0; iblock <= currEdge.mBlocksCount; ++iblock)
+        {
+            const RoadBlock& currBlock = (iblock < currEdge.mBlocksCount) ? mLaneBlocks[currEdge.mFirstBlock + iblock] : endNode.mBlock;
+            glm::vec3 currPoint = get_block_center(currBlock);
+            if (onScreenArea.contains(glm::vec2(currPoint.x, currPoint.z)))
+            {
+                debugRender.DrawLine(prevPoint, currPoint, edgeColor, false);
+            }
+            prevPoint = currPoint;
+        }
+    }
+
+    for (const RoadNode& currNode: mNodes)
+    {
+        glm::vec3 nodePoint = get_block_center(currNode.mBlock);
+        if (onScreenArea.contains(glm::vec2(nodePoint.x, nodePoint.z)))
+        {
+            debugRender.DrawSphere(nodePoint, 0.1f, (currNode.mEdgesCount > 0) ? Color32_Cyan : Color32_Red, false);
+        }
+    }
+}
+
+bool RoadNetwork::GetLocationAtBlock(int coordx, int coordz, RoadLocation& outLocation) const
+{
+    outLocation = RoadLocation();
+
+    if (mBlockRefs.empty() || coordx < 0 || coordx >= MAP_DIMENSIONS || coordz < 0 || coordz >= MAP_DIMENSIONS)
+        return false;
+
+    const BlockRef& blockRef = mBlockRefs[GetBlockRefIndex(coordx, coordz)];
+    if (blockRef.mEdgeIndex != -1)
+    {
+        outLocation.mEdgeIndex = blockRef.mEdgeIndex;
+        outLocation.mBlockIndex = blockRef.mBlockIndex;
+        return true;
+    }
+
+    if (blockRef.mNodeIndex != -1)
+    {
+        const RoadNode& roadNode = mNodes[blockRef.mNodeIndex];
+        if (roadNode.mEdgesCount > 0)
+        {
+            outLocation.mEdgeIndex = roadNode.mFirstEdge;
+            outLocation.mBlockIndex = -1;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RoadNetwork::FindNearestLane(const glm::vec2& position, int searchRadius, RoadLocation& outLocation) const
+{
+    outLocation = RoadLocation();
+
+    glm::vec2 mapPosition = Convert::MetersToMapUnits(position);
+    int centerx = (int) floorf(mapPosition.x);
+    int centerz = (int) floorf(mapPosition.y);
+
+    float bestDistance2 = FLT_MAX;
+
+    auto check_block = [&](int coordx, int coordz)
+    {
+        RoadLocation blockLocation;
+        if (!GetLocationAtBlock(coordx, coordz, blockLocation))
+            return;
+
+        float distance2 = glm::distance2(mapPosition, glm::vec2(coordx + 0.5f, coordz + 0.5f));
+        if (distance2 < bestDistance2)
+        {
+            bestDistance2 = distance2;
+            outLocation = blockLocation;
+        }
+    };
+
+    for (int iradius = 0; iradius <= searchRadius; ++iradius)
+    {
+        // blocks of next rings are farther than found one
+        if (!outLocation.IsNull())
+        {
+            float ringDistance = std::max(iradius - 0.5f, 0.0f);
+            if ((ringDistance * ringDistance) > bestDistance2)
+                break;
+        }
+
+        if (iradius == 0)
+        {
+            check_block(centerx, centerz);
+            continue;
+        }
+
+        for (int offset = -iradius; offset <= iradius; ++offset)
+        {
+            check_block(centerx + offset, centerz - iradius);
+            check_block(centerx + offset, centerz + iradius);
+        }
+        for (int offset = -iradius + 1; offset < iradius; ++offset)
+        {
+            check_block(centerx - iradius, centerz + offset);
+            check_block(centerx + iradius, centerz + offset);
+        }
+    }
+    return !outLocation.IsNull();
+}
+
+int RoadNetwork::GetNextEdge(int edgeIndex, eMapDirection2D direction) const
+{
+    cxx_assert(edgeIndex > -1 && edgeIndex < (int) mEdges.size());
+
+    const RoadNode& endNode = mNodes[mEdges[edgeIndex].mEndNode];
+    for (int iedge = endNode.mFirstEdge, EndEdge = endNode.mFirstEdge + endNode.mEdgesCount; iedge < EndEdge; ++iedge)
+    {
+        if (mEdges[iedge].mStartDirection == direction)
+            return iedge;
+    }
+    return -1;
+}
+
+int RoadNetwork::GetRandomSuccessor(int edgeIndex, cxx::randomizer& random) const
+{
+    cxx_assert(edgeIndex > -1 && edgeIndex < (int) mEdges.size());
+
+    const RoadEdge& roadEdge = mEdges[edgeIndex];
+    const RoadNode& endNode = mNodes[roadEdge.mEndNode];
+    if (endNode.mEdgesCount == 0)
+        return -1;
+
+    eMapDirection2D uturnDirection = GetStraightMapDirectionOpposite(roadEdge.mEndDirection);
+
+    int uturnEdge = -1;
+    int candidateEdges[NumRoadDirections];
+    int candidatesCount = 0;
+    for (int iedge = endNode.mFirstEdge, EndEdge = endNode.mFirstEdge + endNode.mEdgesCount; iedge < EndEdge; ++iedge)
+    {
+        if (mEdges[iedge].mStartDirection == uturnDirection)
+        {
+            uturnEdge = iedge;
+            continue;
+        }
+        candidateEdges[candidatesCount++] = iedge;
+    }
+
+    if (candidatesCount == 0)
+        return uturnEdge;
+
+    return candidateEdges[random.generate_int(candidatesCount - 1)];
+}
+
+RoadBlock RoadNetwork::GetLocationBlock(const RoadLocation& location) const
+{
+    cxx_assert(!location.IsNull());
+
+    const RoadEdge& roadEdge = mEdges[location.mEdgeIndex];
+    if (location.mBlockIndex == -1)
+        return mNodes[roadEdge.mStartNode].mBlock;
+
+    cxx_assert(location.mBlockIndex < roadEdge.mBlocksCount);
+    return mLaneBlocks[roadEdge.mFirstBlock + location.mBlockIndex];
+}
+
+eMapDirection2D RoadNetwork::GetLocationDirection(const RoadLocation& location) const
+{
+    cxx_assert(!location.IsNull());
+
+    const RoadEdge& roadEdge = mEdges[location.mEdgeIndex];
+    if (location.mBlockIndex == -1)
+        return roadEdge.mStartDirection;
+
+    if (location.mBlockIndex + 1 < roadEdge.mBlocksCount)
+    {
+        return GetRoadDirectionBetween(
+            mLaneBlocks[roadEdge.mFirstBlock + location.mBlockIndex],
+            mLaneBlocks[roadEdge.mFirstBlock + location.mBlockIndex + 1]);
+    }
+    return roadEdge.mEndDirection;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "GameDefs.h"
+#include "MapDirection2D.h"
+
+// forwards
+class GameMap;
+class DebugRenderer;
+
+enum RoadEdgeFlags: unsigned char
+{
+    RoadEdgeFlags_None = 0,
+    RoadEdgeFlags_Railway = BIT(0), // lane crosses railway tracks
+    RoadEdgeFlags_TrafficLights = BIT(1), // there are traffic lights on lane or at end node
+    RoadEdgeFlags_Slope = BIT(2), // lane goes up or down
+};
+decl_enum_as_flags(RoadEdgeFlags);
+
+// road map block location
+struct RoadBlock
+{
+public:
+    unsigned char mX = 0;
+    unsigned char mZ = 0;
+    unsigned char mLayer = 0;
+};
+
+// road network node, junction or dead end
+struct RoadNode
+{
+public:
+    RoadBlock mBlock;
+    RoadEdgeFlags mFlags = RoadEdgeFlags_None;
+    int mFirstEdge = 0; // index of first outgoing edge, outgoing edges are stored contiguously
+    int mEdgesCount = 0; // number of outgoing edges
+};
+
+// road network edge, single direction lane between two nodes
+struct RoadEdge
+{
+public:
+    int mStartNode = 0;
+    int mEndNode = 0;
+    int mFirstBlock = 0; // index of first lane block in blocks list
+    int mBlocksCount = 0; // number of lane blocks between nodes, nodes are not included
+    eMapDirection2D mStartDirection = eMapDirection2D_None; // direction when leaving start node
+    eMapDirection2D mEndDirection = eMapDirection2D_None; // direction when entering end node
+    RoadEdgeFlags mFlags = RoadEdgeFlags_None;
+    unsigned char mLayer = 0; // map layer at start node
+};
+
+// position on road network
+struct RoadLocation
+{
+public:
+    RoadLocation() = default;
+    inline bool IsNull() const { return mEdgeIndex == -1; }
+public:
+    int mEdgeIndex = -1;
+    int mBlockIndex = -1; // lane block index within edge, -1 means start node of edge
+};
+
+// defines roads graph extracted from map blocks direction bits
+// only top surface road blocks are included
+class RoadNetwork final: public cxx::noncopyable
+{
+public:
+    // readonly
+    std::vector<RoadNode> mNodes;
+    std::vector<RoadEdge> mEdges; // sorted by start node
+    std::vector<RoadBlock> mLaneBlocks; // blocks of all edges
+
+public:
+    // Build roads graph for currently loaded map
+    // @param gameMap: Source map data
+    void BuildFromMap(const GameMap& gameMap);
+    void Cleanup();
+
+    void DebugDraw(DebugRenderer& debugRender);
+
+    // Get road location at specific map block
+    // @param coordx, coordz: Block location
+    // @param outLocation: Output location
+    // @returns false if there is no road at block
+    bool GetLocationAtBlock(int coordx, int coordz, RoadLocation& outLocation) const;
+
+    // Find road location closest to specified position
+    // @param position: Map position, meters
+    // @param searchRadius: Max distance, blocks
+    // @param outLocation: Output location
+    // @returns false if there is no roads within search radius
+    bool FindNearestLane(const glm::vec2& position, int searchRadius, RoadLocation& outLocation) const;
+
+    // Get outgoing edge of end node which leaves in specific direction
+    // @param edgeIndex: Current edge
+    // @param direction: Desired direction
+    // @returns -1 if there is no such edge
+    int GetNextEdge(int edgeIndex, eMapDirection2D direction) const;
+
+    // Choose random outgoing edge of end node, u-turn is only chosen if there is no other options
+    // @param edgeIndex: Current edge
+    // @param random: Random numbers generator
+    // @returns -1 if end node is dead end
+    int GetRandomSuccessor(int edgeIndex, cxx::randomizer& random) const;
+
+    // Get map block at road location
+    // @param location: Road location, should not be null
+    RoadBlock GetLocationBlock(const RoadLocation& location) const;
+
+    // Get lane direction at road location
+    // @param location: Road location, should not be null
+    eMapDirection2D GetLocationDirection(const RoadLocation& location) const;
+
+private:
+    // reference from map block to road network element
+    struct BlockRef
+    {
+    public:
+        int mNodeIndex = -1;
+        int mEdgeIndex = -1;
+        int mBlockIndex = -1;
+    };
+
+    // top surface road block info, used while building
+    struct RoadCell
+    {
+    public:
+        signed char mLayer = -1; // -1 if there is no road
+        unsigned char mDirections = 0; // allowed directions mask
+        unsigned char mIncomingCount = 0; // number of neighbour road blocks leading to this one
+        RoadEdgeFlags mFlags = RoadEdgeFlags_None;
+    };
+
+    inline int GetBlockRefIndex(int coordx, int coordz) const
+    {
+        return (coordz * MAP_DIMENSIONS) + coordx;
+    }
+
+    // Get index of next road block in specific direction
+    // @returns -1 if there is no road
+    int GetNextRoadCell(const std::vector<RoadCell>& roadCells, int cellIndex, int directionIndex) const;
+
+    // Create all outgoing edges of node
+    void TraceEdges(int nodeIndex, const std::vector<RoadCell>& roadCells);
+
+private:
+    std::vector<BlockRef> mBlockRefs; // MAP_DIMENSIONS * MAP_DIMENSIONS
+};
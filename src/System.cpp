@@ -2,6 +2,7 @@
 #include "System.h"
 #include "GtaOneGame.h"
 #include "cvars.h"
+#include "ObjectPoolBenchmark.h"
 
 //////////////////////////////////////////////////////////////////////////
 // cvars
@@ -19,12 +20,17 @@ CvarFloat gCvarPhysicsFramerate("g_physicsFps", 60.0f, "Physical world update fr
 // memory
 CvarBoolean gCvarMemEnableFrameHeapAllocator("mem_enableFrameHeapAllocator", true, "Enable frame heap allocator", CvarFlags_Archive | CvarFlags_Init);
 
+// jobs
+CvarInt gCvarSysWorkerThreads("sys_workerThreads", -1, -1, 64, "Number of job system worker threads, -1 for auto", CvarFlags_Archive | CvarFlags_Init);
+
 // audio
 CvarBoolean gCvarAudioActive("a_audioActive", true, "Enable audio system", CvarFlags_Archive | CvarFlags_Init);
 
 // commands
 CvarVoid gCvarSysQuit("quit", "Quit application", CvarFlags_None);
 CvarVoid gCvarSysListCvars("print_cvars", "Print all registered console variables", CvarFlags_None);
+CvarVoid gCvarDbgBenchJobs("dbg_benchJobs", "Run job system stress test", CvarFlags_None);
+CvarVoid gCvarDbgBenchObjectPool("dbg_benchObjectPool", "Compare object pool with previous implementation", CvarFlags_None);
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -70,6 +76,20 @@ void System::Initialize(int argc, char *argv[])
         Terminate();
     }
 
+    int numWorkerThreads = gCvarSysWorkerThreads.mValue;
+    if (numWorkerThreads < 0)
+    {
+        numWorkerThreads = std::max((int) std::thread::hardware_concurrency() - 1, 0);
+    }
+#ifdef __EMSCRIPTEN__
+    numWorkerThreads = 0;
+#endif
+    if (!mJobs.Initialize(numWorkerThreads))
+    {
+        LogMessage(eLogMessage_Error, "Cannot initialize job system");
+        Terminate();
+    }
+
     if (!mGfxDevice.Initialize())
     {
         LogMessage(eLogMessage_Error, "Cannot initialize graphics device");
@@ -108,6 +128,7 @@ void System::Deinit(bool isTermination)
 
     gGame.Deinit();
 
+    mJobs.Deinit();
     mFiles.Deinit();
     mSfxDevice.Deinit();
     mGfxDevice.Deinit();
@@ -242,6 +263,20 @@ bool System::ExecuteFrame()
         };
     }
 
+    // process jobs stress test command
+    if (gCvarDbgBenchJobs.IsModified())
+    {
+        gCvarDbgBenchJobs.ClearModified();
+        mJobs.RunStressTest();
+    }
+
+    // process object pool benchmark command
+    if (gCvarDbgBenchObjectPool.IsModified())
+    {
+        gCvarDbgBenchObjectPool.ClearModified();
+        RunObjectPoolBenchmark(10000);
+    }
+
     // update screen params
     if (gCvarGraphicsFullscreen.IsModified() || gCvarGraphicsVSync.IsModified())
     {
@@ -412,7 +447,11 @@ void System::RegisterGlobalCvars()
     RegisterCvar(&gCvarGraphicsVSync);
     RegisterCvar(&gCvarGraphicsTexFiltering);
     RegisterCvar(&gCvarPhysicsFramerate);
+    RegisterCvar(&gCvarPhysicsBatchedCars);
+    RegisterCvar(&gCvarPhysicsBatchedPeds);
+    RegisterCvar(&gCvarAiCrowdAvoidance);
     RegisterCvar(&gCvarMemEnableFrameHeapAllocator);
+    RegisterCvar(&gCvarSysWorkerThreads);
     RegisterCvar(&gCvarAudioActive);
     RegisterCvar(&gCvarGtaDataPath);
     RegisterCvar(&gCvarMapname);
@@ -430,8 +469,15 @@ void System::RegisterGlobalCvars()
     // commands
     RegisterCvar(&gCvarSysQuit);
     RegisterCvar(&gCvarSysListCvars);
+    RegisterCvar(&gCvarDbgBenchJobs);
+    RegisterCvar(&gCvarDbgBenchObjectPool);
     RegisterCvar(&gCvarDbgDumpSpriteDeltas);
     RegisterCvar(&gCvarDbgDumpBlockTextures);
     RegisterCvar(&gCvarDbgDumpSprites);
     RegisterCvar(&gCvarDbgDumpCarSprites);
+    RegisterCvar(&gCvarDbgBenchCarPhysics);
+    RegisterCvar(&gCvarDbgBenchPathfinding);
+    RegisterCvar(&gCvarDbgBenchTraffic);
+    RegisterCvar(&gCvarDbgBenchPedLocomotion);
+    RegisterCvar(&gCvarDbgTestProjectiles);
 }
@@ -5,6 +5,7 @@
 #include "InputsManager.h"
 #include "GraphicsDevice.h"
 #include "AudioDevice.h"
+#include "JobSystem.h"
 
 // forwards
 class Cvar;
@@ -19,6 +20,7 @@ public:
     InputsManager mInputs;
     GraphicsDevice mGfxDevice;
     AudioDevice mSfxDevice;
+    JobSystem mJobs;
     // console data
     std::deque<ConsoleLine> mConsoleLines;
     std::vector<Cvar*> mCvarsList;
@@ -4,12 +4,57 @@
 #include "GameCheatsWindow.h"
 #include "AiCharacterController.h"
 
+//////////////////////////////////////////////////////////////////////////
+
+// Get parts of rectangle A which are not covered by rectangle B
+// @param outRects: Output rectangles, up to 4
+// @returns number of output rectangles
+inline int SubtractRect(const Rect& rectA, const Rect& rectB, Rect* outRects)
+{
+    if ((rectA.w <= 0) || (rectA.h <= 0))
+        return 0;
+
+    Rect overlap = rectA.GetIntersection(rectB);
+    if ((overlap.w == 0) || (overlap.h == 0))
+    {
+        outRects[0] = rectA;
+        return 1;
+    }
+
+    int rectsCount = 0;
+    // full width strips above and below overlap
+    if (overlap.y > rectA.y)
+    {
+        outRects[rectsCount++] = Rect(rectA.x, rectA.y, rectA.w, overlap.y - rectA.y);
+    }
+    if ((overlap.y + overlap.h) < (rectA.y + rectA.h))
+    {
+        outRects[rectsCount++] = Rect(rectA.x, overlap.y + overlap.h, rectA.w, (rectA.y + rectA.h) - (overlap.y + overlap.h));
+    }
+    // side strips within overlap rows
+    if (overlap.x > rectA.x)
+    {
+        outRects[rectsCount++] = Rect(rectA.x, overlap.y, overlap.x - rectA.x, overlap.h);
+    }
+    if ((overlap.x + overlap.w) < (rectA.x + rectA.w))
+    {
+        outRects[rectsCount++] = Rect(overlap.x + overlap.w, overlap.y, (rectA.x + rectA.w) - (overlap.x + overlap.w), overlap.h);
+    }
+    return rectsCount;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 TrafficManager::TrafficManager()
 {
 }
 
 void TrafficManager::StartupTraffic()
 {   
+    BuildSpawnTables();
+    ResetCandidatesRing(mPedsCandidates);
+    ResetCandidatesRing(mCarsCandidates);
+
     mLastGenHareKrishnasTime = gGame.mTimeMng.mGameTime;
 
     mLastGenPedsTime = 0.0f;
@@ -41,6 +86,7 @@ void TrafficManager::UpdateFrame()
 
 void TrafficManager::DebugDraw(DebugRenderer& debugRender)
 {
+    gGame.mRoadNetwork.DebugDraw(debugRender);
 }
 
 void TrafficManager::GeneratePeds()
@@ -96,80 +142,16 @@ void TrafficManager::GenerateTrafficPeds(int pedsCount, GameCamera& view)
 {
     cxx::randomizer& random = gGame.mRandom;
 
-    int numPedsGenerated = 0;
-
-    Rect innerRect;
-    Rect outerRect;
-    // get map area on screen
-    {
-        Point minBlock;
-        minBlock.x = (int) Convert::MetersToMapUnits(view.mOnScreenMapArea.mMin.x);
-        minBlock.y = (int) Convert::MetersToMapUnits(view.mOnScreenMapArea.mMin.y);
-
-        Point maxBlock;
-        maxBlock.x = (int) Convert::MetersToMapUnits(view.mOnScreenMapArea.mMax.x) + 1;
-        maxBlock.y = (int) Convert::MetersToMapUnits(view.mOnScreenMapArea.mMax.y) + 1;
-
-        innerRect.x = minBlock.x;
-        innerRect.y = minBlock.y;
-        innerRect.w = (maxBlock.x - minBlock.x);
-        innerRect.h = (maxBlock.y - minBlock.y);
-
-        // expand
-        int expandSize = gGame.mParams.mTrafficGenPedsMaxDistance;
-        outerRect = innerRect;
-        outerRect.x -= expandSize;
-        outerRect.y -= expandSize;
-        outerRect.w += expandSize * 2;
-        outerRect.h += expandSize * 2;
-    }
-    
-    mCandidatePosArray.clear();
-
-    for (int iy = 0; iy < outerRect.h; ++iy)
-    for (int ix = 0; ix < outerRect.w; ++ix)
-    {
-        Point pos (ix + outerRect.x, iy + outerRect.y);
-        if (innerRect.PointWithin(pos))
-            continue;
-
-        // scan candidate from top
-        for (int iz = (MAP_LAYERS_COUNT - 1); iz > 0; --iz)
-        {
-            const MapBlockInfo* mapBlock = gGame.mMap.GetBlockInfo(pos.x, pos.y, iz);
-
-            if (mapBlock->mGroundType == eGroundType_Air)
-                continue;
-
-            if (mapBlock->mGroundType == eGroundType_Pawement)
-            {
-                if (mapBlock->mIsRailway)
-                    continue;
-
-                CandidatePos candidatePos;
-                candidatePos.mMapX = pos.x;
-                candidatePos.mMapY = pos.y;
-                candidatePos.mMapLayer = iz;
-                mCandidatePosArray.push_back(candidatePos);
-            }
-            break;
-        }
-    }
-
-    if (mCandidatePosArray.empty())
-        return;
-
-    // shuffle candidates
-    random.shuffle(mCandidatePosArray);
+    UpdateCandidatesRing(mPedsCandidates, mPedsSpawnLayers, gGame.mParams.mTrafficGenPedsMaxDistance, view);
 
-    for (; (numPedsGenerated < pedsCount) && !mCandidatePosArray.empty(); ++numPedsGenerated)
+    int numPedsGenerated = 0;
+    int numCandidatesChosen = 0;
+    for (; (numPedsGenerated < pedsCount) && (numCandidatesChosen < (int) mPedsCandidates.mCandidates.size()); ++numPedsGenerated)
     {
         if (!random.random_chance(gGame.mParams.mTrafficGenPedsChance))
             continue;
 
-        CandidatePos candidate = mCandidatePosArray.back();
-        mCandidatePosArray.pop_back();
-
+        CandidatePos candidate = ChooseCandidate(mPedsCandidates, mPedsSpawnLayers, numCandidatesChosen++);
         if ((mLastGenHareKrishnasTime + gGame.mParams.mTrafficGenHareKrishnasTime) < gGame.mTimeMng.mGameTime)
         {
             // generate hare krishnas
@@ -288,8 +270,76 @@ void TrafficManager::GenerateTrafficCars(int carsCount, GameCamera& view)
 {
     cxx::randomizer& random = gGame.mRandom;
 
+    UpdateCandidatesRing(mCarsCandidates, mCarsSpawnLayers, gGame.mParams.mTrafficGenCarsMaxDistance, view);
+
     int numCarsGenerated = 0;
+    int numCandidatesChosen = 0;
+    for (; (numCarsGenerated < carsCount) && (numCandidatesChosen < (int) mCarsCandidates.mCandidates.size()); ++numCarsGenerated)
+    {
+        if (!random.random_chance(gGame.mParams.mTrafficGenCarsChance))
+            continue;
+
+        CandidatePos candidate = ChooseCandidate(mCarsCandidates, mCarsSpawnLayers, numCandidatesChosen++);
+        GenerateRandomTrafficCar(candidate.mMapX, candidate.mMapLayer, candidate.mMapY);
+    }
+}
+
+void TrafficManager::BuildSpawnTables()
+{
+    const int NumBlocks = MAP_DIMENSIONS * MAP_DIMENSIONS;
+    mPedsSpawnLayers.assign(NumBlocks, -1);
+    mCarsSpawnLayers.assign(NumBlocks, -1);
+
+    for (int coordz = 0; coordz < MAP_DIMENSIONS; ++coordz)
+    for (int coordx = 0; coordx < MAP_DIMENSIONS; ++coordx)
+    {
+        const int blockIndex = (coordz * MAP_DIMENSIONS) + coordx;
+
+        // peds are spawned on topmost pavement, railways are skipped
+        for (int iz = (MAP_LAYERS_COUNT - 1); iz > 0; --iz)
+        {
+            const MapBlockInfo* mapBlock = gGame.mMap.GetBlockInfo(coordx, coordz, iz);
+
+            if (mapBlock->mGroundType == eGroundType_Air)
+                continue;
+
+            if (mapBlock->mGroundType == eGroundType_Pawement)
+            {
+                if (mapBlock->mIsRailway)
+                    continue;
+
+                mPedsSpawnLayers[blockIndex] = (signed char) iz;
+            }
+            break;
+        }
+
+        // cars are spawned on topmost road with single lane direction, railways are skipped
+        for (int iz = (MAP_LAYERS_COUNT - 1); iz > 0; --iz)
+        {
+            const MapBlockInfo* mapBlock = gGame.mMap.GetBlockInfo(coordx, coordz, iz);
+
+            if (mapBlock->mGroundType == eGroundType_Air)
+                continue;
+
+            if (mapBlock->mGroundType == eGroundType_Road)
+            {
+                int bits = (int) (mapBlock->mDownDirection) + 
+                    (int) (mapBlock->mUpDirection) +
+                    (int) (mapBlock->mLeftDirection) + 
+                    (int) (mapBlock->mRightDirection);
+
+                if ((bits == 0 || bits > 1) || mapBlock->mIsRailway)
+                    continue;
+
+                mCarsSpawnLayers[blockIndex] = (signed char) iz;
+            }
+            break;
+        }
+    }
+}
 
+void TrafficManager::UpdateCandidatesRing(CandidatesRing& ring, const std::vector<signed char>& spawnLayers, int expandSize, GameCamera& view)
+{
     Rect innerRect;
     Rect outerRect;
     // get map area on screen
@@ -308,67 +358,103 @@ void TrafficManager::GenerateTrafficCars(int carsCount, GameCamera& view)
         innerRect.h = (maxBlock.y - minBlock.y);
 
         // expand
-        int expandSize = gGame.mParams.mTrafficGenCarsMaxDistance;
         outerRect = innerRect;
         outerRect.x -= expandSize;
         outerRect.y -= expandSize;
         outerRect.w += expandSize * 2;
         outerRect.h += expandSize * 2;
     }
-    
-    mCandidatePosArray.clear();
 
-    for (int iy = 0; iy < outerRect.h; ++iy)
-    for (int ix = 0; ix < outerRect.w; ++ix)
+    if ((innerRect == ring.mInnerRect) && (outerRect == ring.mOuterRect))
+        return;
+
+    if (ring.mCandidateSlots.empty())
     {
-        Point pos (ix + outerRect.x, iy + outerRect.y);
-        if (innerRect.PointWithin(pos))
-            continue;
+        ring.mCandidateSlots.assign(MAP_DIMENSIONS * MAP_DIMENSIONS, -1);
+    }
 
-        // scan candidate from top
-        for (int iz = (MAP_LAYERS_COUNT - 1); iz > 0; --iz)
-        {
-            const MapBlockInfo* mapBlock = gGame.mMap.GetBlockInfo(pos.x, pos.y, iz);
+    auto is_within_ring = [&innerRect, &outerRect](const Point& pos)
+    {
+        return outerRect.PointWithin(pos) && !innerRect.PointWithin(pos);
+    };
 
-            if (mapBlock->mGroundType == eGroundType_Air)
+    const Rect mapRect (0, 0, MAP_DIMENSIONS, MAP_DIMENSIONS);
+    Rect strips[8];
+
+    // blocks which leave ring are in area left by outer rect or covered by inner rect
+    int stripsCount = SubtractRect(ring.mOuterRect, outerRect, strips);
+    stripsCount += SubtractRect(innerRect, ring.mInnerRect, strips + stripsCount);
+    for (int istrip = 0; istrip < stripsCount; ++istrip)
+    {
+        Rect stripRect = strips[istrip].GetIntersection(mapRect);
+        for (int iy = stripRect.y; iy < (stripRect.y + stripRect.h); ++iy)
+        for (int ix = stripRect.x; ix < (stripRect.x + stripRect.w); ++ix)
+        {
+            const int blockIndex = (iy * MAP_DIMENSIONS) + ix;
+            const int candidateSlot = ring.mCandidateSlots[blockIndex];
+            if ((candidateSlot == -1) || is_within_ring(Point(ix, iy)))
                 continue;
 
-            if (mapBlock->mGroundType == eGroundType_Road)
-            {
-                int bits = (int) (mapBlock->mDownDirection) + 
-                    (int) (mapBlock->mUpDirection) +
-                    (int) (mapBlock->mLeftDirection) + 
-                    (int) (mapBlock->mRightDirection);
+            // swap with last
+            const int lastBlockIndex = ring.mCandidates.back();
+            ring.mCandidates[candidateSlot] = lastBlockIndex;
+            ring.mCandidateSlots[lastBlockIndex] = candidateSlot;
+            ring.mCandidates.pop_back();
+            ring.mCandidateSlots[blockIndex] = -1;
+        }
+    }
 
-                if ((bits == 0 || bits > 1) || mapBlock->mIsRailway)
-                    continue;
+    // blocks which enter ring are in area new to outer rect or left by inner rect
+    stripsCount = SubtractRect(outerRect, ring.mOuterRect, strips);
+    stripsCount += SubtractRect(ring.mInnerRect, innerRect, strips + stripsCount);
+    for (int istrip = 0; istrip < stripsCount; ++istrip)
+    {
+        Rect stripRect = strips[istrip].GetIntersection(mapRect);
+        for (int iy = stripRect.y; iy < (stripRect.y + stripRect.h); ++iy)
+        for (int ix = stripRect.x; ix < (stripRect.x + stripRect.w); ++ix)
+        {
+            const int blockIndex = (iy * MAP_DIMENSIONS) + ix;
+            if ((spawnLayers[blockIndex] == -1) || (ring.mCandidateSlots[blockIndex] != -1) || !is_within_ring(Point(ix, iy)))
+                continue;
 
-                CandidatePos candidatePos;
-                candidatePos.mMapX = pos.x;
-                candidatePos.mMapY = pos.y;
-                candidatePos.mMapLayer = iz;
-                mCandidatePosArray.push_back(candidatePos);
-            }
-            break;
+            ring.mCandidateSlots[blockIndex] = (int) ring.mCandidates.size();
+            ring.mCandidates.push_back(blockIndex);
         }
     }
 
-    if (mCandidatePosArray.empty())
-        return;
+    ring.mInnerRect = innerRect;
+    ring.mOuterRect = outerRect;
+}
 
-    // shuffle candidates
-    random.shuffle(mCandidatePosArray);
+void TrafficManager::ResetCandidatesRing(CandidatesRing& ring)
+{
+    ring.mInnerRect.SetNull();
+    ring.mOuterRect.SetNull();
+    ring.mCandidates.clear();
+    ring.mCandidateSlots.clear();
+}
 
-    for (; (numCarsGenerated < carsCount) && !mCandidatePosArray.empty(); ++numCarsGenerated)
+TrafficManager::CandidatePos TrafficManager::ChooseCandidate(CandidatesRing& ring, const std::vector<signed char>& spawnLayers, int numChosen)
+{
+    const int numAvailable = (int) ring.mCandidates.size() - numChosen;
+    cxx_assert(numAvailable > 0);
+
+    // move random candidate behind available ones, so it cannot be chosen again
+    const int lastSlot = numAvailable - 1;
+    const int chosenSlot = gGame.mRandom.generate_int(lastSlot);
+    const int blockIndex = ring.mCandidates[chosenSlot];
+    if (chosenSlot != lastSlot)
     {
-        if (!random.random_chance(gGame.mParams.mTrafficGenCarsChance))
-            continue;
-
-        CandidatePos candidate = mCandidatePosArray.back();
-        mCandidatePosArray.pop_back();
-
-        GenerateRandomTrafficCar(candidate.mMapX, candidate.mMapLayer, candidate.mMapY);
+        std::swap(ring.mCandidates[chosenSlot], ring.mCandidates[lastSlot]);
+        ring.mCandidateSlots[ring.mCandidates[chosenSlot]] = chosenSlot;
+        ring.mCandidateSlots[blockIndex] = lastSlot;
     }
+
+    CandidatePos candidatePos;
+    candidatePos.mMapX = blockIndex % MAP_DIMENSIONS;
+    candidatePos.mMapY = blockIndex / MAP_DIMENSIONS;
+    candidatePos.mMapLayer = spawnLayers[blockIndex];
+    return candidatePos;
 }
 
 void TrafficManager::RemoveOffscreenCars()
@@ -556,6 +642,129 @@ Pedestrian* TrafficManager::GenerateRandomTrafficCarDriver(Vehicle* car)
     return pedestrian;
 }
 
+void TrafficManager::RunDrivingBenchmark(int numCars)
+{
+    const RoadNetwork& roadNetwork = gGame.mRoadNetwork;
+    if (roadNetwork.mLaneBlocks.empty())
+    {
+        gSystem.LogMessage(eLogMessage_Warning, "Cannot run driving benchmark, there are no roads on map");
+        return;
+    }
+
+    gSystem.LogMessage(eLogMessage_Info, "Driving benchmark started");
+
+    const int NumFrames = 300;
+    const int NumWarmupFrames = 60; // ai objects and their lists are growing
+    const int NumWalkers = 64;
+    const int NumWalkersRespawnPerFrame = 4;
+    const float FrameDelta = 1.0f / 60.0f;
+
+    // spawn cars on random lane blocks, single car per block
+    cxx::randomizer random;
+    std::set<int> usedBlocks;
+    std::vector<GameObjectID> spawnedCars;
+    for (int iattempt = 0, MaxAttempts = numCars * 4; (iattempt < MaxAttempts) && ((int) spawnedCars.size() < numCars); ++iattempt)
+    {
+        const RoadBlock& laneBlock = roadNetwork.mLaneBlocks[random.generate_int((int) roadNetwork.mLaneBlocks.size() - 1)];
+        if (!usedBlocks.insert((laneBlock.mZ * MAP_DIMENSIONS) + laneBlock.mX).second)
+            continue;
+
+        Vehicle* vehicle = GenerateRandomTrafficCar(laneBlock.mX, laneBlock.mLayer, laneBlock.mZ);
+        if (vehicle)
+        {
+            spawnedCars.push_back(vehicle->mObjectID);
+        }
+    }
+
+    std::vector<GameObjectID> spawnedWalkers;
+    auto spawn_walker = [this, &roadNetwork, &random, &spawnedWalkers]()
+    {
+        const RoadBlock& laneBlock = roadNetwork.mLaneBlocks[random.generate_int((int) roadNetwork.mLaneBlocks.size() - 1)];
+        Pedestrian* pedestrian = GenerateRandomTrafficPedestrian(laneBlock.mX, laneBlock.mLayer, laneBlock.mZ);
+        if (pedestrian)
+        {
+            spawnedWalkers.push_back(pedestrian->mObjectID);
+        }
+    };
+    for (int iwalker = 0; iwalker < NumWalkers; ++iwalker)
+    {
+        spawn_walker();
+    }
+
+    // all drivers should think every frame regardless of distance to camera
+    const float prevFullRateDistance = gGame.mParams.mAiLodFullRateDistance;
+    const float prevFrameDelta = gGame.mTimeMng.mGameFrameDelta;
+    gGame.mParams.mAiLodFullRateDistance = Convert::MapUnitsToMeters(MAP_DIMENSIONS * 1.0f);
+    gGame.mTimeMng.mGameFrameDelta = FrameDelta;
+
+    double aiTime = 0.0;
+    int aiAllocationsCount = 0;
+    double startTime = gSystem.GetSystemSeconds();
+    for (int iframe = 0; iframe < NumFrames; ++iframe)
+    {
+        // despawned walkers free their ai controllers, new ones pick them up
+        for (int irespawn = 0; (irespawn < NumWalkersRespawnPerFrame) && !spawnedWalkers.empty(); ++irespawn)
+        {
+            int iwalker = random.generate_int((int) spawnedWalkers.size() - 1);
+            Pedestrian* pedestrian = gGame.mObjectsMng.GetPedestrianByID(spawnedWalkers[iwalker]);
+            if (pedestrian)
+            {
+                TryRemoveTrafficPed(pedestrian);
+            }
+            spawnedWalkers[iwalker] = spawnedWalkers.back();
+            spawnedWalkers.pop_back();
+            spawn_walker();
+        }
+
+        gGame.mPhysicsMng.UpdateFrame();
+        gGame.mObjectsMng.UpdateFrame();
+
+        const int prevAllocationsCount = gSystem.mMemoryMng.GetHeapAllocationsCount();
+        double aiStartTime = gSystem.GetSystemSeconds();
+        gGame.mAiMng.UpdateFrame();
+        aiTime += gSystem.GetSystemSeconds() - aiStartTime;
+
+        if (iframe >= NumWarmupFrames)
+        {
+            aiAllocationsCount += gSystem.mMemoryMng.GetHeapAllocationsCount() - prevAllocationsCount;
+        }
+    }
+    double totalTime = gSystem.GetSystemSeconds() - startTime;
+
+    // pooled ai objects are reused with their lists, so steady respawns should not allocate
+    cxx_assert(aiAllocationsCount == 0);
+
+    gGame.mParams.mAiLodFullRateDistance = prevFullRateDistance;
+    gGame.mTimeMng.mGameFrameDelta = prevFrameDelta;
+
+    int movingCars = 0;
+    for (GameObjectID currCarID: spawnedCars)
+    {
+        Vehicle* vehicle = gGame.mObjectsMng.GetVehicleByID(currCarID);
+        if (vehicle == nullptr)
+            continue;
+
+        const float MovingSpeed = 1.0f;
+        if (vehicle->GetCurrentSpeed() > MovingSpeed)
+        {
+            ++movingCars;
+        }
+        TryRemoveTrafficCar(vehicle);
+    }
+
+    for (GameObjectID currWalkerID: spawnedWalkers)
+    {
+        Pedestrian* pedestrian = gGame.mObjectsMng.GetPedestrianByID(currWalkerID);
+        if (pedestrian)
+        {
+            TryRemoveTrafficPed(pedestrian);
+        }
+    }
+
+    gSystem.LogMessage(eLogMessage_Info, "Cars: %d, moving: %d, ai: %.3f ms per frame, total: %.3f ms per frame, ai heap allocations after warmup: %d",
+        (int) spawnedCars.size(), movingCars, (aiTime * 1000.0) / NumFrames, (totalTime * 1000.0) / NumFrames, aiAllocationsCount);
+}
+
 bool TrafficManager::TryRemoveTrafficCar(Vehicle* car)
 {
     if (car->IsMarkedForDeletion())
@@ -20,6 +20,11 @@ public:
     int CountTrafficPedestrians() const;
     int CountTrafficCars() const;
 
+    // Spawn traffic cars with ai drivers all over road network and simulate frames without rendering, results are printed to log
+    // Walking pedestrians are respawned every frame to check that ai updates do not allocate heap memory
+    // @param numCars: Number of cars to spawn
+    void RunDrivingBenchmark(int numCars);
+
 private:
     // traffic pedestrians generation
     void GeneratePeds();
@@ -44,16 +49,43 @@ private:
     bool TryRemoveTrafficCar(Vehicle* car);
 
 private:
-    float mLastGenPedsTime = 0.0;
-    float mLastGenCarsTime = 0.0f;
-    float mLastGenHareKrishnasTime = 0.0f;
-
-    // buffers
     struct CandidatePos
     {
         int mMapX;
         int mMapY;
         int mMapLayer;
     };
-    std::vector<CandidatePos> mCandidatePosArray;
+
+    // spawn candidates within ring around visible map area
+    struct CandidatesRing
+    {
+    public:
+        Rect mInnerRect {0, 0, 0, 0}; // visible blocks
+        Rect mOuterRect {0, 0, 0, 0}; // visible blocks expanded by generation distance
+        std::vector<int> mCandidates; // map blocks indices
+        std::vector<int> mCandidateSlots; // index in candidates list for each map block, -1 if none
+    };
+
+    // Precompute spawn layers for all map blocks, should be called after map is loaded
+    void BuildSpawnTables();
+
+    // Move candidates ring to current visible map area, only strips entering or leaving ring are processed
+    // @param spawnLayers: Spawn layer for each map block, -1 if block is not suitable
+    // @param expandSize: Distance from visible map area, blocks
+    void UpdateCandidatesRing(CandidatesRing& ring, const std::vector<signed char>& spawnLayers, int expandSize, GameCamera& view);
+    void ResetCandidatesRing(CandidatesRing& ring);
+
+    // Choose random candidate without shuffling, same candidate is not chosen twice within generation turn
+    // @param numChosen: Number of candidates chosen during current generation turn, should be less than candidates count
+    CandidatePos ChooseCandidate(CandidatesRing& ring, const std::vector<signed char>& spawnLayers, int numChosen);
+
+private:
+    float mLastGenPedsTime = 0.0;
+    float mLastGenCarsTime = 0.0f;
+    float mLastGenHareKrishnasTime = 0.0f;
+
+    std::vector<signed char> mPedsSpawnLayers; // topmost pavement layer for each map block, -1 if none
+    std::vector<signed char> mCarsSpawnLayers; // topmost single direction road layer for each map block, -1 if none
+    CandidatesRing mPedsCandidates;
+    CandidatesRing mCarsCandidates;
 };
@@ -108,23 +108,70 @@ void Vehicle::UpdateFrame()
 void Vehicle::SimulationStep()
 {
     DriveCtlState currCtlState;
+    GetDriveCtlState(currCtlState);
 
-    if (!IsWrecked())
-    {
-        Pedestrian* carDriver = GetCarDriver();
-        if (carDriver)
-        {
-            const PedestrianCtlState& ctlState = carDriver->GetCtlState();
-            currCtlState.mDriveDirection = ctlState.mAcceleration;
-            currCtlState.mSteerDirection = ctlState.mSteerDirection;
-            currCtlState.mHandBrake = ctlState.mHandBrake;
-        }
-    }
     UpdateFriction(currCtlState);
     UpdateDrive(currCtlState);
     UpdateSteer(currCtlState);
 }
 
+void Vehicle::SimulationStepSimplified()
+{
+    DriveCtlState currCtlState;
+    GetDriveCtlState(currCtlState);
+
+    UpdateSteer(currCtlState);
+
+    float carMass = mPhysicsBody->GetMass();
+    if (carMass <= 0.0f)
+        return;
+
+    // same forces as in UpdateFriction and UpdateDrive but applied along car heading, tires never slip
+    const float stepTime = gGame.mPhysicsMng.GetSimulationStepTime();
+    const float rrCoef = 50.0f * 2.0f; // both tires
+    const float dragForceCoef = 102.0f;
+
+    float currentSpeed = GetCurrentSpeed();
+    float driveForce = GetEngineForce(currCtlState) * currCtlState.mDriveDirection;
+    float dragForce = dragForceCoef * currentSpeed * fabsf(currentSpeed);
+
+    float newSpeed = currentSpeed - (rrCoef * currentSpeed) / carMass;
+    if (currentSpeed * newSpeed < 0.0f) // resistance cannot reverse car
+    {
+        newSpeed = 0.0f;
+    }
+    newSpeed += ((driveForce - dragForce) / carMass) * stepTime;
+
+    // bicycle model
+    float angularVelocity = 0.0f;
+    float wheelBase = fabsf(mFrontTireOffset - mRearTireOffset);
+    if (wheelBase > 0.0f)
+    {
+        angularVelocity = (newSpeed * tanf(mSteeringAngleRadians)) / wheelBase;
+    }
+
+    glm::vec2 forwardVector = mPhysicsBody->GetWorldVector(LocalForwardVector);
+    mPhysicsBody->SetLinearVelocity(forwardVector * newSpeed);
+    mPhysicsBody->SetAngularVelocity(cxx::angle_t::from_radians(angularVelocity));
+}
+
+void Vehicle::GetDriveCtlState(DriveCtlState& outputCtlState) const
+{
+    outputCtlState = DriveCtlState();
+
+    if (IsWrecked())
+        return;
+
+    Pedestrian* carDriver = GetCarDriver();
+    if (carDriver)
+    {
+        const PedestrianCtlState& ctlState = carDriver->GetCtlState();
+        outputCtlState.mDriveDirection = ctlState.mAcceleration;
+        outputCtlState.mSteerDirection = ctlState.mSteerDirection;
+        outputCtlState.mHandBrake = ctlState.mHandBrake;
+    }
+}
+
 void Vehicle::DebugDraw(DebugRenderer& debugRender)
 {
     glm::vec3 position = mPhysicsBody->GetPosition();
@@ -554,6 +601,8 @@ Pedestrian* Vehicle::GetFirstPassenger(eCarSeat carSeat) const
 
 void Vehicle::Explode()
 {
+    RefreshDrawHeight();
+
     glm::vec3 explosionPos = mPhysicsBody->GetPosition();
     explosionPos.y = mDrawSprite.mHeight;
 
@@ -744,14 +793,6 @@ bool Vehicle::ReceiveDamage(const DamageInfo& damageInfo)
     return false;
 }
 
-bool Vehicle::ShouldCollide(GameObject* otherObject) const
-{
-    if (otherObject->IsVehicleClass() || otherObject->IsObstacleClass())
-        return true;
-
-    return false;
-}
-
 void Vehicle::HandleCollision(const Collision& collision)
 {
     DamageInfo damageInfo;
@@ -1084,31 +1125,33 @@ void Vehicle::UpdateDrive(const DriveCtlState& currCtlState)
     if (currCtlState.mDriveDirection == 0.0f)
         return;
 
+    float engineForce = GetEngineForce(currCtlState);
+
+    glm::vec2 F = engineForce * currCtlState.mDriveDirection * GetTireForward(eCarTire_Rear);
+    mPhysicsBody->AddForce(F, GetTirePosition(eCarTire_Rear));
+}
+
+float Vehicle::GetEngineForce(const DriveCtlState& currCtlState) const
+{
+    return GetEngineForce(currCtlState, GetCurrentSpeed());
+}
+
+float Vehicle::GetEngineForce(const DriveCtlState& currCtlState, float currentSpeed) const
+{
+    if (currCtlState.mDriveDirection == 0.0f)
+        return 0.0f;
+
     float driveForce = 100750.0f; // todo: magic numbers
     float brakeForce = driveForce * mCarInfo->mHandbrakeFriction;
     float reverseForce = driveForce * 0.75f;
 
-    float currentSpeed = GetCurrentSpeed();
-    float engineForce = 0.0f;
-
     if (currCtlState.mDriveDirection > 0.0f)
-    {
-        engineForce = driveForce;
-    }
-    else
-    {
-        if (currentSpeed > 0.0f)
-        {
-            engineForce = brakeForce;
-        }
-        else
-        {
-            engineForce = reverseForce;
-        }
-    }
+        return driveForce;
 
-    glm::vec2 F = engineForce * currCtlState.mDriveDirection * GetTireForward(eCarTire_Rear);
-    mPhysicsBody->AddForce(F, GetTirePosition(eCarTire_Rear));
+    if (currentSpeed > 0.0f)
+        return brakeForce;
+
+    return reverseForce;
 }
 
 glm::vec2 Vehicle::GetTireLateralVelocity(eCarTire tireID) const
@@ -35,6 +35,7 @@ public:
     // override GameObject
     void UpdateFrame() override;
     void SimulationStep() override;
+    void SimulationStepSimplified() override;
     void DebugDraw(DebugRenderer& debugRender) override;
     void HandleSpawn() override;
     void HandleDespawn() override;
@@ -43,7 +44,6 @@ public:
     void HandleFallsOnWater(float fallDistance) override;
     void HandleFallsOnGround(float fallDistance) override;
     bool ReceiveDamage(const DamageInfo& damageInfo) override;
-    bool ShouldCollide(GameObject* otherObject) const override;
 
     // adds or removes car passenger
     // @param pedestrian: Pedestrian, cannot be null
@@ -143,10 +143,16 @@ private:
         bool mHandBrake = false;
     };
 
+    void GetDriveCtlState(DriveCtlState& outputCtlState) const;
     void UpdateSteer(const DriveCtlState& currCtlState);
     void UpdateFriction(const DriveCtlState& currCtlState);
     void UpdateDrive(const DriveCtlState& currCtlState);
 
+    // Get engine or brake force magnitude for current control state, newtons
+    // @param currentSpeed: Forward speed which decides between brake and reverse
+    float GetEngineForce(const DriveCtlState& currCtlState) const;
+    float GetEngineForce(const DriveCtlState& currCtlState, float currentSpeed) const;
+
     // Get tire velocities
     glm::vec2 GetTireLateralVelocity(eCarTire tireID) const;
     glm::vec2 GetTireForwardVelocity(eCarTire tireID) const;
@@ -38,19 +38,13 @@ bool Weapon::Fire(Pedestrian* shooter)
         glm::vec2 posA { currPosition.x, currPosition.z };
         glm::vec2 posB = posA + (shooter->mTransform.GetDirectionVector() * weaponInfo->mBaseHitRange);
         // find candidates
-        PhysicsQueryResult queryResults;
-        gGame.mPhysicsMng.QueryObjectsLinecast(posA, posB, queryResults, CollisionGroup_Pedestrian);
-        for (int icurr = 0; icurr < queryResults.mElementsCount; ++icurr)
+        PhysicsQueryResult queryResults (gSystem.mMemoryMng.GetFrameHeapAllocator());
+        gGame.mPhysicsMng.QueryObjectsLinecast(posA, posB, PhysicsQueryFilter(CollisionGroup_Pedestrian, eGameObjectClass_Pedestrian, shooter), queryResults);
+        for (const PhysicsQueryElement& currElement: queryResults)
         {
-            GameObject* currGameObject = queryResults.mElements[icurr].mPhysicsObject->mGameObject;
-            cxx_assert(currGameObject);
-
-            Pedestrian* otherPedestrian = ToPedestrian(currGameObject);
+            Pedestrian* otherPedestrian = ToPedestrian(currElement.mPhysicsObject->mGameObject);
             cxx_assert(otherPedestrian);
 
-            if (otherPedestrian == shooter) // ignore self
-                continue;
-
             // todo: check distance in y direction
             DamageInfo damageInfo;
             damageInfo.SetDamage(*weaponInfo, shooter);         
@@ -18,10 +18,18 @@ extern CvarBoolean gCvarGraphicsTexFiltering; // is texture filtering enabled
 
 // physics
 extern CvarFloat gCvarPhysicsFramerate; // physical world update framerate
+extern CvarBoolean gCvarPhysicsBatchedCars; // compute car tire forces for all cars at once
+extern CvarBoolean gCvarPhysicsBatchedPeds; // compute idle pedestrians locomotion for all pedestrians at once
+
+// ai
+extern CvarBoolean gCvarAiCrowdAvoidance; // steer ai pedestrians around each other instead of physics contacts
 
 // memory
 extern CvarBoolean gCvarMemEnableFrameHeapAllocator; // enable frame heap allocator
 
+// jobs
+extern CvarInt gCvarSysWorkerThreads; // number of job system worker threads, -1 for auto
+
 // audio
 extern CvarBoolean gCvarAudioActive; // enable audio system
 extern CvarEnum<eGameMusicMode> gCvarGameMusicMode; // ingame music mode
@@ -53,3 +61,10 @@ extern CvarVoid gCvarDbgDumpSpriteDeltas; // dump sprite deltas
 extern CvarVoid gCvarDbgDumpBlockTextures; // dump block textures
 extern CvarVoid gCvarDbgDumpSprites; // dump all sprites
 extern CvarVoid gCvarDbgDumpCarSprites; // dump car sprites
+extern CvarVoid gCvarDbgBenchJobs; // run job system stress test
+extern CvarVoid gCvarDbgBenchObjectPool; // compare object pool with previous implementation
+extern CvarVoid gCvarDbgBenchCarPhysics; // compare batched and per car tire forces computation
+extern CvarVoid gCvarDbgBenchPathfinding; // measure pathfinding queries per second
+extern CvarVoid gCvarDbgBenchTraffic; // measure frame time with many ai driven traffic cars
+extern CvarVoid gCvarDbgBenchPedLocomotion; // compare batched and per pedestrian locomotion
+extern CvarVoid gCvarDbgTestProjectiles; // check that point blank shot hits adjacent pedestrian
@@ -35,6 +35,18 @@ namespace cxx
         virtual void reset()
         {
         }
+
+        // get current free memory cursor, allocations made after marker can be freed at once with pop_marker
+        virtual unsigned int push_marker()
+        {
+            return 0;
+        }
+
+        // free all allocations made after marker
+        // @param marker: Value returned by push_marker
+        virtual void pop_marker(unsigned int marker)
+        {
+        }
     public:
         mem_allocator_out_of_memory_proc mOutOfMemoryProc;
     };
@@ -61,6 +73,13 @@ namespace cxx
         // reset allocations
         void reset() override;
 
+        // scratch scopes
+        unsigned int push_marker() override;
+        void pop_marker(unsigned int marker) override;
+
+        // get number of bytes currently in use
+        inline unsigned int get_used_memory() const { return mMemorySizeUsed; }
+
     private:
         unsigned int mMemorySizeTotal = 0;
         unsigned int mMemorySizeUsed = 0;
@@ -86,4 +105,68 @@ namespace cxx
         void deallocate(void* dataPointer) override;
     };
 
+    // frees all allocations made within scope
+    class memory_allocator_scope: public cxx::noncopyable
+    {
+    public:
+        memory_allocator_scope(memory_allocator* allocator)
+            : mAllocator(allocator)
+        {
+            cxx_assert(mAllocator);
+            mMarker = mAllocator->push_marker();
+        }
+        ~memory_allocator_scope()
+        {
+            mAllocator->pop_marker(mMarker);
+        }
+    private:
+        memory_allocator* mAllocator = nullptr;
+        unsigned int mMarker = 0;
+    };
+
+    // adapts memory allocator for std containers
+    template<typename TElement>
+    class stl_memory_allocator
+    {
+    public:
+        using value_type = TElement;
+
+    public:
+        stl_memory_allocator(memory_allocator* allocator)
+            : mAllocator(allocator)
+        {
+            cxx_assert(mAllocator);
+        }
+        template<typename TOtherElement>
+        stl_memory_allocator(const stl_memory_allocator<TOtherElement>& other)
+            : mAllocator(other.mAllocator)
+        {
+        }
+        inline TElement* allocate(std::size_t elementsCount)
+        {
+            void* dataPointer = mAllocator->allocate((unsigned int) (elementsCount * sizeof(TElement)));
+            if (dataPointer == nullptr)
+            {
+                throw std::bad_alloc();
+            }
+            return static_cast<TElement*>(dataPointer);
+        }
+        inline void deallocate(TElement* dataPointer, std::size_t elementsCount)
+        {
+            mAllocator->deallocate(dataPointer);
+        }
+        template<typename TOtherElement>
+        inline bool operator == (const stl_memory_allocator<TOtherElement>& other) const
+        {
+            return mAllocator == other.mAllocator;
+        }
+        template<typename TOtherElement>
+        inline bool operator != (const stl_memory_allocator<TOtherElement>& other) const
+        {
+            return mAllocator != other.mAllocator;
+        }
+    public:
+        memory_allocator* mAllocator = nullptr;
+    };
+
 } // namespace cxx
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <type_traits>
+#include <cstdint>
 
 namespace cxx
 {
@@ -8,16 +9,19 @@ namespace cxx
 
     namespace details
     {
+        template<typename TPoolElement, int BlockSize>
+        class object_pool_chunk;
+
         // node contains object data along with additional info
-        template<typename TPoolElement>
+        template<typename TPoolElement, int BlockSize>
         class object_pool_node
         {
         private:
-            using pool_node_t = object_pool_node<TPoolElement>;
+            using pool_node_t = object_pool_node<TPoolElement, BlockSize>;
+            using pool_chunk_t = object_pool_chunk<TPoolElement, BlockSize>;
             using data_storage_t = std::aligned_storage<sizeof(TPoolElement), alignof(TPoolElement)>;
             // raw data bytes
             using raw_data_t = typename data_storage_t::type;
-            raw_data_t mData;
 
         public:
             // initialize element
@@ -35,149 +39,90 @@ namespace cxx
                 TPoolElement* element = reinterpret_cast<TPoolElement*>(&mData);
                 element->~TPoolElement();
             }
+            inline TPoolElement* get_element()
+            {
+                return reinterpret_cast<TPoolElement*>(&mData);
+            }
         public:
-            // chain pointers, both null if node is in use
-            pool_node_t* mNextFreeNode;
-            pool_node_t* mPrevFreeNode;
+            // object data goes first so element address is node address
+            union
+            {
+                raw_data_t mData;
+                pool_node_t* mNextFreeNode; // free list chain, valid only if node is not in use
+            };
+            pool_chunk_t* mChunk; // owner chunk
         };
 
         // chunk contains fixed number of nodes
         template<typename TPoolElement, int BlockSize>
         class object_pool_chunk
         {
-            using pool_node_t = object_pool_node<TPoolElement>;
-            using pool_chunk_t = object_pool_chunk<TPoolElement, BlockSize>;
+            using pool_node_t = object_pool_node<TPoolElement, BlockSize>;
+
+        public:
+            static const int BitsPerWord = 64;
+            static const int WordsCount = (BlockSize + BitsPerWord - 1) / BitsPerWord;
 
         public:
             object_pool_chunk()
-                : mFreeNodesHead()
-                , mNextChunk()
             {
-                // init free nodes chain
-                for (int inode = 0; inode < BlockSize; ++inode)
+                for (pool_node_t& currNode: mNodes)
                 {
-                    mNodes[inode].mNextFreeNode = (inode < BlockSize - 1) ? &mNodes[inode + 1] : nullptr;
-                    mNodes[inode].mPrevFreeNode = (inode > 0) ? &mNodes[inode - 1] : nullptr;
+                    currNode.mChunk = this;
                 }
-                mFreeNodesHead = mNodes;
+                std::fill(std::begin(mUsedBits), std::end(mUsedBits), 0ULL);
             }
-            ~object_pool_chunk()
+            // get node index within chunk
+            inline int get_node_index(const pool_node_t* node) const
             {
-#ifdef _DEBUG
-                int numFreeNodes = 0;
-                for (pool_node_t* currentNode = mFreeNodesHead; currentNode; 
-                    currentNode = currentNode->mNextFreeNode)
-                {
-                    ++numFreeNodes;
-                }
-                cxx_assert(numFreeNodes == BlockSize);
-#endif
-                mFreeNodesHead = nullptr;
-                if (mNextChunk)
-                {
-                    delete mNextChunk;
-                }
+                return (int) (node - mNodes);
             }
-            // request free element from pool chunk
-            template<typename ... TArgs>
-            inline TPoolElement* allocate_object(TArgs&& ... args)
+            // test whether node is used
+            inline bool is_used_node(int nodeIndex) const
             {
-                if (mFreeNodesHead == nullptr)
-                {
-                    // allocate new chunk
-                    if (mNextChunk == nullptr)
-                    {
-                        mNextChunk = new pool_chunk_t();
-                    }
-
-                    TPoolElement* element = mNextChunk->allocate_object(std::forward<TArgs>(args)...);
-                    return element;
-                }
-
-                pool_node_t* node = mFreeNodesHead;
-                pop_from_free_nodes_list(node);
-
-                // initialize object
-                return node->construct(std::forward<TArgs>(args)...);
+                return (mUsedBits[nodeIndex / BitsPerWord] & (1ULL << (nodeIndex % BitsPerWord))) != 0;
             }
-            // return used element to pool chunk
-            inline void deallocate_object(TPoolElement* element)
+            inline void set_node_used(int nodeIndex, bool isUsed)
             {
-                cxx_assert(element);
-                pool_node_t* node = reinterpret_cast<pool_node_t*>(element);
-                if (node >= mNodes && node < mNodes + BlockSize)
+                unsigned long long nodeBit = (1ULL << (nodeIndex % BitsPerWord));
+                if (isUsed)
                 {
-                    bool isUsedNode = is_used_node(node);
-
-                    cxx_assert(isUsedNode);
-                    if (isUsedNode) // valid node
-                    {
-                        node->destruct();
-                        put_to_free_nodes_list(node);
-                    }
-                    return;
+                    mUsedBits[nodeIndex / BitsPerWord] |= nodeBit;
                 }
-
-                if (mNextChunk)
+                else
                 {
-                    mNextChunk->deallocate_object(element);
-                    return;
+                    mUsedBits[nodeIndex / BitsPerWord] &= ~nodeBit;
                 }
-                // invalid node
-                cxx_assert(false);
-            }
-        private:
-            // remove node from free list
-            inline void pop_from_free_nodes_list(pool_node_t* node)
-            {
-                cxx_assert(is_free_node(node));
-
-                if (node->mNextFreeNode)
-                    node->mNextFreeNode->mPrevFreeNode = node->mPrevFreeNode;
-
-                if (node->mPrevFreeNode)
-                    node->mPrevFreeNode->mNextFreeNode = node->mNextFreeNode;
-
-                if (node == mFreeNodesHead)
-                    mFreeNodesHead = node->mNextFreeNode;
-
-                node->mNextFreeNode = nullptr;
-                node->mPrevFreeNode = nullptr;
             }
-            // add node to free list
-            inline void put_to_free_nodes_list(pool_node_t* node)
+            // invoke function for each used node in address order
+            template<typename TFunc>
+            inline void for_each_used(TFunc&& func)
             {
-                cxx_assert(is_used_node(node));
-
-                node->mNextFreeNode = mFreeNodesHead;
-                if (mFreeNodesHead)
+                for (int iword = 0; iword < WordsCount; ++iword)
                 {
-                    mFreeNodesHead->mPrevFreeNode = node;
+                    unsigned long long usedBits = mUsedBits[iword];
+                    for (int inode = iword * BitsPerWord; usedBits; usedBits >>= 1, ++inode)
+                    {
+                        if (usedBits & 1ULL)
+                        {
+                            func(mNodes[inode].get_element());
+                        }
+                    }
                 }
-                mFreeNodesHead = node;
-            }
-            // test whether node is free
-            inline bool is_free_node(pool_node_t* node)
-            {
-                return node->mNextFreeNode || node->mPrevFreeNode || node == mFreeNodesHead;
             }
-            // test whether node is used
-            inline bool is_used_node(pool_node_t* node)
-            {
-                return !is_free_node(node);
-            }
-        private:
-            pool_chunk_t* mNextChunk;
-            pool_node_t* mFreeNodesHead;
+        public:
             pool_node_t mNodes[BlockSize];
+            unsigned long long mUsedBits[WordsCount]; // occupancy bitmap
         };
 
     } // namespace details
 
       // template objects pool class
+      // all chunks share single free list, node keeps its owner chunk so freeing does not depend on chunks count
     template<typename TPoolElement, int BlockSize = 1024>
     class object_pool
     {
+        using pool_node_t = details::object_pool_node<TPoolElement, BlockSize>;
         using pool_chunk_t = details::object_pool_chunk<TPoolElement, BlockSize>;
 
     public:
@@ -190,34 +135,120 @@ namespace cxx
         template<typename ... TArgs>
         inline TPoolElement* create(TArgs&& ... args)
         {
-            if (mFirstChunk == nullptr)
+            if (mFreeNodesHead == nullptr)
             {
-                mFirstChunk = new pool_chunk_t;
+                allocate_chunk();
             }
 
-            TPoolElement* poolElement = mFirstChunk->allocate_object(std::forward<TArgs>(args)...);
-            return poolElement;
+            pool_node_t* node = mFreeNodesHead;
+            mFreeNodesHead = node->mNextFreeNode;
+            node->mChunk->set_node_used(node->mChunk->get_node_index(node), true);
+            ++mObjectsCount;
+
+            // initialize object
+            return node->construct(std::forward<TArgs>(args)...);
         }
         // return object to pool
         inline void destroy(TPoolElement* element)
         {
-            cxx_assert(mFirstChunk);
-            if (mFirstChunk)
+            cxx_assert(element);
+            pool_node_t* node = reinterpret_cast<pool_node_t*>(element);
+#ifdef _DEBUG
+            // validate address before reading owner chunk from node
+            pool_chunk_t* ownerChunk = find_owner_chunk(node);
+            const bool isPoolNode = (ownerChunk != nullptr) && ownerChunk->is_used_node(ownerChunk->get_node_index(node));
+            cxx_assert(isPoolNode);
+            if (!isPoolNode)
+                return;
+
+            cxx_assert(node->mChunk == ownerChunk);
+#endif
+            pool_chunk_t* chunk = node->mChunk;
+
+            const int nodeIndex = chunk->get_node_index(node);
+            const bool isValidNode = (nodeIndex >= 0) && (nodeIndex < BlockSize) && chunk->is_used_node(nodeIndex);
+            cxx_assert(isValidNode);
+            if (!isValidNode)
+                return;
+
+            node->destruct();
+            chunk->set_node_used(nodeIndex, false);
+            node->mNextFreeNode = mFreeNodesHead;
+            mFreeNodesHead = node;
+            --mObjectsCount;
+        }
+        // invoke function for each live object, objects are visited in memory order
+        // objects must not be created or destroyed during iteration
+        template<typename TFunc>
+        inline void for_each(TFunc&& func)
+        {
+            for (pool_chunk_t* currChunk: mChunks)
             {
-                mFirstChunk->deallocate_object(element);
+                currChunk->for_each_used(func);
             }
         }
+        // get number of live objects
+        inline int get_objects_count() const
+        {
+            return mObjectsCount;
+        }
+        // get number of allocated chunks, each chunk is single heap allocation
+        inline int get_chunks_count() const
+        {
+            return (int) mChunks.size();
+        }
         // frees allocated memory but does not destruct objects inside pool - user must do it manually
         inline void cleanup()
         {
-            if (mFirstChunk)
+#ifdef _DEBUG
+            cxx_assert(mObjectsCount == 0);
+#endif
+            for (pool_chunk_t* currChunk: mChunks)
+            {
+                delete currChunk;
+            }
+            mChunks.clear();
+            mFreeNodesHead = nullptr;
+            mObjectsCount = 0;
+        }
+    private:
+#ifdef _DEBUG
+        // find chunk which nodes range contains address, slow
+        inline pool_chunk_t* find_owner_chunk(const pool_node_t* node) const
+        {
+            const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(node);
+            for (pool_chunk_t* currChunk: mChunks)
+            {
+                const std::uintptr_t nodesBegin = reinterpret_cast<std::uintptr_t>(std::begin(currChunk->mNodes));
+                const std::uintptr_t nodesEnd = reinterpret_cast<std::uintptr_t>(std::end(currChunk->mNodes));
+                if ((address >= nodesBegin) && (address < nodesEnd))
+                {
+                    // must point to node start
+                    if (((address - nodesBegin) % sizeof(pool_node_t)) != 0)
+                        return nullptr;
+
+                    return currChunk;
+                }
+            }
+            return nullptr;
+        }
+#endif
+        inline void allocate_chunk()
+        {
+            pool_chunk_t* chunk = new pool_chunk_t;
+            mChunks.push_back(chunk);
+
+            // chain nodes in address order so new objects are placed sequentially
+            for (int inode = BlockSize - 1; inode >= 0; --inode)
             {
-                delete mFirstChunk;
-                mFirstChunk = nullptr;
+                chunk->mNodes[inode].mNextFreeNode = mFreeNodesHead;
+                mFreeNodesHead = &chunk->mNodes[inode];
             }
         }
     private:
-        pool_chunk_t* mFirstChunk = nullptr;
+        std::vector<pool_chunk_t*> mChunks;
+        pool_node_t* mFreeNodesHead = nullptr;
+        int mObjectsCount = 0;
     };
 
 } // namespace cxx
\ No newline at end of file